@@ -35,12 +35,14 @@ if test "$PHP_ASYNC" != "no"; then
   
   async_source_files=" \
     php_async.c \
+    src/buffer.c \
     src/channel.c \
     src/console.c \
     src/context.c \
     src/deferred.c \
     src/dns.c \
     src/event.c \
+    src/fiber/pool.c \
     src/fiber/stack.c \
     src/filesystem.c \
     src/helper.c \
@@ -62,6 +64,7 @@ if test "$PHP_ASYNC" != "no"; then
     src/watcher/poll.c \
     src/watcher/signal.c \
     src/watcher/timer.c \
+    src/wheel.c \
     src/xp/unix.c \
     src/xp/socket.c \
     src/xp/tcp.c \
@@ -113,6 +116,11 @@ if test "$PHP_ASYNC" != "no"; then
     async_use_ucontext="yes"
   ])
   
+  AC_CHECK_FUNCS([mincore])
+  
+  # Batched UDP receive (UdpSocket::receiveBatch()).
+  AC_CHECK_FUNCS([recvmmsg])
+  
   if test "$async_cpu" = 'x86_64'; then
     if test "$async_os" = 'LINUX'; then
       async_asm_file="x86_64_sysv_elf_gas.S"
@@ -158,6 +166,7 @@ if test "$PHP_ASYNC" != "no"; then
       AC_MSG_CHECKING(for SSL support)
       AC_MSG_RESULT(yes)
       AC_DEFINE(HAVE_ASYNC_SSL, 1, [ ])
+      AC_CHECK_HEADERS([linux/tls.h])
     ], [
       AC_MSG_CHECKING(for SSL support)
       AC_MSG_RESULT(no)
@@ -0,0 +1,64 @@
+<?php
+
+// Measures ChannelGroup::select() throughput with a large fan-in of channels.
+// Usage: php channel-select.php [channels] [messages] [capacity]
+
+namespace Concurrent;
+
+$count = (int) ($argv[1] ?? 10000);
+$messages = (int) ($argv[2] ?? 1000000);
+$capacity = (int) ($argv[3] ?? 0);
+
+$channels = [];
+
+for ($i = 0; $i < $count; $i++) {
+    $channels[] = new Channel($capacity);
+}
+
+$start = microtime(true);
+$group = new ChannelGroup($channels);
+
+printf("Channels:    %d (capacity %d)\n", $count, $capacity);
+printf("Group setup: %.3f ms\n", (microtime(true) - $start) * 1000);
+
+// Producers send to channels in a scattered order to avoid favoring the first channels of the group.
+$producer = function (int $offset, int $step) use ($channels, $count, $messages) {
+    for ($i = $offset; $i < $messages; $i += $step) {
+        $channels[($i * 7919) % $count]->send($i);
+    }
+};
+
+$start = microtime(true);
+
+$tasks = [];
+
+for ($i = 0; $i < 4; $i++) {
+    $tasks[] = Task::async($producer, $i, 4);
+}
+
+for ($i = 0; $i < $messages; $i++) {
+    $group->select();
+}
+
+$time = microtime(true) - $start;
+
+foreach ($tasks as $task) {
+    Task::await($task);
+}
+
+printf("Messages:    %d\n", $messages);
+printf("Time:        %.3f s\n", $time);
+printf("Throughput:  %.0f selects/s\n", $messages / $time);
+
+$start = microtime(true);
+
+foreach ($channels as $channel) {
+    $channel->close();
+}
+
+while (count($group)) {
+    $group->select(0);
+}
+
+printf("Teardown:    %.3f ms\n", (microtime(true) - $start) * 1000);
+printf("Memory peak: %.2f MB\n", memory_get_peak_usage() / 1024 / 1024);
@@ -0,0 +1,83 @@
+<?php
+
+// Measures producer / consumer throughput of single message and batched channel operations.
+// Usage: php channel-throughput.php [count] [capacity] [batch]
+
+namespace Concurrent;
+
+$count = (int) ($argv[1] ?? 1000000);
+$capacity = (int) ($argv[2] ?? 1024);
+$batch = (int) ($argv[3] ?? 256);
+
+function measure(string $label, int $count, int $capacity, callable $producer, callable $consumer)
+{
+    $channel = new Channel($capacity);
+
+    $start = microtime(true);
+
+    $task = Task::async(function () use ($channel, $producer) {
+        try {
+            $producer($channel);
+        } finally {
+            $channel->close();
+        }
+    });
+
+    $received = $consumer($channel);
+
+    Task::await($task);
+
+    $time = microtime(true) - $start;
+
+    if ($received != $count) {
+        throw new \RuntimeException(sprintf('Received %d messages, expected %d', $received, $count));
+    }
+
+    printf("%-20s %8.3f s %12.0f msg/s\n", $label, $time, $count / $time);
+}
+
+printf("Messages: %d, capacity: %d, batch: %d\n\n", $count, $capacity, $batch);
+
+measure('send / foreach', $count, $capacity, function (Channel $channel) use ($count) {
+    for ($i = 0; $i < $count; $i++) {
+        $channel->send($i);
+    }
+}, function (Channel $channel) {
+    $received = 0;
+
+    foreach ($channel as $v) {
+        $received++;
+    }
+
+    return $received;
+});
+
+measure('sendMany / foreach', $count, $capacity, function (Channel $channel) use ($count, $batch) {
+    for ($i = 0; $i < $count; $i += $batch) {
+        $channel->sendMany(range($i, min($count, $i + $batch) - 1));
+    }
+}, function (Channel $channel) {
+    $received = 0;
+
+    foreach ($channel as $v) {
+        $received++;
+    }
+
+    return $received;
+});
+
+measure('sendMany / receiveMany', $count, $capacity, function (Channel $channel) use ($count, $batch) {
+    for ($i = 0; $i < $count; $i += $batch) {
+        $channel->sendMany(range($i, min($count, $i + $batch) - 1));
+    }
+}, function (Channel $channel) use ($batch) {
+    $received = 0;
+
+    while ($messages = $channel->receiveMany($batch)) {
+        $received += \count($messages);
+    }
+
+    return $received;
+});
+
+printf("\nMemory peak: %.2f MB\n", memory_get_peak_usage() / 1024 / 1024);
@@ -0,0 +1,65 @@
+<?php
+
+// Measures timer latency while a burst of ready tasks is being dispatched.
+// Usage: php -d async.dispatch_budget=256 -d async.dispatch_stats=1 dispatch-latency.php [count] [work]
+
+namespace Concurrent;
+
+$count = (int) ($argv[1] ?? 100000);
+$work = (int) ($argv[2] ?? 100);
+
+$done = false;
+$delays = [];
+
+$ticker = Task::async(function () use (&$done, &$delays) {
+    $timer = new Timer(1);
+
+    while (!$done) {
+        $start = hrtime(true);
+        $timer->awaitTimeout();
+        $delays[] = (hrtime(true) - $start) / 1000000 - 1;
+    }
+});
+
+$job = function () use ($work) {
+    for ($i = 0, $x = 0; $i < $work; $i++) {
+        $x += $i;
+    }
+};
+
+$start = microtime(true);
+$tasks = [];
+
+for ($i = 0; $i < $count; $i++) {
+    $tasks[] = Task::async($job);
+}
+
+foreach ($tasks as $task) {
+    Task::await($task);
+}
+
+$time = microtime(true) - $start;
+$done = true;
+
+Task::await($ticker);
+
+sort($delays);
+
+$percentile = function (float $p) use ($delays): float {
+    return $delays ? $delays[(int) min(count($delays) - 1, floor(count($delays) * $p))] : 0;
+};
+
+$stats = TaskScheduler::getStats()['dispatch'];
+
+printf("Tasks:       %d\n", $count);
+printf("Budget:      %d tasks / %d us\n", $stats['budget'], $stats['budget_time']);
+printf("Time:        %.3f s\n", $time);
+printf("Timer ticks: %d\n", count($delays));
+printf("Timer delay: p50 %.3f ms / p99 %.3f ms / max %.3f ms\n", $percentile(.5), $percentile(.99), $percentile(1));
+printf("Ready queue: max %d tasks, %d batches cut short\n", $stats['max_ready'], $stats['exhausted']);
+
+if ($stats['tracked']) {
+    foreach ($stats['wait_histogram'] as $label => $num) {
+        printf("  <= %-6s %d\n", $label, $num);
+    }
+}
@@ -0,0 +1,71 @@
+<?php
+
+// Measures start latency of high priority tasks while the scheduler is saturated with low priority tasks.
+// Usage: php -d async.dispatch_budget=64 task-priority.php [workers] [samples] [priority: high|normal]
+
+namespace Concurrent;
+
+$workers = (int) ($argv[1] ?? 1000);
+$samples = (int) ($argv[2] ?? 1000);
+$priority = (($argv[3] ?? 'high') == 'high') ? Task::PRIORITY_HIGH : Task::PRIORITY_NORMAL;
+
+$done = false;
+$delays = [];
+$jobs = 0;
+
+$low = Context::current()->withPriority(Task::PRIORITY_LOW);
+$context = Context::current()->withPriority($priority);
+
+// Each low priority job spawns its successor (inheriting low priority) to keep the ready queue saturated.
+$job = function () use (&$job, &$done, &$jobs) {
+    for ($i = 0, $x = 0; $i < 100; $i++) {
+        $x += $i;
+    }
+
+    $jobs++;
+
+    if (!$done) {
+        Task::async($job);
+    }
+};
+
+for ($i = 0; $i < $workers; $i++) {
+    Task::asyncWithContext($low, $job);
+}
+
+$start = microtime(true);
+
+$probe = Task::asyncWithContext($context, function () use ($samples, &$delays) {
+    $timer = new Timer(1);
+
+    for ($i = 0; $i < $samples; $i++) {
+        $timer->awaitTimeout();
+
+        $time = hrtime(true);
+
+        // Awaiting the task would run it inline, the task records the time it has been waiting in the ready queue instead.
+        Task::async(function () use ($time, &$delays) {
+            $delays[] = (hrtime(true) - $time) / 1000;
+        });
+    }
+});
+
+Task::await($probe);
+
+$time = microtime(true) - $start;
+$done = true;
+
+sort($delays);
+
+$percentile = function (float $p) use ($delays): float {
+    return $delays[(int) min(count($delays) - 1, floor(count($delays) * $p))];
+};
+
+$stats = TaskScheduler::getStats()['dispatch'];
+
+printf("Workers:     %d low priority tasks\n", $workers);
+printf("Probe:       %s priority\n", ($priority == Task::PRIORITY_HIGH) ? 'high' : 'normal');
+printf("Time:        %.3f s\n", $time);
+printf("Background:  %.0f jobs/s\n", $jobs / $time);
+printf("Latency:     p50 %.1f us / p99 %.1f us / max %.1f us\n", $percentile(.5), $percentile(.99), $percentile(1));
+printf("Aged:        %d dispatches\n", $stats['aged']);
@@ -0,0 +1,44 @@
+<?php
+
+// Measures the cost of spawning, running and awaiting no-op tasks.
+// Usage: php task-spawn.php [count] [batch]
+
+namespace Concurrent;
+
+$count = (int) ($argv[1] ?? 1000000);
+$batch = (int) ($argv[2] ?? 1000);
+
+$noop = function () {};
+
+$start = microtime(true);
+
+for ($i = 0; $i < $count; $i += $batch) {
+    $tasks = [];
+
+    for ($j = 0; $j < $batch; $j++) {
+        $tasks[] = Task::async($noop);
+    }
+
+    // Awaiting a task that has not been started would run it inline, wait until the batch has been dispatched instead.
+    $defer = new Deferred();
+
+    Task::async(function () use ($defer) {
+        $defer->resolve();
+    });
+
+    Task::await($defer->awaitable());
+
+    foreach ($tasks as $task) {
+        Task::await($task);
+    }
+}
+
+$time = microtime(true) - $start;
+$stats = TaskScheduler::getStats()['fiber_pool'];
+
+printf("Tasks:       %d\n", $count);
+printf("Time:        %.3f s\n", $time);
+printf("Throughput:  %.0f tasks/s\n", $count / $time);
+printf("Spawn cost:  %.3f us/task\n", $time / $count * 1000000);
+printf("Memory peak: %.2f MB\n", memory_get_peak_usage() / 1024 / 1024);
+printf("Fiber pool:  %d hits / %d misses (%.2f%% hit rate)\n", $stats['hits'], $stats['misses'], 100 * $stats['hits'] / max(1, $stats['hits'] + $stats['misses']));
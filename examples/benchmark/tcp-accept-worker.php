@@ -0,0 +1,67 @@
+<?php
+
+// Worker of tcp-accept.php, accepts connections until it is asked to stop and reports the number of accepted connections.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\Thread;
+
+function receive(Pipe $ipc): string
+{
+    $buffer = '';
+    
+    while (false === strpos($buffer, "\n")) {
+        if (null === ($chunk = $ipc->read())) {
+            throw new \RuntimeException('IPC pipe has been closed');
+        }
+        
+        $buffer .= $chunk;
+    }
+    
+    return trim($buffer);
+}
+
+$ipc = Thread::connect();
+
+try {
+    list ($mode, $port, $backlog) = explode(':', receive($ipc));
+    
+    if ($mode == 'export') {
+        $ipc->write("import\n");
+        
+        $server = TcpServer::import($ipc, null, (int) $backlog);
+        $server->setOption(TcpServer::SIMULTANEOUS_ACCEPTS, false);
+    } else {
+        $server = TcpServer::bind('127.0.0.1', (int) $port, null, true, (int) $backlog);
+    }
+    
+    $count = 0;
+    
+    $task = Task::async(function () use ($server, & $count) {
+        try {
+            while (true) {
+                $server->accept()->close();
+                
+                $count++;
+            }
+        } catch (SocketException $e) {
+            // Server has been closed.
+        }
+    });
+    
+    // Lazy servers start listening when accept() is called for the first time.
+    Task::async(function () use ($ipc) {
+        $ipc->write("ready\n");
+    });
+    
+    receive($ipc);
+    
+    $server->close();
+    
+    Task::await($task);
+    
+    $ipc->write($count . "\n");
+} finally {
+    $ipc->close();
+}
@@ -0,0 +1,116 @@
+<?php
+
+// Measures accepted TCP connections per second as the number of accepting threads grows.
+// Usage: php tcp-accept.php [threads] [seconds] [clients] [mode] [backlog]
+// Mode "reuseport" (default) binds a separate SO_REUSEPORT server in every thread, mode "export" shares a single server
+// socket with all threads using TcpServer::export() / import(). Clients run on the main thread, use a separate load
+// generator if the main thread becomes the bottleneck.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\Thread;
+
+$threads = (int) ($argv[1] ?? 4);
+$seconds = (float) ($argv[2] ?? 2);
+$clients = (int) ($argv[3] ?? 64);
+$mode = $argv[4] ?? 'reuseport';
+$backlog = (int) ($argv[5] ?? 1024);
+
+function receive(Pipe $ipc): string
+{
+    $buffer = '';
+    
+    while (false === strpos($buffer, "\n")) {
+        if (null === ($chunk = $ipc->read())) {
+            throw new \RuntimeException('IPC pipe has been closed');
+        }
+        
+        $buffer .= $chunk;
+    }
+    
+    return trim($buffer);
+}
+
+function run(int $threads, float $seconds, int $clients, string $mode, int $backlog): array
+{
+    // Reserves the port, a bound socket that does not listen does not receive any connections.
+    $server = TcpServer::bind('127.0.0.1', 0, null, $mode != 'export', $backlog);
+    $port = $server->getPort();
+    
+    $workers = [];
+    
+    try {
+        for ($i = 0; $i < $threads; $i++) {
+            $thread = new Thread(__DIR__ . '/tcp-accept-worker.php');
+            $ipc = $thread->getIpc();
+            
+            $ipc->write(sprintf("%s:%d:%d\n", $mode, $port, $backlog));
+            
+            if ($mode == 'export') {
+                receive($ipc);
+                
+                $server->export($ipc);
+            }
+            
+            receive($ipc);
+            
+            $workers[] = [$thread, $ipc];
+        }
+        
+        $connected = 0;
+        $start = microtime(true);
+        $deadline = $start + $seconds;
+        
+        $tasks = [];
+        
+        for ($i = 0; $i < $clients; $i++) {
+            $tasks[] = Task::async(function () use ($port, $deadline, & $connected) {
+                while (microtime(true) < $deadline) {
+                    TcpSocket::connect('127.0.0.1', $port)->close();
+                    
+                    $connected++;
+                }
+            });
+        }
+        
+        foreach ($tasks as $task) {
+            Task::await($task);
+        }
+        
+        $elapsed = microtime(true) - $start;
+        $accepted = 0;
+        
+        foreach ($workers as list ($thread, $ipc)) {
+            $ipc->write("stop\n");
+            
+            $accepted += (int) receive($ipc);
+        }
+    } finally {
+        foreach ($workers as list ($thread, $ipc)) {
+            $ipc->close();
+            $thread->join();
+        }
+        
+        $server->close();
+    }
+    
+    return [$connected, $accepted, $elapsed];
+}
+
+printf("Mode: %s, backlog: %d, clients: %d\n\n", $mode, $backlog, $clients);
+printf("%-8s %12s %12s\n", 'Threads', 'Accepted', 'Conn/s');
+
+$counts = [];
+
+for ($i = 1; $i < $threads; $i *= 2) {
+    $counts[] = $i;
+}
+
+$counts[] = $threads;
+
+foreach ($counts as $count) {
+    list ($connected, $accepted, $elapsed) = run($count, $seconds, $clients, $mode, $backlog);
+    
+    printf("%-8d %12d %12.0f\n", $count, $accepted, $accepted / $elapsed);
+}
@@ -0,0 +1,53 @@
+<?php
+
+// Measures read throughput over a connected TCP socket pair.
+// Usage: php tcp-read.php [megabytes] [read length]
+// Compare the direct read path (default) with the ring buffer path using -d async.direct_read=0.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+$size = (int) ($argv[1] ?? 1024) * 1024 * 1024;
+$len = (int) ($argv[2] ?? 65536);
+
+list ($a, $b) = TcpSocket::pair();
+
+Task::async(function (TcpSocket $socket) use ($size) {
+    $chunk = str_repeat('A', 1024 * 1024);
+
+    try {
+        for ($sent = 0; $sent < $size; $sent += strlen($chunk)) {
+            $socket->write($chunk);
+        }
+    } finally {
+        $socket->close();
+    }
+}, $a);
+
+$usage = getrusage();
+$start = hrtime(true);
+$received = 0;
+$reads = 0;
+
+try {
+    while (null !== ($chunk = $b->read($len))) {
+        $received += strlen($chunk);
+        $reads++;
+    }
+} finally {
+    $b->close();
+}
+
+$time = (hrtime(true) - $start) / 1000000000;
+$end = getrusage();
+
+$cpu = ($end['ru_utime.tv_sec'] - $usage['ru_utime.tv_sec']) + ($end['ru_utime.tv_usec'] - $usage['ru_utime.tv_usec']) / 1000000;
+$cpu += ($end['ru_stime.tv_sec'] - $usage['ru_stime.tv_sec']) + ($end['ru_stime.tv_usec'] - $usage['ru_stime.tv_usec']) / 1000000;
+
+printf("Read path:   %s\n", (ini_get('async.direct_read') > 0 && $len >= ini_get('async.direct_read')) ? 'direct' : 'ring buffer');
+printf("Received:    %.2f MB in %d reads\n", $received / 1024 / 1024, $reads);
+printf("Time:        %.3f s\n", $time);
+printf("Throughput:  %.2f MB/s\n", $received / 1024 / 1024 / $time);
+printf("CPU:         %.3f s (%.3f ns/byte)\n", $cpu, $cpu / max(1, $received) * 1000000000);
+printf("Memory peak: %.2f MB\n", memory_get_peak_usage() / 1024 / 1024);
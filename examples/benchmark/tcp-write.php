@@ -0,0 +1,62 @@
+<?php
+
+// Measures throughput and latency of small writes over a connected TCP socket pair.
+// Usage: php tcp-write.php [frames] [frame size] [batch]
+// A batch size of 1 issues one write() per frame, larger batches use writeAll().
+// Run with strace -c -f to compare the number of write syscalls per MB.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+$count = (int) ($argv[1] ?? 200000);
+$size = (int) ($argv[2] ?? 64);
+$batch = max(1, (int) ($argv[3] ?? 16));
+
+list ($a, $b) = TcpSocket::pair();
+
+$reader = Task::async(function (TcpSocket $socket) {
+    $received = 0;
+
+    try {
+        while (null !== ($chunk = $socket->read())) {
+            $received += strlen($chunk);
+        }
+    } finally {
+        $socket->close();
+    }
+
+    return $received;
+}, $b);
+
+$frame = str_repeat('F', $size);
+$delays = [];
+
+$start = hrtime(true);
+
+try {
+    for ($i = 0; $i < $count; $i += $batch) {
+        $time = hrtime(true);
+
+        if ($batch == 1) {
+            $a->write($frame);
+        } else {
+            $a->writeAll(array_fill(0, min($batch, $count - $i), $frame));
+        }
+
+        $delays[] = (hrtime(true) - $time) / 1000;
+    }
+} finally {
+    $a->close();
+}
+
+$received = Task::await($reader);
+$time = (hrtime(true) - $start) / 1000000000;
+
+sort($delays);
+
+printf("Frames:      %d x %d bytes (batch %d)\n", $count, $size, $batch);
+printf("Received:    %.2f MB\n", $received / 1024 / 1024);
+printf("Time:        %.3f s\n", $time);
+printf("Throughput:  %.2f MB/s / %.0f frames/s\n", $received / 1024 / 1024 / $time, $count / $time);
+printf("Latency:     p50 %.1f us / p99 %.1f us per write call\n", $delays[(int) (count($delays) * .5)], $delays[(int) (count($delays) * .99)]);
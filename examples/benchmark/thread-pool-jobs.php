@@ -0,0 +1,8 @@
+<?php
+
+namespace Concurrent;
+
+function fib(int $n): int
+{
+    return ($n < 2) ? $n : fib($n - 1) + fib($n - 2);
+}
@@ -0,0 +1,45 @@
+<?php
+
+// Compares CPU-bound fan-out on the main thread with a thread pool.
+// Usage: php thread-pool.php [jobs] [threads] [n]
+
+namespace Concurrent;
+
+require __DIR__ . '/thread-pool-jobs.php';
+
+$jobs = (int) ($argv[1] ?? 64);
+$threads = isset($argv[2]) ? (int) $argv[2] : null;
+$n = (int) ($argv[3] ?? 25);
+
+$start = microtime(true);
+
+for ($i = 0; $i < $jobs; $i++) {
+    fib($n);
+}
+
+$serial = microtime(true) - $start;
+
+$pool = new ThreadPool(__DIR__ . '/thread-pool-jobs.php', $threads);
+
+try {
+    $start = microtime(true);
+    $tasks = [];
+
+    for ($i = 0; $i < $jobs; $i++) {
+        $tasks[] = Task::async([$pool, 'submit'], 'Concurrent\fib', $n);
+    }
+
+    foreach ($tasks as $task) {
+        Task::await($task);
+    }
+
+    $parallel = microtime(true) - $start;
+} finally {
+    $pool->close();
+}
+
+printf("Jobs:      %d x fib(%d)\n", $jobs, $n);
+printf("Threads:   %d\n", $pool->getSize());
+printf("Serial:    %.3f s\n", $serial);
+printf("Pool:      %.3f s\n", $parallel);
+printf("Speedup:   %.2fx\n", $serial / $parallel);
@@ -0,0 +1,62 @@
+<?php
+
+// Measures the rate of TLS client connections to a local server.
+// Usage: php tls-connect.php [connections]
+// Client contexts are shared by all connections, check context_hits / context_misses in the stats output.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$count = (int) ($argv[1] ?? 1000);
+
+$file = dirname(__DIR__) . '/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+Task::async(function () use ($server, $count) {
+    try {
+        for ($i = 0; $i < $count; $i++) {
+            $socket = $server->accept();
+            
+            try {
+                $socket->encrypt();
+                $socket->write('A');
+            } finally {
+                $socket->close();
+            }
+        }
+    } finally {
+        $server->close();
+    }
+});
+
+$tls = new TlsClientEncryption();
+$tls = $tls->withPeerName('localhost');
+$tls = $tls->withAllowSelfSigned(true);
+
+$start = hrtime(true);
+
+for ($i = 0; $i < $count; $i++) {
+    $socket = TcpSocket::connect($server->getAddress(), $server->getPort(), $tls);
+    
+    try {
+        $socket->encrypt();
+        $socket->read();
+    } finally {
+        $socket->close();
+    }
+}
+
+$time = (hrtime(true) - $start) / 1000000000;
+$stats = TaskScheduler::getStats()['tls'];
+
+printf("Connections:  %d\n", $count);
+printf("Time:         %.3f s\n", $time);
+printf("Connect rate: %.2f connections/s\n", $count / $time);
+printf("Contexts:     %d (%d hits, %d misses)\n", $stats['contexts'], $stats['context_hits'], $stats['context_misses']);
+printf("Sessions:     %d hits, %d misses\n", $stats['client_hits'], $stats['client_misses']);
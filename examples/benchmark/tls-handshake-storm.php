@@ -0,0 +1,119 @@
+<?php
+
+// Measures round-trip latency of an established connection while many TLS handshakes are being performed.
+// Usage: php tls-handshake-storm.php [handshakes] [concurrency]
+// Compare inline handshakes (default) with handshakes offloaded to the thread pool using -d async.tls_offload=1.
+// Clients use the async-tls stream wrapper, it does not resume sessions so every connection performs a full handshake.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$count = (int) ($argv[1] ?? 1000);
+$concurrency = (int) ($argv[2] ?? 32);
+
+$file = dirname(__DIR__) . '/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+Task::async(function () use ($server) {
+    try {
+        while (true) {
+            Task::async(function (TcpSocket $socket) {
+                try {
+                    $socket->encrypt();
+                    $socket->write('A');
+                } catch (\Throwable $e) {
+                    // Ignore failed handshakes.
+                } finally {
+                    $socket->close();
+                }
+            }, $server->accept());
+        }
+    } catch (SocketException $e) {
+        // Server has been closed.
+    }
+});
+
+list ($a, $b) = TcpSocket::pair();
+
+Task::async(function (TcpSocket $socket) {
+    try {
+        while (null !== ($chunk = $socket->read())) {
+            $socket->write($chunk);
+        }
+    } finally {
+        $socket->close();
+    }
+}, $b);
+
+$done = false;
+
+$probe = Task::async(function (TcpSocket $socket) use (& $done) {
+    $samples = [];
+    
+    try {
+        while (!$done) {
+            $start = hrtime(true);
+            
+            $socket->write('P');
+            $socket->read();
+            
+            $samples[] = hrtime(true) - $start;
+        }
+    } finally {
+        $socket->close();
+    }
+    
+    return $samples;
+}, $a);
+
+$context = stream_context_create([
+    'ssl' => [
+        'peer_name' => 'localhost',
+        'allow_self_signed' => true
+    ]
+]);
+
+$url = sprintf('async-tls://%s:%u', $server->getAddress(), $server->getPort());
+$start = hrtime(true);
+$workers = [];
+
+for ($i = 0; $i < $concurrency; $i++) {
+    $workers[] = Task::async(function (int $n) use ($url, $context) {
+        for ($i = 0; $i < $n; $i++) {
+            $socket = stream_socket_client($url, $errno, $errstr, 10, STREAM_CLIENT_CONNECT, $context);
+            
+            fread($socket, 1);
+            fclose($socket);
+        }
+    }, intdiv($count, $concurrency) + (($i < $count % $concurrency) ? 1 : 0));
+}
+
+foreach ($workers as $worker) {
+    Task::await($worker);
+}
+
+$time = (hrtime(true) - $start) / 1000000000;
+$done = true;
+
+$samples = Task::await($probe);
+$server->close();
+
+sort($samples);
+
+$percentile = function (float $p) use ($samples): float {
+    return $samples[min(count($samples) - 1, (int) floor(count($samples) * $p))] / 1000;
+};
+
+printf("Offload:     %s\n", ini_get('async.tls_offload') ? 'enabled' : 'disabled');
+printf("Handshakes:  %d in %.3f s (%.2f/s)\n", $count, $time, $count / $time);
+printf("Offloaded:   %d steps\n", TaskScheduler::getStats()['tls']['offloaded']);
+printf("Round trips: %d\n", count($samples));
+printf("Latency p50: %.1f us\n", $percentile(.5));
+printf("Latency p99: %.1f us\n", $percentile(.99));
+printf("Latency max: %.1f us\n", $percentile(1));
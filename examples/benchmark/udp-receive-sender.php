@@ -0,0 +1,61 @@
+<?php
+
+// Sender of udp-receive.php, sends datagrams until it is asked to stop and reports the number of sent datagrams.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\Thread;
+use Concurrent\Timer;
+
+function receive(Pipe $ipc): string
+{
+    $buffer = '';
+    
+    while (false === strpos($buffer, "\n")) {
+        if (null === ($chunk = $ipc->read())) {
+            throw new \RuntimeException('IPC pipe has been closed');
+        }
+        
+        $buffer .= $chunk;
+    }
+    
+    return trim($buffer);
+}
+
+$ipc = Thread::connect();
+
+try {
+    list ($port, $size) = explode(':', receive($ipc));
+    
+    $socket = UdpSocket::bind('127.0.0.1', 0);
+    $datagram = new UdpDatagram(str_repeat('x', (int) $size), '127.0.0.1', (int) $port);
+    
+    $stop = false;
+    $sent = 0;
+    
+    Task::async(function () use ($ipc, & $stop) {
+        receive($ipc);
+        
+        $stop = true;
+    });
+    
+    // Yields to the event loop between bursts so that the stop message can be received.
+    $tick = new Timer(0);
+    
+    while (!$stop) {
+        for ($i = 0; $i < 256; $i++) {
+            $socket->send($datagram);
+        }
+        
+        $sent += 256;
+        
+        $tick->awaitTimeout();
+    }
+    
+    $socket->close();
+    
+    $ipc->write($sent . "\n");
+} finally {
+    $ipc->close();
+}
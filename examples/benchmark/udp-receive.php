@@ -0,0 +1,84 @@
+<?php
+
+// Measures received UDP datagrams per second over loopback, a sender thread sends datagrams as fast as possible.
+// Usage: php udp-receive.php [mode] [seconds] [size] [batch]
+// Mode "batch" (default) uses UdpSocket::receiveBatch(), mode "single" calls UdpSocket::receive() once per datagram.
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\Thread;
+use Concurrent\Timer;
+use Concurrent\Stream\StreamClosedException;
+
+$mode = $argv[1] ?? 'batch';
+$seconds = (float) ($argv[2] ?? 2);
+$size = (int) ($argv[3] ?? 64);
+$batch = (int) ($argv[4] ?? 64);
+
+function receive(Pipe $ipc): string
+{
+    $buffer = '';
+    
+    while (false === strpos($buffer, "\n")) {
+        if (null === ($chunk = $ipc->read())) {
+            throw new \RuntimeException('IPC pipe has been closed');
+        }
+        
+        $buffer .= $chunk;
+    }
+    
+    return trim($buffer);
+}
+
+$socket = UdpSocket::bind('127.0.0.1', 0);
+
+$thread = new Thread(__DIR__ . '/udp-receive-sender.php');
+$ipc = $thread->getIpc();
+
+$ipc->write(sprintf("%d:%d\n", $socket->getPort(), $size));
+
+// Closing the socket fails the pending receive operation and ends the benchmark.
+Task::async(function () use ($socket, $seconds) {
+    (new Timer((int) ($seconds * 1000)))->awaitTimeout();
+    
+    $socket->close();
+});
+
+$received = 0;
+$resumes = 0;
+$start = microtime(true);
+
+try {
+    if ($mode == 'single') {
+        while (true) {
+            $socket->receive();
+            
+            $received++;
+            $resumes++;
+        }
+    } else {
+        while (true) {
+            $received += count($socket->receiveBatch($batch));
+            
+            $resumes++;
+        }
+    }
+} catch (StreamClosedException $e) {
+    // Benchmark time is up.
+}
+
+$elapsed = microtime(true) - $start;
+
+$ipc->write("stop\n");
+$sent = (int) receive($ipc);
+
+$ipc->close();
+$thread->join();
+
+printf("Mode:     %s (batch size %d)\n", $mode, ($mode == 'single') ? 1 : $batch);
+printf("Payload:  %d bytes\n", $size);
+printf("Sent:     %d datagrams\n", $sent);
+printf("Received: %d datagrams (%.1f%%)\n", $received, $sent ? ($received / $sent * 100) : 0);
+printf("Resumes:  %d (%.1f datagrams per resume)\n", $resumes, $resumes ? ($received / $resumes) : 0);
+printf("Rate:     %.0f pps\n", $received / $elapsed);
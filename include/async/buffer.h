@@ -19,6 +19,11 @@
 #ifndef ASYNC_BUFFER_H
 #define ASYNC_BUFFER_H
 
+size_t async_buffer_pool_size(size_t size);
+char *async_buffer_pool_acquire(async_buffer_pool *pool, size_t size);
+void async_buffer_pool_release(async_buffer_pool *pool, char *base, size_t size);
+void async_buffer_pool_dispose(async_buffer_pool *pool);
+
 typedef struct _async_ring_buffer {
 	/* Base pointer being used to allocate and free buffer memory. */
 	char *base;
@@ -129,6 +134,24 @@ static zend_always_inline void async_ring_buffer_write_move(async_ring_buffer *b
 	buffer->len += offset;
 }
 
+/* Moves buffered bytes to the start of the given memory, the previous buffer memory is not freed. */
+static zend_always_inline void async_ring_buffer_move(async_ring_buffer *buffer, char *base, size_t size)
+{
+	size_t len;
+	
+	ZEND_ASSERT(size >= buffer->len);
+	
+	len = buffer->len;
+	
+	async_ring_buffer_read(buffer, base, len);
+	
+	buffer->base = base;
+	buffer->rpos = base;
+	buffer->wpos = base + (len % size);
+	buffer->size = size;
+	buffer->len = len;
+}
+
 static zend_always_inline void async_ring_buffer_consume(async_ring_buffer *buffer, size_t len)
 {
 	ZEND_ASSERT(len > 0);
@@ -21,6 +21,8 @@
 
 #define ASYNC_FIBER_VM_STACK_SIZE 4096
 
+#define ASYNC_FIBER_DEFAULT_STACK_SIZE (4096 * (((sizeof(void *)) < 8) ? 16 : 128))
+
 #ifdef PHP_WIN32
 #define ASYNC_FIBER_CALLBACK static VOID __stdcall
 typedef LPFIBER_START_ROUTINE async_fiber_cb;
@@ -60,8 +62,22 @@ const char *async_fiber_backend_info();
 async_fiber *async_fiber_create_root();
 async_fiber *async_fiber_create();
 zend_bool async_fiber_init(async_fiber *fiber, async_context *context, async_fiber_cb func, void *arg, size_t stack_size);
+zend_bool async_fiber_reset(async_fiber *fiber, int trim);
+size_t async_fiber_stack_usage(async_fiber *fiber);
 void async_fiber_destroy(async_fiber *fiber);
 
+async_fiber *async_fiber_pool_acquire(async_fiber_pool *pool);
+void async_fiber_pool_release(async_fiber_pool *pool, async_fiber *fiber);
+void async_fiber_pool_dispose(async_fiber_pool *pool);
+
+zend_vm_stack async_fiber_pool_acquire_vm_stack(async_fiber_pool *pool);
+void async_fiber_pool_release_vm_stack(async_fiber_pool *pool, zend_vm_stack stack);
+
+static zend_always_inline async_fiber_pool *async_fiber_pool_get(async_task_scheduler *scheduler)
+{
+	return ASYNC_G(fiber_pool_shared) ? &ASYNC_G(fiber_pool) : &scheduler->pool;
+}
+
 void async_fiber_suspend(async_task_scheduler *scheduler);
 void async_fiber_switch(async_task_scheduler *scheduler, async_fiber *to, async_fiber_suspend_type suspend);
 
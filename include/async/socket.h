@@ -41,7 +41,7 @@ static zend_always_inline int async_socket_set_port(struct sockaddr *addr, zend_
 	}
 	
 #ifdef HAVE_IPV6
-	if (addr->sa_family == AF_INET) {
+	if (addr->sa_family == AF_INET6) {
 		((struct sockaddr_in6 *) addr)->sin6_port = htons((uint16_t) port);
 		
 		return SUCCESS;
@@ -51,6 +51,21 @@ static zend_always_inline int async_socket_set_port(struct sockaddr *addr, zend_
 	return FAILURE;
 }
 
+static zend_always_inline uint16_t async_socket_get_addr_port(const struct sockaddr *addr)
+{
+	if (addr->sa_family == AF_INET) {
+		return (uint16_t) ntohs(((struct sockaddr_in *) addr)->sin_port);
+	}
+	
+#ifdef HAVE_IPV6
+	if (addr->sa_family == AF_INET6) {
+		return (uint16_t) ntohs(((struct sockaddr_in6 *) addr)->sin6_port);
+	}
+#endif
+
+	return 0;
+}
+
 static zend_always_inline int async_socket_get_peer(const struct sockaddr *addr, zend_string **ip, uint16_t *port)
 {
 	char buf[64];
@@ -148,6 +163,36 @@ static zend_always_inline int async_socket_get_remote_peer(php_socket_t sock, ze
 	return FAILURE;
 }
 
+static zend_always_inline int async_socket_get_local_addr(php_socket_t sock, php_sockaddr_storage *addr)
+{
+	socklen_t len;
+	
+	len = sizeof(php_sockaddr_storage);
+	
+	if (UNEXPECTED(0 != getsockname(sock, (struct sockaddr *) addr, &len))) {
+		addr->ss_family = AF_UNSPEC;
+		
+		return FAILURE;
+	}
+	
+	return SUCCESS;
+}
+
+static zend_always_inline int async_socket_get_remote_addr(php_socket_t sock, php_sockaddr_storage *addr)
+{
+	socklen_t len;
+	
+	len = sizeof(php_sockaddr_storage);
+	
+	if (UNEXPECTED(0 != getpeername(sock, (struct sockaddr *) addr, &len))) {
+		addr->ss_family = AF_UNSPEC;
+		
+		return FAILURE;
+	}
+	
+	return SUCCESS;
+}
+
 static zend_always_inline int async_socket_parse_ip(const char *address, uint16_t port, php_sockaddr_storage *dest)
 {
 	if (0 == uv_ip4_addr(address, port, (struct sockaddr_in *) dest)) {
@@ -192,7 +237,12 @@ static zend_always_inline int async_socket_set_reuseaddr(php_socket_t sock, int
 
 static zend_always_inline int async_socket_set_reuseport(php_socket_t sock, int yes)
 {
-#ifndef PHP_WIN32
+#ifdef SO_REUSEPORT_LB
+	// FreeBSD only distributes connections between sockets using the load-balancing variant.
+	if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT_LB, &yes, sizeof(yes))) {
+    	return uv_translate_sys_error(php_socket_errno());
+    }
+#elif !defined(PHP_WIN32)
 	if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes))) {
     	return uv_translate_sys_error(php_socket_errno());
     }
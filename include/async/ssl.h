@@ -24,6 +24,17 @@
 
 #define ASYNC_SSL_DEFAULT_VERIFY_DEPTH 9
 
+#define ASYNC_SSL_DEFAULT_SESSION_CACHE 20480
+#define ASYNC_SSL_DEFAULT_SESSION_LIFETIME 300
+#define ASYNC_SSL_MAX_CLIENT_SESSIONS 1024
+#define ASYNC_SSL_MAX_CLIENT_CONTEXTS 64
+
+/* Protocol versions that can be passed to withMaxVersion() (same values as the OpenSSL version constants). */
+#define ASYNC_TLS_VERSION_1_0 0x0301
+#define ASYNC_TLS_VERSION_1_1 0x0302
+#define ASYNC_TLS_VERSION_1_2 0x0303
+#define ASYNC_TLS_VERSION_1_3 0x0304
+
 #ifndef OPENSSL_NO_TLSEXT
 #define ASYNC_TLS_SNI 1
 #if OPENSSL_VERSION_NUMBER >= 0x10002000L
@@ -31,20 +42,57 @@
 #endif
 #endif
 
+#if defined(HAVE_ASYNC_SSL) && defined(HAVE_LINUX_TLS_H) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+#define ASYNC_TLS_KTLS 1
+#endif
+
+/* OpenSSL 1.0.x is only thread-safe if the application installs locking callbacks, handshakes are not offloaded then. */
+#if defined(HAVE_ASYNC_SSL) && OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define ASYNC_TLS_OFFLOAD 1
+#endif
+
 #ifdef HAVE_ASYNC_SSL
 
 #define BIO_TYPE_PHP (98 | BIO_TYPE_SOURCE_SINK)
+#define BIO_TYPE_PHP_OUT (99 | BIO_TYPE_SOURCE_SINK)
 #define ASYNC_SSL_BIO_OVERHEAD (2 * sizeof(size_t))
 
+/* Maximum plaintext size of a TLS record and an upper bound of the per-record overhead (header, IV, MAC and padding). */
+#define ASYNC_SSL_MAX_RECORD 16384
+#define ASYNC_SSL_RECORD_OVERHEAD 512
+
 typedef struct _async_ssl_bio_php {
 	size_t size;
 	size_t len;
 	char buf[1];
 } async_ssl_bio_php;
 
+typedef struct _async_ssl_bio_out {
+	/* Buffer pool of the task scheduler, NULL while the engine is used by a worker thread. */
+	async_buffer_pool *pool;
+
+	/* Output buffer, allocated using malloc() if it has been created by a worker thread. */
+	char *buf;
+	size_t size;
+	size_t len;
+	size_t offset;
+	zend_bool foreign;
+
+	/* Pooled buffer that has been replaced by a worker thread, released when the pool is attached again. */
+	char *stale;
+	size_t stale_size;
+} async_ssl_bio_out;
+
 ASYNC_API BIO_METHOD *BIO_s_php();
 ASYNC_API BIO *BIO_new_php(size_t size);
 
+ASYNC_API BIO_METHOD *BIO_s_php_out();
+ASYNC_API BIO *BIO_new_php_out(async_buffer_pool *pool);
+
+void async_ssl_bio_set_pool(BIO *b, async_buffer_pool *pool);
+void async_ssl_bio_reserve(BIO *b, size_t len);
+char *async_ssl_bio_detach_buffer(BIO *b, size_t *len, size_t *size);
+
 void async_ssl_bio_init();
 void async_ssl_engine_init();
 
@@ -52,6 +100,13 @@ void async_ssl_engine_init();
 
 BIO_METHOD *BIO_meth_new(int type, const char *name);
 
+#define SSL_CTX_up_ref(ctx) CRYPTO_add(&(ctx)->references, 1, CRYPTO_LOCK_SSL_CTX)
+
+#define ASYNC_SSL_NO_PROTOCOLS(version) ((((version) < TLS1_2_VERSION) ? SSL_OP_NO_TLSv1_2 : 0) | (((version) < TLS1_1_VERSION) ? SSL_OP_NO_TLSv1_1 : 0))
+
+#define SSL_CTX_set_max_proto_version(ctx, version) SSL_CTX_set_options((ctx), ASYNC_SSL_NO_PROTOCOLS(version))
+#define SSL_set_max_proto_version(ssl, version) SSL_set_options((ssl), ASYNC_SSL_NO_PROTOCOLS(version))
+
 #define BIO_meth_set_write(b, f) (b)->bwrite = (f)
 #define BIO_meth_set_read(b, f) (b)->bread = (f)
 #define BIO_meth_set_ctrl(b, f) (b)->ctrl = (f)
@@ -87,6 +142,27 @@ static zend_always_inline void async_ssl_bio_expose_buffer(BIO *b, char **buf, u
 
 #endif
 
+typedef struct _async_ssl_ticket_key {
+	unsigned char name[16];
+	unsigned char aes_key[32];
+	unsigned char hmac_key[32];
+} async_ssl_ticket_key;
+
+typedef struct _async_ssl_ticket_keys {
+	/* Key being used to encrypt new tickets followed by the previous key (tickets are still accepted but renewed). */
+	async_ssl_ticket_key keys[2];
+
+	/* Unix timestamp of the last key rotation. */
+	time_t rotated;
+
+	/* Key rotation interval (in seconds). */
+	uint32_t lifetime;
+
+	/* Number of handshakes running on worker threads, keys are only rotated by the event loop thread if offloading is enabled. */
+	uint32_t busy;
+	zend_bool offload;
+} async_ssl_ticket_keys;
+
 typedef struct _async_ssl_settings {
 	/* SSL mode (ASYNC_SSL_MODE_SERVER or ASYNC_SSL_MODE_CLIENT). */
 	zend_bool mode;
@@ -102,6 +178,19 @@ typedef struct _async_ssl_settings {
 
 	/* Maximum verification cert chain length */
 	int verify_depth;
+
+	/* Session ticket keys of a server (NULL in client mode). */
+	async_ssl_ticket_keys *tickets;
+
+	/* Client session store and the key of the session being used by the connection. */
+	HashTable *sessions;
+	zend_string *session_key;
+
+	/* Set while a client handshake step runs on a worker thread, new sessions are held until the step has completed. */
+	zend_bool offloaded;
+#ifdef HAVE_ASYNC_SSL
+	SSL_SESSION *session;
+#endif
 } async_ssl_settings;
 
 typedef struct _async_ssl_op {
@@ -153,17 +242,19 @@ struct _async_tls_cert {
 	zend_string *file;
 	zend_string *key;
 	zend_string *passphrase;
+	
+	/* Previously added certificate, chains are immutable and shared between encryption objects. */
 	async_tls_cert *next;
-	async_tls_cert *prev;
-#ifdef HAVE_ASYNC_SSL
-	SSL_CTX *ctx;
-#endif
+	uint32_t refcount;
 };
 
-typedef struct _async_tls_cert_list {
-	async_tls_cert *first;
-	async_tls_cert *last;
-} async_tls_cert_list;
+typedef struct _async_tls_cert_index {
+	/* SSL contexts of certificates by lowercase host name. */
+	HashTable hosts;
+	
+	/* SSL contexts of wildcard certificates by parent domain ("*.example.com" is stored as "example.com"). */
+	HashTable wildcards;
+} async_tls_cert_index;
 
 typedef struct _async_tls_client_encryption {
 	/* PHP object handle. */
@@ -175,6 +266,9 @@ typedef struct _async_tls_client_encryption {
 	
 	zend_string *cafile;
 	zend_string *capath;
+	
+	/* Highest protocol version the client will negotiate, 0 if not limited. */
+	int max_version;
 } async_tls_client_encryption;
 
 typedef struct _async_tls_server_encryption {
@@ -182,12 +276,21 @@ typedef struct _async_tls_server_encryption {
 	zend_object std;
 
 	async_tls_cert cert;
-	async_tls_cert_list certs;
+	async_tls_cert *certs;
+	
+	/* Lookup table of SNI certificates, created when the encryption is used by a server for the first time. */
+	async_tls_cert_index *index;
 	
 	zend_string *alpn;
 	
 	zend_string *cafile;
 	zend_string *capath;
+
+	uint32_t session_cache;
+	uint32_t session_lifetime;
+	
+	/* Highest protocol version the server will negotiate, 0 if not limited. */
+	int max_version;
 } async_tls_server_encryption;
 
 typedef struct _async_tls_info {
@@ -197,7 +300,10 @@ typedef struct _async_tls_info {
 #ifdef HAVE_ASYNC_SSL
 
 SSL_CTX *async_ssl_create_context();
-int async_ssl_create_buffered_engine(async_ssl_engine *engine, size_t size);
+SSL_CTX *async_ssl_get_client_context(async_task_scheduler *scheduler, int options, char *cafile, char *capath, async_ssl_settings *settings, zend_string *alpn);
+zend_string *async_ssl_create_session_key(zend_string *host, int port, int options, char *cafile, char *capath, async_ssl_settings *settings, zend_string *alpn);
+void async_ssl_context_dtor(zval *zv);
+int async_ssl_create_buffered_engine(async_ssl_engine *engine, size_t size, async_buffer_pool *pool);
 void async_ssl_dispose_engine(async_ssl_engine *engine, zend_bool ctx);
 
 async_tls_server_encryption *async_ssl_create_server_encryption();
@@ -205,12 +311,25 @@ async_tls_info *async_tls_info_object_create(SSL *ssl);
 
 void async_ssl_setup_client_alpn(SSL_CTX *ctx, zend_string *alpn, zend_bool release);
 
-void async_ssl_setup_server_sni(SSL_CTX *ctx, async_tls_server_encryption *encryption);
+int async_ssl_setup_server_sni(SSL_CTX *ctx, async_tls_server_encryption *encryption);
+void async_ssl_dispose_cert_index(async_tls_cert_index *index);
 void async_ssl_setup_server_alpn(SSL_CTX *ctx, async_tls_server_encryption *encryption);
 
 void async_ssl_setup_verify_callback(SSL_CTX *ctx, async_ssl_settings *settings);
 int async_ssl_setup_encryption(SSL *ssl, async_ssl_settings *settings);
 
+void async_ssl_setup_client_sessions(SSL_CTX *ctx);
+void async_ssl_offload_begin(async_ssl_settings *settings);
+void async_ssl_offload_end(async_ssl_settings *settings);
+void async_ssl_setup_server_sessions(SSL_CTX *ctx, async_tls_server_encryption *encryption, async_ssl_ticket_keys *tickets);
+int async_ssl_resume_session(SSL *ssl, async_ssl_settings *settings);
+void async_ssl_session_dtor(zval *zv);
+
+#ifdef ASYNC_TLS_KTLS
+int async_ssl_enable_ktls(SSL *ssl, int fd, int *error);
+void async_ssl_ktls_close_notify(int fd);
+#endif
+
 int async_ssl_cert_passphrase_cb(char *buf, int size, int rwflag, void *obj);
 
 #endif
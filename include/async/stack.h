@@ -32,7 +32,15 @@ typedef struct _async_fiber_stack {
 #endif
 } async_fiber_stack;
 
-zend_bool async_fiber_stack_allocate(async_fiber_stack *stack, unsigned int size);
+#define ASYNC_FIBER_STACK_FLAG_LAZY 1
+
+#define ASYNC_FIBER_STACK_TRIM_NONE 0
+#define ASYNC_FIBER_STACK_TRIM_LAZY 1
+#define ASYNC_FIBER_STACK_TRIM_DISCARD 2
+
+zend_bool async_fiber_stack_allocate(async_fiber_stack *stack, unsigned int size, int flags);
+void async_fiber_stack_trim(async_fiber_stack *stack, int mode);
+size_t async_fiber_stack_used(async_fiber_stack *stack);
 void async_fiber_stack_free(async_fiber_stack *stack);
 
 #if _POSIX_MAPPED_FILES
@@ -65,4 +73,6 @@ void async_fiber_stack_free(async_fiber_stack *stack);
 #define ASYNC_STACK_PAGESIZE 4096
 #endif
 
+#define ASYNC_FIBER_STACK_SIZE(size) (((size_t) (size) + ASYNC_STACK_PAGESIZE - 1) / ASYNC_STACK_PAGESIZE * ASYNC_STACK_PAGESIZE)
+
 #endif
@@ -33,6 +33,7 @@
 #define ASYNC_STREAM_WRITING (1 << 8)
 #define ASYNC_STREAM_SSL_FATAL (1 << 9)
 #define ASYNC_STREAM_IPC (1 << 10)
+#define ASYNC_STREAM_KTLS (1 << 11)
 
 #define ASYNC_STREAM_SHUT_RDWR (ASYNC_STREAM_SHUT_RD | ASYNC_STREAM_SHUT_WR)
 
@@ -88,6 +89,7 @@ typedef struct _async_stream_write_req {
 typedef struct _async_stream_read_op {
 	async_op base;
 	async_stream_read_req *req;
+	zend_string *str;
 } async_stream_read_op;
 
 typedef struct _async_stream_shutdown_request {
@@ -97,10 +99,11 @@ typedef struct _async_stream_shutdown_request {
 
 struct _async_stream {
 	uv_stream_t *handle;
-	uv_timer_t timer;
+	async_wheel_timer timer;
 	uint16_t flags;
 	zend_uchar ref_count;
 	async_ring_buffer buffer;
+	size_t peak;
 	async_ssl_engine ssl;
 	async_stream_read_op read;
 	async_stream_shutdown_request shutdown;
@@ -120,6 +123,11 @@ struct _async_stream {
 #define ASYNC_STREAM_WRITE_OP_FLAG_STARTED (1 << 2)
 #define ASYNC_STREAM_WRITE_OP_FLAG_EXPORT (1 << 3)
 #define ASYNC_STREAM_WRITE_OP_FLAG_CALLBACK (1 << 4)
+#define ASYNC_STREAM_WRITE_OP_FLAG_GATHERED (1 << 5)
+#define ASYNC_STREAM_WRITE_OP_FLAG_BATCH (1 << 6)
+#define ASYNC_STREAM_WRITE_OP_FLAG_POOLED (1 << 7)
+
+#define ASYNC_STREAM_MAX_GATHER 64
 
 typedef struct _async_stream_write_buf {
 	size_t size;
@@ -142,6 +150,8 @@ typedef struct _async_stream_write_op {
 	zval ref;
 	async_stream_write_buf in;
 	async_stream_write_buf out;
+	size_t capacity;
+	struct _async_stream_write_op *batch;
 } async_stream_write_op;
 
 typedef struct _async_stream_reader {
@@ -166,9 +176,11 @@ void async_stream_shutdown(async_stream *stream, int how, zval *ref);
 void async_stream_flush(async_stream *stream);
 int async_stream_read(async_stream *stream, async_stream_read_req *req);
 int async_stream_write(async_stream *stream, async_stream_write_req *req);
+int async_stream_writev(async_stream *stream, uv_buf_t *bufs, unsigned int nbufs, async_stream_write_req *req);
 
 #ifdef HAVE_ASYNC_SSL
 int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *data);
+int async_stream_ssl_enable_ktls(async_stream *stream, zend_bool ctx, int *error);
 #endif
 
 static zend_always_inline void set_stream_receive_buffer(async_stream *stream, int v)
@@ -340,6 +352,95 @@ static zend_always_inline void async_stream_call_write(async_stream *stream, zva
 	}
 }
 
+static zend_always_inline zend_string *async_stream_join_chunks(HashTable *chunks)
+{
+	zend_string *str;
+	zval *entry;
+	size_t len;
+
+	len = 0;
+
+	ZEND_HASH_FOREACH_VAL(chunks, entry) {
+		ZVAL_DEREF(entry);
+		
+		if (UNEXPECTED(Z_TYPE_P(entry) != IS_STRING)) {
+			zend_throw_error(zend_ce_type_error, "Chunks must be strings, %s given", zend_zval_type_name(entry));
+			return NULL;
+		}
+		
+		len += Z_STRLEN_P(entry);
+	} ZEND_HASH_FOREACH_END();
+
+	str = zend_string_alloc(len, 0);
+	len = 0;
+
+	ZEND_HASH_FOREACH_VAL(chunks, entry) {
+		ZVAL_DEREF(entry);
+		
+		memcpy(ZSTR_VAL(str) + len, Z_STRVAL_P(entry), Z_STRLEN_P(entry));
+		len += Z_STRLEN_P(entry);
+	} ZEND_HASH_FOREACH_END();
+
+	ZSTR_VAL(str)[len] = '\0';
+
+	return str;
+}
+
+static zend_always_inline void async_stream_call_write_all(async_stream *stream, zval *error, INTERNAL_FUNCTION_PARAMETERS)
+{
+	async_stream_write_req write;
+
+	HashTable *chunks;
+	uv_buf_t *bufs;
+	unsigned int count;
+	zval *entry;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ARRAY_HT(chunks)
+	ZEND_PARSE_PARAMETERS_END();
+
+	if (UNEXPECTED(Z_TYPE_P(error) != IS_UNDEF)) {
+		ASYNC_FORWARD_ERROR(error);
+		return;
+	}
+
+	ZEND_HASH_FOREACH_VAL(chunks, entry) {
+		ZVAL_DEREF(entry);
+		
+		if (UNEXPECTED(Z_TYPE_P(entry) != IS_STRING)) {
+			zend_throw_error(zend_ce_type_error, "Chunks must be strings, %s given", zend_zval_type_name(entry));
+			return;
+		}
+	} ZEND_HASH_FOREACH_END();
+
+	bufs = emalloc(sizeof(uv_buf_t) * MAX(1, zend_hash_num_elements(chunks)));
+	count = 0;
+
+	ZEND_HASH_FOREACH_VAL(chunks, entry) {
+		ZVAL_DEREF(entry);
+		
+		if (Z_STRLEN_P(entry) > 0) {
+			bufs[count++] = uv_buf_init(Z_STRVAL_P(entry), (unsigned int) Z_STRLEN_P(entry));
+		}
+	} ZEND_HASH_FOREACH_END();
+
+	if (count == 0) {
+		efree(bufs);
+		return;
+	}
+
+	write.in.handle = NULL;
+	write.in.ref = getThis();
+	write.in.flags = 0;
+	write.in.callback = NULL;
+
+	if (UNEXPECTED(FAILURE == async_stream_writev(stream, bufs, count, &write))) {
+		forward_stream_write_error(stream, &write);
+	}
+
+	efree(bufs);
+}
+
 async_stream_reader *async_stream_reader_create(async_stream *stream, zend_object *ref, zval *error);
 async_stream_writer *async_stream_writer_create(async_stream *stream, zend_object *ref, zval *error);
 
@@ -359,6 +460,10 @@ ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_writable_stream_write, 0, 1, IS_
 	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_writable_stream_write_all, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, chunks, IS_ARRAY, 0)
+ZEND_END_ARG_INFO();
+
 // DuplexStream
 
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_duplex_stream_get_readable_stream, 0, 0, Concurrent\\Stream\\ReadableStream, 0)
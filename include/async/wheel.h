@@ -0,0 +1,32 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) Martin Schröder 2019                                   |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  | Authors: Martin Schröder <m.schroeder2007@gmail.com>                 |
+  +----------------------------------------------------------------------+
+*/
+
+#ifndef ASYNC_WHEEL_H
+#define ASYNC_WHEEL_H
+
+void async_timer_wheel_init(async_timer_wheel *wheel, uv_loop_t *loop, uint64_t granularity);
+void async_timer_wheel_close(async_timer_wheel *wheel);
+void async_timer_wheel_start(async_timer_wheel *wheel, async_wheel_timer *timer, uint64_t delay);
+void async_timer_wheel_stop(async_timer_wheel *wheel, async_wheel_timer *timer);
+
+static zend_always_inline zend_bool async_wheel_timer_is_active(async_wheel_timer *timer)
+{
+	return timer->list != NULL;
+}
+
+#endif
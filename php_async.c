@@ -63,6 +63,50 @@ static void async_execute_ex(zend_execute_data *exec)
 	}
 }
 
+static PHP_INI_MH(OnUpdateBufferPool)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(buffer_pool) < 0) {
+		ASYNC_G(buffer_pool) = 0;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateDirectRead)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(direct_read) < 0) {
+		ASYNC_G(direct_read) = 0;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateDispatchBudget)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(dispatch_budget) < 0) {
+		ASYNC_G(dispatch_budget) = 0;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateDispatchTime)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(dispatch_time) < 0) {
+		ASYNC_G(dispatch_time) = 0;
+	}
+
+	return SUCCESS;
+}
+
 static PHP_INI_MH(OnUpdateFiberStackSize)
 {
 	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
@@ -74,6 +118,65 @@ static PHP_INI_MH(OnUpdateFiberStackSize)
 	return SUCCESS;
 }
 
+static PHP_INI_MH(OnUpdateFiberPoolSize)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(fiber_pool_size) < 0) {
+		ASYNC_G(fiber_pool_size) = 0;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdatePriorityAging)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(priority_aging) < 0) {
+		ASYNC_G(priority_aging) = 0;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateReadBuffer)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(read_buffer) < 4096) {
+		ASYNC_G(read_buffer) = 4096;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateReadBufferMax)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(read_buffer_max) < 4096) {
+		ASYNC_G(read_buffer_max) = 4096;
+	}
+
+	return SUCCESS;
+}
+
+static PHP_INI_MH(OnUpdateTimerGranularity)
+{
+	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
+
+	if (ASYNC_G(timer_granularity) < 1) {
+		ASYNC_G(timer_granularity) = 1;
+	}
+
+	if (ASYNC_G(timer_granularity) > 1000) {
+		ASYNC_G(timer_granularity) = 1000;
+	}
+
+	return SUCCESS;
+}
+
 static PHP_INI_MH(OnUpdateThreadCount)
 {
 	OnUpdateLong(entry, new_value, mh_arg1, mh_arg2, mh_arg3, stage);
@@ -90,13 +193,29 @@ static PHP_INI_MH(OnUpdateThreadCount)
 }
 
 PHP_INI_BEGIN()
+	STD_PHP_INI_ENTRY("async.buffer_pool", "1048576", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBufferPool, buffer_pool, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.direct_read", "16384", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateDirectRead, direct_read, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.dispatch_budget", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateDispatchBudget, dispatch_budget, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.dispatch_stats", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, dispatch_stats, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.dispatch_time", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateDispatchTime, dispatch_time, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.dns", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, dns_enabled, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.fiber_pool", "32", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateFiberPoolSize, fiber_pool_size, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.fiber_pool_shared", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, fiber_pool_shared, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.fiber_pool_trim", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, fiber_pool_trim, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.filesystem", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, fs_enabled, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.forked", "0", PHP_INI_SYSTEM, OnUpdateBool, forked, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.ktls", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, ktls, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.priority_aging", "16", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdatePriorityAging, priority_aging, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.read_buffer", "8192", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateReadBuffer, read_buffer, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.read_buffer_max", "262144", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateReadBufferMax, read_buffer_max, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.stack_lazy", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, stack_lazy, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.stack_size", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateFiberStackSize, stack_size, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.stack_usage", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, stack_usage, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.tcp", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, tcp_enabled, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.threads", "4", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateThreadCount, threads, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.timer", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, timer_enabled, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.timer_granularity", "1", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateTimerGranularity, timer_granularity, zend_async_globals, async_globals)
+	STD_PHP_INI_ENTRY("async.tls_offload", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, tls_offload, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.udp", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, udp_enabled, zend_async_globals, async_globals)
 	STD_PHP_INI_ENTRY("async.unix", "0", PHP_INI_SYSTEM | PHP_INI_PERDIR, OnUpdateBool, unix_enabled, zend_async_globals, async_globals)
 PHP_INI_END()
@@ -187,10 +306,24 @@ PHP_MINIT_FUNCTION(async)
 	REGISTER_LONG_CONSTANT("ASYNC_SSL_ALPN_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
 #endif
 
+#ifdef ASYNC_TLS_KTLS
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_KTLS_SUPPORTED", 1, CONST_CS|CONST_PERSISTENT);
+#else
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_KTLS_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
+#endif
+
+#ifdef ASYNC_TLS_OFFLOAD
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_OFFLOAD_SUPPORTED", 1, CONST_CS|CONST_PERSISTENT);
+#else
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_OFFLOAD_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
+#endif
+
 #else
 	REGISTER_LONG_CONSTANT("ASYNC_SSL_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
 	REGISTER_LONG_CONSTANT("ASYNC_SSL_SNI_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
 	REGISTER_LONG_CONSTANT("ASYNC_SSL_ALPN_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_KTLS_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
+	REGISTER_LONG_CONSTANT("ASYNC_SSL_OFFLOAD_SUPPORTED", 0, CONST_CS|CONST_PERSISTENT);
 #endif
 
 	orig_execute_ex = zend_execute_ex;
@@ -200,6 +200,7 @@ ASYNC_API extern zend_class_entry *async_task_ce;
 ASYNC_API extern zend_class_entry *async_task_scheduler_ce;
 ASYNC_API extern zend_class_entry *async_tcp_server_ce;
 ASYNC_API extern zend_class_entry *async_tcp_socket_ce;
+ASYNC_API extern zend_class_entry *async_thread_channel_ce;
 ASYNC_API extern zend_class_entry *async_thread_pool_ce;
 ASYNC_API extern zend_class_entry *async_tls_client_encryption_ce;
 ASYNC_API extern zend_class_entry *async_tls_info_ce;
@@ -223,6 +224,7 @@ typedef struct _async_context                       async_context;
 typedef struct _async_context_cancellation          async_context_cancellation;
 typedef struct _async_context_timeout               async_context_timeout;
 typedef struct _async_context_var                   async_context_var;
+typedef struct _async_context_vars                  async_context_vars;
 typedef struct _async_fiber                         async_fiber;
 typedef struct _async_op                            async_op;
 typedef struct _async_task                          async_task;
@@ -241,6 +243,111 @@ typedef struct _async_tick_list {
 	async_tick_event *last;
 } async_tick_list;
 
+typedef struct _async_fiber_pool {
+	/* Terminated fibers that keep their C stack allocated for reuse. */
+	async_fiber *first;
+	async_fiber *last;
+
+	/* Number of fibers in the pool. */
+	uint32_t size;
+
+	/* Number of fibers that could (not) be taken from the pool. */
+	zend_ulong hits;
+	zend_ulong misses;
+
+	/* Number of fibers that had to be destroyed because the pool was full. */
+	zend_ulong discarded;
+
+	/* VM stack pages of terminated tasks (linked using the prev pointer of each page). */
+	zend_vm_stack pages;
+	uint32_t page_count;
+} async_fiber_pool;
+
+#define ASYNC_BUFFER_POOL_MIN_SIZE 4096
+#define ASYNC_BUFFER_POOL_CLASSES 9
+
+typedef struct _async_buffer_pool {
+	/* Unused buffers, one list per size class (4 KB up to 1 MB) linked using the first bytes of each buffer. */
+	struct {
+		char *first;
+		uint32_t count;
+	} classes[ASYNC_BUFFER_POOL_CLASSES];
+
+	/* Memory being held by checked out buffers. */
+	size_t size;
+	size_t peak;
+	zend_ulong count;
+
+	/* Memory being held by unused buffers in the pool. */
+	size_t pooled;
+
+	/* Number of buffers that could (not) be taken from the pool. */
+	zend_ulong hits;
+	zend_ulong misses;
+
+	/* Number of buffers that had to be freed because the pool was full. */
+	zend_ulong discarded;
+
+	/* Number of stream read buffers that have been grown / shrunk. */
+	zend_ulong grown;
+	zend_ulong shrunk;
+} async_buffer_pool;
+
+#define ASYNC_TIMER_WHEEL_BITS 6
+#define ASYNC_TIMER_WHEEL_SLOTS (1 << ASYNC_TIMER_WHEEL_BITS)
+#define ASYNC_TIMER_WHEEL_LEVELS 4
+
+typedef struct _async_wheel_timer async_wheel_timer;
+
+typedef struct _async_wheel_timer_list {
+	async_wheel_timer *first;
+	async_wheel_timer *last;
+} async_wheel_timer_list;
+
+struct _async_wheel_timer {
+	async_wheel_timer *prev;
+	async_wheel_timer *next;
+
+	/* Slot the timer is linked into (NULL if the timer is not active). */
+	async_wheel_timer_list *list;
+
+	/* Wheel level of the slot. */
+	uint8_t level;
+
+	/* Tick when the timer expires. */
+	uint64_t expires;
+
+	/* Callback being invoked when the timer expires, data is not used by the wheel. */
+	void (* func)(async_wheel_timer *timer);
+	void *data;
+};
+
+typedef struct _async_timer_wheel {
+	/* Single (unreferenced) libuv timer that is armed for the next slot that needs to be processed. */
+	uv_timer_t handle;
+
+	/* Length of a tick in milliseconds (taken from async.timer_granularity). */
+	uint64_t granularity;
+
+	/* Current tick of the wheel and the tick the libuv timer has been armed for. */
+	uint64_t now;
+	uint64_t wake;
+
+	/* Timers started with a delay of 0 that expire in the next loop iteration. */
+	async_wheel_timer_list due;
+
+	/* One ring of slots per level, a slot of level N covers 64^N ticks and is cascaded into lower levels when reached. */
+	async_wheel_timer_list slots[ASYNC_TIMER_WHEEL_LEVELS][ASYNC_TIMER_WHEEL_SLOTS];
+
+	/* Number of timers linked into the slots of each level and in total (not counting due timers). */
+	uint32_t counts[ASYNC_TIMER_WHEEL_LEVELS];
+	uint32_t count;
+
+	/* Number of expired timers and timers that have been moved into a lower level. */
+	zend_ulong expired;
+	zend_ulong cascaded;
+} async_timer_wheel;
+
 struct _async_cancel_cb {
 	/* Struct being passed to callback as first arg. */
 	void *object;
@@ -328,6 +435,11 @@ struct _async_cancellation_handler {
 
 #define ASYNC_CONTEXT_FLAG_BACKGROUND 1
 
+#define ASYNC_TASK_PRIORITY_LOW 0
+#define ASYNC_TASK_PRIORITY_NORMAL 1
+#define ASYNC_TASK_PRIORITY_HIGH 2
+#define ASYNC_TASK_PRIORITY_LEVELS 3
+
 struct _async_context {
 	/* PHP object handle. */
 	zend_object std;
@@ -338,11 +450,11 @@ struct _async_context {
 	/* Context flags. */
 	uint8_t flags;
 
-	/* Context var or NULL. */
-	async_context_var *var;
+	/* Priority of tasks created using the context (inherited by derived contexts). */
+	uint8_t priority;
 
-	/* Value of the context var, defaults to zval NULL. */
-	zval value;
+	/* Context var bindings visible in the context (shared with derived contexts), NULL if no var is bound. */
+	async_context_vars *vars;
 
 	/* Refers to the contextual cancellation handler. */
 	async_context_cancellation *cancel;
@@ -382,8 +494,8 @@ struct _async_context_timeout {
 	/* Task scheduler instance (only != NULL if timeout is active). */
 	async_task_scheduler *scheduler;
 
-	/* Timeout instance (unreferenced). */
-	uv_timer_t timer;
+	/* Deadline timer (linked into the timer wheel of the scheduler). */
+	async_wheel_timer timer;
 };
 
 struct _async_context_var {
@@ -391,6 +503,25 @@ struct _async_context_var {
 	zend_object std;
 };
 
+typedef struct _async_context_binding {
+	/* Bound context var (holds a reference). */
+	async_context_var *var;
+	
+	/* Value of the context var. */
+	zval value;
+} async_context_binding;
+
+struct _async_context_vars {
+	/* Number of contexts sharing the bindings, bindings are immutable once shared. */
+	uint32_t refcount;
+	
+	/* Number of bindings. */
+	uint32_t count;
+	
+	/* Bindings sorted by var address (lookup is a binary search). */
+	async_context_binding bindings[1];
+};
+
 #define ASYNC_TASK_FLAG_DISPOSED 1
 #define ASYNC_TASK_FLAG_NOWAIT (1 << 1)
 #define ASYNC_TASK_FLAG_ROOT (1 << 2)
@@ -408,9 +539,18 @@ struct _async_task {
 	/* Async operation status. */
 	zend_uchar status;
 
+	/* Ready queue priority level (taken from the context the task was created with). */
+	uint8_t priority;
+
 	/* Fiber C stack size. */
 	zend_long stack_size;
 
+	/* Measured C stack high-water mark (only if async.stack_usage is enabled). */
+	size_t stack_usage;
+
+	/* Time the task has been put into the ready queue (only if async.dispatch_stats is enabled). */
+	uint64_t enqueued;
+
 	/* PHP callback to be run as task. */
 	zend_fcall_info fci;
 	zend_fcall_info_cache fcc;
@@ -441,6 +581,9 @@ struct _async_task {
 #define ASYNC_TASK_SCHEDULER_FLAG_ERROR (1 << 3)
 #define ASYNC_TASK_SCHEDULER_FLAG_ACTIVE (1 << 4)
 
+/* Number of buckets of the time-in-queue histogram (10us, 100us, 1ms, 10ms, 100ms, 1s, more). */
+#define ASYNC_TASK_SCHEDULER_WAIT_BUCKETS 7
+
 struct _async_task_scheduler {
 	/* PHP object handle. */
 	zend_object std;
@@ -460,11 +603,22 @@ struct _async_task_scheduler {
 	/* Fiber that caused the scheduler to run. */
 	async_fiber *caller;
 
-	/* Tasks ready to be started or resumed. */
+	/* Tasks ready to be started or resumed (one queue per priority level). */
 	struct {
 		async_task *first;
 		async_task *last;
-	} ready;
+		uint32_t age;
+	} ready[ASYNC_TASK_PRIORITY_LEVELS];
+
+	/* Ready queue metrics. */
+	struct {
+		uint32_t depth;
+		uint32_t max_depth;
+		zend_ulong dispatched;
+		zend_ulong exhausted;
+		zend_ulong aged;
+		zend_ulong wait[ASYNC_TASK_SCHEDULER_WAIT_BUCKETS];
+	} dispatch;
 	
 	/* Pending operations that have not completed yet. */
 	async_op_list operations;
@@ -488,6 +642,42 @@ struct _async_task_scheduler {
 	uv_timer_t busy;
 	zend_ulong busy_count;
 
+	/* Timer wheel being used by sleep(), timers, timeouts, context deadlines and stream read timeouts. */
+	async_timer_wheel timers;
+
+	/* Terminated task fibers that can be reused by new tasks. */
+	async_fiber_pool pool;
+
+	/* Aggregated C stack usage of terminated tasks (only if async.stack_usage is enabled). */
+	struct {
+		size_t max;
+		zend_ulong total;
+		zend_ulong count;
+	} stack_usage;
+
+	/* Receive buffers shared by all streams and UDP sockets of the scheduler. */
+	async_buffer_pool buffers;
+
+#ifdef HAVE_ASYNC_SSL
+	/* TLS client sessions that can be resumed by new connections. */
+	HashTable sessions;
+
+	/* Shared TLS client contexts (keyed by options, CA settings, verify depth and ALPN protocols). */
+	HashTable contexts;
+#endif
+
+	/* Number of TLS handshakes that did (not) resume a previous session and client context cache hits / misses. */
+	struct {
+		zend_ulong client_hits;
+		zend_ulong client_misses;
+		zend_ulong server_hits;
+		zend_ulong server_misses;
+		zend_ulong context_hits;
+		zend_ulong context_misses;
+		zend_ulong offloaded;
+		zend_ulong ktls;
+	} tls;
+
 	/* Instantiated scheduler-scoped objects created by factories. */
 	HashTable components;
 
@@ -550,14 +740,33 @@ ZEND_BEGIN_MODULE_GLOBALS(async)
 
 	HashTable *factories;
 
+	/* Fiber pool shared by all task schedulers (only used if async.fiber_pool_shared is enabled). */
+	async_fiber_pool fiber_pool;
+
 	/* INI settings. */
+	zend_long buffer_pool;
+	zend_long direct_read;
+	zend_long dispatch_budget;
+	zend_bool dispatch_stats;
+	zend_long dispatch_time;
 	zend_bool dns_enabled;
+	zend_long fiber_pool_size;
+	zend_bool fiber_pool_shared;
+	zend_bool fiber_pool_trim;
 	zend_bool forked;
 	zend_bool fs_enabled;
+	zend_bool ktls;
+	zend_long priority_aging;
+	zend_long read_buffer;
+	zend_long read_buffer_max;
+	zend_bool stack_lazy;
 	zend_long stack_size;
+	zend_bool stack_usage;
 	zend_bool tcp_enabled;
 	zend_long threads;
 	zend_bool timer_enabled;
+	zend_long timer_granularity;
+	zend_bool tls_offload;
 	zend_bool udp_enabled;
 	zend_bool unix_enabled;
 
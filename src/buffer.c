@@ -0,0 +1,136 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) Martin Schröder 2019                                   |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  | Authors: Martin Schröder <m.schroeder2007@gmail.com>                 |
+  +----------------------------------------------------------------------+
+*/
+
+#include "php_async.h"
+
+#include "async/buffer.h"
+
+static zend_always_inline int get_size_class(size_t size)
+{
+	int i;
+
+	for (i = 0; i < ASYNC_BUFFER_POOL_CLASSES; i++) {
+		if (size <= ((size_t) ASYNC_BUFFER_POOL_MIN_SIZE << i)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* Rounds the given size up to the size of the matching size class, oversized buffers are not pooled. */
+size_t async_buffer_pool_size(size_t size)
+{
+	int i;
+
+	i = get_size_class(size);
+
+	return (i < 0) ? size : ((size_t) ASYNC_BUFFER_POOL_MIN_SIZE << i);
+}
+
+/* Takes a buffer of at least the given size from the pool or allocates a new buffer if no matching buffer is pooled. */
+char *async_buffer_pool_acquire(async_buffer_pool *pool, size_t size)
+{
+	char *base;
+	int i;
+
+	i = get_size_class(size);
+
+	if (i >= 0) {
+		size = (size_t) ASYNC_BUFFER_POOL_MIN_SIZE << i;
+	}
+
+	if (i >= 0 && pool->classes[i].first != NULL) {
+		base = pool->classes[i].first;
+
+		pool->classes[i].first = *((char **) base);
+		pool->classes[i].count--;
+		pool->pooled -= size;
+		pool->hits++;
+	} else {
+		base = emalloc(size);
+
+		pool->misses++;
+	}
+
+	pool->size += size;
+	pool->count++;
+
+	if (pool->size > pool->peak) {
+		pool->peak = pool->size;
+	}
+
+	return base;
+}
+
+/* Puts a buffer back into the pool, buffers are freed if the pool has reached the configured size. */
+void async_buffer_pool_release(async_buffer_pool *pool, char *base, size_t size)
+{
+	int i;
+
+	ZEND_ASSERT(base != NULL);
+
+	i = get_size_class(size);
+
+	if (i >= 0) {
+		size = (size_t) ASYNC_BUFFER_POOL_MIN_SIZE << i;
+	}
+
+	pool->size -= size;
+	pool->count--;
+
+	if (i < 0) {
+		efree(base);
+
+		return;
+	}
+
+	if ((pool->pooled + size) > (size_t) ASYNC_G(buffer_pool)) {
+		efree(base);
+
+		pool->discarded++;
+
+		return;
+	}
+
+	// Buffers are reused in LIFO order because the most recently used memory is likely to be hot.
+	*((char **) base) = pool->classes[i].first;
+
+	pool->classes[i].first = base;
+	pool->classes[i].count++;
+	pool->pooled += size;
+}
+
+void async_buffer_pool_dispose(async_buffer_pool *pool)
+{
+	char *base;
+	int i;
+
+	for (i = 0; i < ASYNC_BUFFER_POOL_CLASSES; i++) {
+		while (pool->classes[i].first != NULL) {
+			base = pool->classes[i].first;
+			pool->classes[i].first = *((char **) base);
+
+			efree(base);
+		}
+
+		pool->classes[i].count = 0;
+	}
+
+	pool->pooled = 0;
+}
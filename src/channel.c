@@ -21,6 +21,7 @@
 #include "async/helper.h"
 
 #include "ext/standard/php_mt_rand.h"
+#include "ext/spl/spl_iterators.h"
 
 ASYNC_API zend_class_entry *async_channel_ce;
 ASYNC_API zend_class_entry *async_channel_closed_exception_ce;
@@ -38,6 +39,30 @@ static zend_string *str_value;
 
 #define ASYNC_CHANNEL_FLAG_CLOSED 1
 
+/* Maximum number of messages that can be buffered by a channel. */
+#define ASYNC_CHANNEL_MAX_CAPACITY 0x7FFFFFFF
+
+/* Initial number of buffer slots, the buffer grows on demand until capacity is reached. */
+#define ASYNC_CHANNEL_BUFFER_INITIAL 64
+
+/* Maximum number of blocking operations being kept for reuse by a channel. */
+#define ASYNC_CHANNEL_OP_POOL 8
+
+typedef struct _async_channel_group async_channel_group;
+typedef struct _async_channel_group_entry async_channel_group_entry;
+typedef struct _async_channel_link async_channel_link;
+
+struct _async_channel_link {
+	async_channel_link *prev;
+	async_channel_link *next;
+	async_channel_group_entry *entry;
+};
+
+typedef struct _async_channel_link_list {
+	async_channel_link *first;
+	async_channel_link *last;
+} async_channel_link_list;
+
 typedef struct _async_channel_state {
 	/* Refcount being used by channel and ietartor objects to share the state. */
 	uint32_t refcount;
@@ -60,14 +85,24 @@ typedef struct _async_channel_state {
 	/* Pending receive operations. */
 	async_op_list receivers;
 	
-	/* Array ring buffer used by the channel. */
+	/* Array ring buffer used by the channel (size is the capacity, alloc the number of allocated slots). */
 	struct {
-		uint16_t size;
-		uint16_t len;
-		uint16_t rpos;
-		uint16_t wpos;
+		uint32_t size;
+		uint32_t alloc;
+		uint32_t len;
+		uint32_t rpos;
+		uint32_t wpos;
 		zval *data;
 	} buffer;
+	
+	/* Blocking operations that are kept for reuse. */
+	async_op_list pool;
+	
+	/* Number of pooled operations. */
+	uint8_t pooled;
+	
+	/* Channel group entries that are notified when the channel becomes readable. */
+	async_channel_link_list watchers;
 } async_channel_state;
 
 typedef struct _async_channel {
@@ -100,33 +135,43 @@ typedef struct _async_channel_iterator {
 	async_op op;
 } async_channel_iterator;
 
-typedef struct _async_channel_group_entry {
-	/* Base async op data. */
-	async_op base;
-	
+#define ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY 1
+
+struct _async_channel_group_entry {
 	/* Wrapped channel iterator. */
 	async_channel_iterator *it;
 	
 	/* Key being used to register the iterator with the channel group. */
 	zval key;
-} async_channel_group_entry;
+	
+	/* Group that contains the entry. */
+	async_channel_group *group;
+	
+	/* Position of the entry within the entries array of the group. */
+	uint32_t index;
+	
+	/* Entry flags. */
+	uint8_t flags;
+	
+	/* Refcount held by the group and by pending send operations. */
+	uint32_t refcount;
+	
+	/* Registration with the watchers of the channel. */
+	async_channel_link watch;
+	
+	/* Position within the ready queue of the group. */
+	async_channel_link ready;
+};
 
 typedef struct _async_channel_send_op {
 	async_op base;
 	zval value;
 	async_channel_group_entry *entry;
-} async_channel_send_op;
-
-typedef struct _async_channel_group_select_op {
-	/* Base async op data. */
-	async_op base;
 	
-	/* Number of pending select operations, needed to stop select if all channels are closed. */
-	uint32_t pending;
-	
-	/* Refers to the registration of the iterator that completed the select. */
-	async_channel_group_entry *entry;
-} async_channel_group_select_op;
+	/* Messages of a batch send, value refers to the message at pos. */
+	HashTable *batch;
+	HashPosition pos;
+} async_channel_send_op;
 
 typedef struct _async_channel_group_send_op {
 	/* Base async op data. */
@@ -150,8 +195,9 @@ typedef struct _async_channel_group_send_op {
 
 #define ASYNC_CHANNEL_GROUP_FLAG_SHUFFLE 1
 #define ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED (1 << 1)
+#define ASYNC_CHANNEL_GROUP_FLAG_TIMEOUT (1 << 2)
 
-typedef struct _async_channel_group {
+struct _async_channel_group {
 	/* PHP object handle. */
 	zend_object std;
 	
@@ -164,15 +210,21 @@ typedef struct _async_channel_group {
 	/* Number of (supposedly) unclosed channel iterators. */
 	uint32_t count;
 	
-	/* Array of registered channel iterators (closed channels will be removed without leaving gaps). */
-	async_channel_group_entry *entries;
+	/* Array of registered channel iterators (closed channels are replaced by the last entry to avoid gaps). */
+	async_channel_group_entry **entries;
+	
+	/* Entries of channels that have (possibly) become readable, select consumes them in FIFO order. */
+	async_channel_link_list ready;
+	
+	/* Rotating offset of the first channel being considered by send. */
+	uint32_t next;
 	
 	/* Basic select operation being used to suspend the calling task. */
-	async_channel_group_select_op select;
+	async_op select;
 	
 	/* Timer being used to stop select, only initialized if timeout > 0. */
 	uv_timer_t timer;
-} async_channel_group;
+};
 
 typedef struct _async_channel_select {
 	zend_object std;
@@ -203,24 +255,118 @@ static zend_always_inline void forward_error(zval *cause, zend_execute_data *exe
 	EG(current_execute_data) = prev;
 }
 
-static zend_always_inline int fetch_noblock(async_channel_state *state, zval *entry)
+static void notify_watchers(async_channel_state *state)
+{
+	async_channel_group_entry *entry;
+	async_channel_group *group;
+	async_channel_link *link;
+	
+	for (link = state->watchers.first; link != NULL; link = link->next) {
+		entry = link->entry;
+		group = entry->group;
+		
+		// Errors are forwarded by select before any buffered messages are received.
+		if (UNEXPECTED(Z_TYPE_P(&state->error) != IS_UNDEF)) {
+			if (entry->flags & ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY) {
+				ASYNC_LIST_REMOVE(&group->ready, &entry->ready);
+			}
+			
+			ASYNC_LIST_PREPEND(&group->ready, &entry->ready);
+		} else if (!(entry->flags & ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY)) {
+			ASYNC_LIST_APPEND(&group->ready, &entry->ready);
+		}
+		
+		entry->flags |= ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY;
+		
+		if (group->select.status == ASYNC_STATUS_RUNNING) {
+			ASYNC_FINISH_OP(&group->select);
+		}
+	}
+}
+
+static void grow_buffer(async_channel_state *state)
+{
+	zval *data;
+	
+	uint32_t alloc;
+	uint32_t i;
+	
+	alloc = MIN(state->buffer.size, MAX(state->buffer.alloc * 2, ASYNC_CHANNEL_BUFFER_INITIAL));
+	data = safe_emalloc(alloc, sizeof(zval), 0);
+	
+	for (i = 0; i < state->buffer.len; i++) {
+		ZVAL_COPY_VALUE(&data[i], &state->buffer.data[(state->buffer.rpos + i) % state->buffer.alloc]);
+	}
+	
+	if (state->buffer.data != NULL) {
+		efree(state->buffer.data);
+	}
+	
+	state->buffer.data = data;
+	state->buffer.alloc = alloc;
+	state->buffer.rpos = 0;
+	state->buffer.wpos = state->buffer.len;
+}
+
+static zend_always_inline int push_buffer(async_channel_state *state, zval *val)
+{
+	if (state->buffer.len >= state->buffer.size) {
+		return FAILURE;
+	}
+	
+	if (UNEXPECTED(state->buffer.len == state->buffer.alloc)) {
+		grow_buffer(state);
+	}
+	
+	ZVAL_COPY(&state->buffer.data[state->buffer.wpos], val);
+	
+	state->buffer.wpos = (state->buffer.wpos + 1) % state->buffer.alloc;
+	state->buffer.len++;
+	
+	if (state->watchers.first != NULL) {
+		notify_watchers(state);
+	}
+	
+	return SUCCESS;
+}
+
+static zend_always_inline void consume_send(async_channel_state *state, zval *entry)
 {
 	async_channel_send_op *send;
 	
+	zval *next;
+	
+	send = (async_channel_send_op *) state->senders.first;
+	
+	ZVAL_COPY(entry, &send->value);
+	
+	// A batch send remains queued until all of its messages have been consumed.
+	if (send->batch != NULL) {
+		zend_hash_move_forward_ex(send->batch, &send->pos);
+		
+		if (NULL != (next = zend_hash_get_current_data_ex(send->batch, &send->pos))) {
+			ZVAL_DEREF(next);
+			ZVAL_COPY_VALUE(&send->value, next);
+			
+			return;
+		}
+	}
+	
+	ASYNC_FINISH_OP(send);
+}
+
+static zend_always_inline int fetch_noblock(async_channel_state *state, zval *entry)
+{
 	// Get next message from buffer.
 	if (state->buffer.len > 0) {
 		ZVAL_ZVAL(entry, &state->buffer.data[state->buffer.rpos], 0, 0);
 		
-		state->buffer.rpos = (state->buffer.rpos + 1) % state->buffer.size;
+		state->buffer.rpos = (state->buffer.rpos + 1) % state->buffer.alloc;
 		
 		if (state->senders.first != NULL) {
-			ASYNC_NEXT_CUSTOM_OP(&state->senders, send, async_channel_send_op);
+			consume_send(state, &state->buffer.data[state->buffer.wpos]);
 			
-			ZVAL_COPY(&state->buffer.data[state->buffer.wpos], &send->value);
-			
-			state->buffer.wpos = (state->buffer.wpos + 1) % state->buffer.size;
-			
-			ASYNC_FINISH_OP(send);
+			state->buffer.wpos = (state->buffer.wpos + 1) % state->buffer.alloc;
 		} else {
 			state->buffer.len--;
 		}
@@ -230,11 +376,7 @@ static zend_always_inline int fetch_noblock(async_channel_state *state, zval *en
 	
 	// Get next message from first pending send operation.
 	if (state->senders.first != NULL) {
-		ASYNC_NEXT_CUSTOM_OP(&state->senders, send, async_channel_send_op);
-		
-		ZVAL_COPY(entry, &send->value);
-		
-		ASYNC_FINISH_OP(send);
+		consume_send(state, entry);
 		
 		return SUCCESS;
 	}
@@ -242,6 +384,42 @@ static zend_always_inline int fetch_noblock(async_channel_state *state, zval *en
 	return FAILURE;
 }
 
+static zend_always_inline async_channel_send_op *acquire_op(async_channel_state *state)
+{
+	async_channel_send_op *op;
+	
+	if (state->pool.first == NULL) {
+		ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_channel_send_op));
+	} else {
+		ASYNC_NEXT_CUSTOM_OP(&state->pool, op, async_channel_send_op);
+		
+		state->pooled--;
+	}
+	
+	return op;
+}
+
+static zend_always_inline void release_op(async_channel_state *state, async_channel_send_op *op)
+{
+	if (state->pooled >= ASYNC_CHANNEL_OP_POOL) {
+		ASYNC_FREE_OP(op);
+		
+		return;
+	}
+	
+	if (op->base.list != NULL) {
+		ASYNC_LIST_REMOVE(op->base.list, (async_op *) op);
+	}
+	
+	zval_ptr_dtor(&op->base.result);
+	
+	memset(op, 0, sizeof(async_channel_send_op));
+	
+	ASYNC_LIST_APPEND(&state->pool, (async_op *) op);
+	
+	state->pooled++;
+}
+
 ASYNC_CALLBACK dispose_state(void *arg, zval *error)
 {
 	async_channel_state *state;
@@ -260,6 +438,8 @@ ASYNC_CALLBACK dispose_state(void *arg, zval *error)
 		}
 	}
 	
+	notify_watchers(state);
+	
 	while (state->receivers.first != NULL) {
 		ASYNC_NEXT_OP(&state->receivers, op);
 		
@@ -300,6 +480,8 @@ static zend_always_inline async_channel_state *create_state()
 
 static zend_always_inline void release_state(async_channel_state *state)
 {
+	async_op *op;
+	
 	if (0 != --state->refcount) {
 		return;
 	}
@@ -312,17 +494,23 @@ static zend_always_inline void release_state(async_channel_state *state)
 	
 	zval_ptr_dtor(&state->error);
 	
-	if (state->buffer.size > 0) {
+	if (state->buffer.data != NULL) {
 		while (state->buffer.len > 0) {
 			zval_ptr_dtor(&state->buffer.data[state->buffer.rpos]);
 			
-			state->buffer.rpos = (state->buffer.rpos + 1) % state->buffer.size;
+			state->buffer.rpos = (state->buffer.rpos + 1) % state->buffer.alloc;
 			state->buffer.len--;
 		}
 		
 		efree(state->buffer.data);
 	}
 	
+	while (state->pool.first != NULL) {
+		ASYNC_NEXT_OP(&state->pool, op);
+		
+		efree(op);
+	}
+	
 	async_task_scheduler_unref(state->scheduler);
 	
 	efree(state);
@@ -385,15 +573,16 @@ static PHP_METHOD(Channel, __construct)
 	ZEND_PARSE_PARAMETERS_END();
 	
 	ASYNC_CHECK_ERROR(size < 0, "Channel buffer size must not be negative");
-	ASYNC_CHECK_ERROR(size > 0xFFFF, "Maximum channel buffer size is %d", (int) size);
+	
+#if SIZEOF_ZEND_LONG > 4
+	// A 32-bit zend_long cannot exceed the maximum capacity.
+	ASYNC_CHECK_ERROR(size > ASYNC_CHANNEL_MAX_CAPACITY, "Maximum channel buffer size is %d", ASYNC_CHANNEL_MAX_CAPACITY);
+#endif
 	
 	channel = (async_channel *) Z_OBJ_P(getThis());
-		
-	channel->state->buffer.size = (uint16_t) size;
 	
-	if (size > 0) {
-		channel->state->buffer.data = ecalloc(channel->state->buffer.size, sizeof(zval));
-	}
+	// Buffer memory is allocated on demand.
+	channel->state->buffer.size = (uint32_t) size;
 }
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_channel_get_iterator, 0, 0, 0)
@@ -488,20 +677,20 @@ static PHP_METHOD(Channel, send)
 	}
 	
 	// Put message into channel buffer.
-	if (state->buffer.len < state->buffer.size) {
-		ZVAL_COPY(&state->buffer.data[state->buffer.wpos], val);
-		
-		state->buffer.wpos = (state->buffer.wpos + 1) % state->buffer.size;
-		state->buffer.len++;
-		
+	if (push_buffer(state, val) == SUCCESS) {
 		return;
 	}
 	
-	ASYNC_ALLOC_CUSTOM_OP(send, sizeof(async_channel_send_op));
+	send = acquire_op(state);
+	
 	ASYNC_APPEND_OP(&state->senders, send);
 	
 	ZVAL_COPY(&send->value, val);
 	
+	if (state->watchers.first != NULL) {
+		notify_watchers(state);
+	}
+	
 	context = async_context_get();
 	
 	if (!async_context_is_background(context)) {
@@ -518,7 +707,205 @@ static PHP_METHOD(Channel, send)
 	
 	zval_ptr_dtor(&send->value);
 
-	ASYNC_FREE_OP(send);
+	release_op(state, send);
+}
+
+static int collect_message(zend_object_iterator *it, void *arg)
+{
+	zval *val;
+	
+	val = it->funcs->get_current_data(it);
+	
+	if (UNEXPECTED(EG(exception))) {
+		return ZEND_HASH_APPLY_STOP;
+	}
+	
+	ZVAL_DEREF(val);
+	Z_TRY_ADDREF_P(val);
+	
+	zend_hash_next_index_insert((HashTable *) arg, val);
+	
+	return ZEND_HASH_APPLY_KEEP;
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_channel_send_many, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, messages, IS_ITERABLE, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(Channel, sendMany)
+{
+	async_channel_state *state;
+	async_context *context;
+	async_channel_send_op *send;
+	async_op *op;
+	
+	HashTable *batch;
+	HashPosition pos;
+	zval messages;
+	zval *val;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ZVAL(val)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	if (UNEXPECTED(!zend_is_iterable(val))) {
+		zend_type_error("Messages must be iterable, %s given", zend_zval_type_name(val));
+		return;
+	}
+	
+	state = ((async_channel *) Z_OBJ_P(getThis()))->state;
+	
+	if (Z_TYPE_P(val) == IS_ARRAY) {
+		ZVAL_COPY(&messages, val);
+	} else {
+		array_init(&messages);
+		
+		if (UNEXPECTED(spl_iterator_apply(val, collect_message, Z_ARRVAL(messages)) == FAILURE || EG(exception))) {
+			zval_ptr_dtor(&messages);
+			return;
+		}
+	}
+	
+	if (UNEXPECTED(state->flags & ASYNC_CHANNEL_FLAG_CLOSED)) {
+		if (Z_TYPE_P(&state->error) != IS_UNDEF) {
+			forward_error(&state->error, execute_data);
+		} else {
+			zend_throw_exception(async_channel_closed_exception_ce, "Channel has been closed", 0);
+		}
+		
+		zval_ptr_dtor(&messages);
+		return;
+	}
+	
+	batch = Z_ARRVAL(messages);
+	
+	zend_hash_internal_pointer_reset_ex(batch, &pos);
+	
+	// Fast forward messages to waiting receivers and into the channel buffer.
+	while (NULL != (val = zend_hash_get_current_data_ex(batch, &pos))) {
+		ZVAL_DEREF(val);
+		
+		if (state->receivers.first != NULL) {
+			ASYNC_NEXT_OP(&state->receivers, op);
+			ASYNC_RESOLVE_OP(op, val);
+		} else if (push_buffer(state, val) == FAILURE) {
+			break;
+		}
+		
+		zend_hash_move_forward_ex(batch, &pos);
+	}
+	
+	if (val == NULL) {
+		zval_ptr_dtor(&messages);
+		return;
+	}
+	
+	// Queue all remaining messages as a single send operation.
+	send = acquire_op(state);
+	
+	send->batch = batch;
+	send->pos = pos;
+	
+	ZVAL_COPY_VALUE(&send->value, val);
+	
+	ASYNC_APPEND_OP(&state->senders, send);
+	
+	if (state->watchers.first != NULL) {
+		notify_watchers(state);
+	}
+	
+	context = async_context_get();
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_ENTER(state->scheduler);
+	}
+	
+	if (async_await_op((async_op *) send) == FAILURE) {
+		forward_error(&send->base.result, execute_data);
+	}
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_EXIT(state->scheduler);
+	}
+	
+	release_op(state, send);
+	
+	zval_ptr_dtor(&messages);
+}
+
+static void receive_many(async_channel_state *state, zend_long max, zval *return_value, zend_execute_data *execute_data)
+{
+	async_channel_send_op *op;
+	async_context *context;
+	
+	HashTable *result;
+	zval entry;
+	
+	array_init_size(return_value, (uint32_t) MIN(max, MAX(state->buffer.len, 1)));
+	
+	result = Z_ARRVAL_P(return_value);
+	
+	while (zend_hash_num_elements(result) < max && fetch_noblock(state, &entry) == SUCCESS) {
+		zend_hash_next_index_insert_new(result, &entry);
+	}
+	
+	if (zend_hash_num_elements(result) > 0) {
+		return;
+	}
+	
+	if (!ASYNC_CHANNEL_READABLE(state)) {
+		if (Z_TYPE_P(&state->error) != IS_UNDEF) {
+			forward_error(&state->error, execute_data);
+		}
+		
+		return;
+	}
+	
+	op = acquire_op(state);
+	
+	ASYNC_APPEND_OP(&state->receivers, op);
+	
+	context = async_context_get();
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_ENTER(state->scheduler);
+	}
+	
+	if (async_await_op((async_op *) op) == FAILURE) {
+		forward_error(&op->base.result, execute_data);
+	} else if (Z_TYPE_P(&op->base.result) != IS_UNDEF) {
+		Z_TRY_ADDREF_P(&op->base.result);
+		
+		zend_hash_next_index_insert_new(result, &op->base.result);
+		
+		// Grab messages that have been sent while the task was suspended.
+		while (zend_hash_num_elements(result) < max && fetch_noblock(state, &entry) == SUCCESS) {
+			zend_hash_next_index_insert_new(result, &entry);
+		}
+	}
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_EXIT(state->scheduler);
+	}
+	
+	release_op(state, op);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_channel_receive_many, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, max, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(Channel, receiveMany)
+{
+	zend_long max;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_LONG(max)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(max < 1, "Batch size must be at least 1");
+	
+	receive_many(((async_channel *) Z_OBJ_P(getThis()))->state, max, return_value, execute_data);
 }
 
 //LCOV_EXCL_START
@@ -532,6 +919,8 @@ static const zend_function_entry channel_functions[] = {
 	PHP_ME(Channel, close, arginfo_channel_close, ZEND_ACC_PUBLIC)
 	PHP_ME(Channel, isClosed, arginfo_channel_is_closed, ZEND_ACC_PUBLIC)
 	PHP_ME(Channel, send, arginfo_channel_send, ZEND_ACC_PUBLIC)
+	PHP_ME(Channel, sendMany, arginfo_channel_send_many, ZEND_ACC_PUBLIC)
+	PHP_ME(Channel, receiveMany, arginfo_channel_receive_many, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -576,7 +965,7 @@ static void async_channel_select_object_destroy(zend_object *object)
 /* Performs a Fisher–Yates shuffle to randomize the channel entries array in-place. */
 static void shuffle_group(async_channel_group *group)
 {
-	async_channel_group_entry entry;
+	async_channel_group_entry *entry;
 	
 	uint32_t i;
 	uint32_t j;
@@ -586,32 +975,58 @@ static void shuffle_group(async_channel_group *group)
 		entry = group->entries[i];
 		
 		group->entries[i] = group->entries[j];
+		group->entries[i]->index = i;
+		
 		group->entries[j] = entry;
+		group->entries[j]->index = j;
 	}
 }
 
+static zend_always_inline void delref_entry(async_channel_group_entry *entry)
+{
+	if (--entry->refcount == 0) {
+		ASYNC_DELREF(&entry->it->std);
+		zval_ptr_dtor(&entry->key);
+		
+		efree(entry);
+	}
+}
+
+/* Unregisters the entry from its channel, pending send operations keep the entry alive until they are disposed. */
+static void release_entry(async_channel_group_entry *entry)
+{
+	ASYNC_LIST_REMOVE(&entry->it->state->watchers, &entry->watch);
+	
+	delref_entry(entry);
+}
+
+/* Removes the entry from the group by moving the last entry into its slot. */
+static void remove_entry(async_channel_group *group, async_channel_group_entry *entry)
+{
+	if (entry->flags & ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY) {
+		ASYNC_LIST_REMOVE(&group->ready, &entry->ready);
+	}
+	
+	group->entries[entry->index] = group->entries[--group->count];
+	group->entries[entry->index]->index = entry->index;
+	
+	release_entry(entry);
+}
+
 static void compact_group(async_channel_group *group, async_channel_group_entry *selected)
 {
 	async_channel_group_entry *entry;
 	async_channel_state *state;
 	
 	uint32_t i;
-	uint32_t j;
 	
 	for (i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
+		entry = group->entries[i];
 		state = entry->it->state;
 	
 		if (state->flags & ASYNC_CHANNEL_FLAG_CLOSED) {
 			if (Z_TYPE_P(&state->error) == IS_UNDEF || entry == selected) {
-				ASYNC_DELREF(&entry->it->std);
-				zval_ptr_dtor(&entry->key);
-			
-				for (j = i + 1; j < group->count; j++) {
-					group->entries[j - 1] = group->entries[j];
-				}
-				
-				group->count--;
+				remove_entry(group, entry);
 				i--;
 			}
 		}
@@ -660,8 +1075,7 @@ static void async_channel_group_object_destroy(zend_object *object)
 	
 	if (group->entries != NULL) {
 		for (i = 0; i < group->count; i++) {
-			ASYNC_DELREF(&group->entries[i].it->std);
-			zval_ptr_dtor(&group->entries[i].key);
+			release_entry(group->entries[i]);
 		}
 	
 		efree(group->entries);
@@ -680,15 +1094,19 @@ ZEND_END_ARG_INFO();
 static PHP_METHOD(ChannelGroup, __construct)
 {
 	async_channel_group *group;
+	async_channel_group_entry *entry;
+	async_channel_iterator *it;
 	
 	HashTable *map;
-	zval *entry;
+	zval *val;
 	zval tmp;
 	
 	zend_long shuffle;
 	zend_long h;
 	zend_string *k;
 	
+	uint32_t i;
+	
 	shuffle = 0;
 	
 	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 3)
@@ -708,21 +1126,21 @@ static PHP_METHOD(ChannelGroup, __construct)
 		group->flags |= ASYNC_CHANNEL_GROUP_FLAG_SHUFFLE;
 	}
 	
-	group->entries = ecalloc(zend_array_count(map), sizeof(async_channel_group_entry));
+	group->entries = ecalloc(zend_array_count(map), sizeof(async_channel_group_entry *));
 	
-	ZEND_HASH_FOREACH_KEY_VAL(map, h, k, entry) {
-		if (UNEXPECTED(Z_TYPE_P(entry) != IS_OBJECT)) {
+	ZEND_HASH_FOREACH_KEY_VAL(map, h, k, val) {
+		if (UNEXPECTED(Z_TYPE_P(val) != IS_OBJECT)) {
 			zend_throw_error(NULL, "Select requires all inputs to be objects");
 			return;
 		}
 		
-		if (!instanceof_function(Z_OBJCE_P(entry), async_channel_iterator_ce)) {
-			if (UNEXPECTED(!instanceof_function(Z_OBJCE_P(entry), zend_ce_aggregate))) {
+		if (!instanceof_function(Z_OBJCE_P(val), async_channel_iterator_ce)) {
+			if (UNEXPECTED(!instanceof_function(Z_OBJCE_P(val), zend_ce_aggregate))) {
 				zend_throw_error(NULL, "Select requires all inputs to be channel iterators or provide such an iterator via IteratorAggregate");
 				return;
 			}
 			
-			zend_call_method_with_0_params(entry, Z_OBJCE_P(entry), &Z_OBJCE_P(entry)->iterator_funcs_ptr->zf_new_iterator, "getiterator", &tmp);
+			zend_call_method_with_0_params(val, Z_OBJCE_P(val), &Z_OBJCE_P(val)->iterator_funcs_ptr->zf_new_iterator, "getiterator", &tmp);
 			
 			if (UNEXPECTED(EG(exception) || Z_TYPE_P(&tmp) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(&tmp), async_channel_iterator_ce))) {
 				ASYNC_ENSURE_ERROR("Aggregated iterator is not a channel iterator");
@@ -730,21 +1148,49 @@ static PHP_METHOD(ChannelGroup, __construct)
 				return;
 			}
 			
-			group->entries[group->count].it = (async_channel_iterator *) Z_OBJ_P(&tmp);
+			it = (async_channel_iterator *) Z_OBJ_P(&tmp);
 		} else {
-			Z_ADDREF_P(entry);
+			Z_ADDREF_P(val);
 			
-			group->entries[group->count].it = (async_channel_iterator *) Z_OBJ_P(entry);
+			it = (async_channel_iterator *) Z_OBJ_P(val);
 		}
 		
+		entry = ecalloc(1, sizeof(async_channel_group_entry));
+		
+		entry->it = it;
+		entry->group = group;
+		entry->index = group->count;
+		entry->refcount = 1;
+		entry->watch.entry = entry;
+		entry->ready.entry = entry;
+		
 		if (k == NULL) {
-			ZVAL_LONG(&group->entries[group->count].key, h);
+			ZVAL_LONG(&entry->key, h);
 		} else {
-			ZVAL_STR_COPY(&group->entries[group->count].key, k);
+			ZVAL_STR_COPY(&entry->key, k);
 		}
 		
-		group->count++;
+		ASYNC_LIST_APPEND(&it->state->watchers, &entry->watch);
+		
+		group->entries[group->count++] = entry;
 	} ZEND_HASH_FOREACH_END();
+	
+	// Randomize the initial order, select uses round-robin rotation of ready channels after that.
+	if (shuffle && group->count > 1) {
+		shuffle_group(group);
+	}
+	
+	// Every channel is checked by the first select, later checks are triggered by channel events.
+	for (i = 0; i < group->count; i++) {
+		entry = group->entries[i];
+		entry->flags |= ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY;
+		
+		if (UNEXPECTED(Z_TYPE_P(&entry->it->state->error) != IS_UNDEF)) {
+			ASYNC_LIST_PREPEND(&group->ready, &entry->ready);
+		} else {
+			ASYNC_LIST_APPEND(&group->ready, &entry->ready);
+		}
+	}
 }
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_channel_group_count, 0, 0, 0)
@@ -761,50 +1207,16 @@ static PHP_METHOD(ChannelGroup, count)
 	RETURN_LONG(group->count);
 }
 
-ASYNC_CALLBACK continue_select_cb(async_op *op)
-{
-	async_channel_group *group;
-	async_channel_group_entry *entry;
-	
-	group = (async_channel_group *) op->arg;
-	entry = (async_channel_group_entry *) op;
-	
-	group->select.pending--;
-	
-	entry->it->flags &= ~ASYNC_CHANNEL_ITERATOR_FLAG_FETCHING;
-	
-	if (UNEXPECTED(entry->it->state->flags & ASYNC_CHANNEL_FLAG_CLOSED)) {
-		group->flags |= ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED;
-	}
-	
-	if (UNEXPECTED(op->status == ASYNC_STATUS_FAILED)) {
-		group->select.entry = entry;
-		
-		ASYNC_FAIL_OP(&group->select, &op->result);
-		
-		return;
-	}
-	
-	if (UNEXPECTED(entry->it->state->flags & ASYNC_CHANNEL_FLAG_CLOSED)) {
-		if (group->select.pending == 0) {
-			ASYNC_FINISH_OP(&group->select);
-		}
-		
-		return;
-	}
-	
-	group->select.entry = entry;
-	
-	ASYNC_RESOLVE_OP(&group->select, &op->result);
-}
-
 ASYNC_CALLBACK timeout_select(uv_timer_t *timer)
 {
 	async_channel_group *group;
 	
 	group = (async_channel_group *) timer->data;
+	group->flags |= ASYNC_CHANNEL_GROUP_FLAG_TIMEOUT;
 	
-	ASYNC_FINISH_OP(&group->select);
+	if (group->select.status == ASYNC_STATUS_RUNNING) {
+		ASYNC_FINISH_OP(&group->select);
+	}
 }
 
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_channel_group_select, 0, 0, Concurrent\\ChannelSelect, 1)
@@ -816,17 +1228,14 @@ static PHP_METHOD(ChannelGroup, select)
 	async_channel_group *group;
 	async_channel_select *select;
 	async_channel_group_entry *entry;
-	async_channel_group_entry *first;
 	async_channel_state *state;
+	async_channel_link *link;
 	async_context *context;
 	
 	zend_long timeout;
 	zval *millis;
 	zval tmp;
 	
-	uint32_t i;
-	uint32_t j;
-	
 	millis = NULL;
 	
 	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 1)
@@ -844,124 +1253,86 @@ static PHP_METHOD(ChannelGroup, select)
 	
 	group = (async_channel_group *) Z_OBJ_P(getThis());
 	
-	if (group->flags & ASYNC_CHANNEL_GROUP_FLAG_SHUFFLE) {
-		shuffle_group(group);
-	}
+	ASYNC_CHECK_ERROR(group->select.status == ASYNC_STATUS_RUNNING, "Cannot select while another select is pending");
 	
-	for (first = NULL, i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
-		state = entry->it->state;
-		
-		if (ASYNC_CHANNEL_READABLE_NONBLOCK(state)) {
-			if (first == NULL) {
-				first = entry;
+	context = NULL;
+	select = NULL;
+	
+	while (1) {
+		// Channels that remain readable are moved to the end of the queue to rotate between them.
+		while (group->ready.first != NULL) {
+			ASYNC_LIST_EXTRACT_FIRST(&group->ready, link);
+			
+			entry = link->entry;
+			entry->flags &= ~ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY;
+			
+			state = entry->it->state;
+			
+			if (fetch_noblock(state, &tmp) == SUCCESS) {
+				if (ASYNC_CHANNEL_READABLE_NONBLOCK(state) || (state->flags & ASYNC_CHANNEL_FLAG_CLOSED)) {
+					entry->flags |= ASYNC_CHANNEL_GROUP_ENTRY_FLAG_READY;
+					
+					ASYNC_LIST_APPEND(&group->ready, &entry->ready);
+				}
+				
+				select = async_channel_select_object_create(&entry->key, &tmp);
+				
+				zval_ptr_dtor(&tmp);
+				break;
 			}
 			
-			continue;
+			// Closed channels are removed after their error has been forwarded.
+			if (state->flags & ASYNC_CHANNEL_FLAG_CLOSED) {
+				if (UNEXPECTED(Z_TYPE_P(&state->error) != IS_UNDEF)) {
+					forward_error(&state->error, execute_data);
+				}
+				
+				remove_entry(group, entry);
+				
+				if (UNEXPECTED(EG(exception))) {
+					break;
+				}
+			}
 		}
 		
-		// Perform error forwarding and inline compaction of the group.
-		if (state->flags & ASYNC_CHANNEL_FLAG_CLOSED) {
-			ASYNC_DELREF(&entry->it->std);
-			zval_ptr_dtor(&entry->key);
+		// No more channels left or non-blocking select early return.
+		if (select != NULL || EG(exception) || group->count == 0 || timeout == 0 || (group->flags & ASYNC_CHANNEL_GROUP_FLAG_TIMEOUT)) {
+			break;
+		}
 		
-			for (j = i + 1; j < group->count; j++) {
-				group->entries[j - 1] = group->entries[j];
-			}
+		if (context == NULL) {
+			context = async_context_get();
 			
-			group->count--;
-			i--;
+			if (!async_context_is_background(context)) {
+				ASYNC_BUSY_ENTER(group->scheduler);
+			}
 			
-			if (UNEXPECTED(Z_TYPE_P(&state->error) != IS_UNDEF)) {
-				forward_error(&state->error, execute_data);
-				return;
+			if (timeout > 0) {
+				uv_timer_start(&group->timer, timeout_select, timeout, 0);
 			}
 		}
-	}
-	
-	// Perform a non-blocking select if a channel is ready.
-	if (first != NULL && fetch_noblock(first->it->state, &tmp) == SUCCESS) {
-		select = async_channel_select_object_create(&first->key, &tmp);
-		
-		zval_ptr_dtor(&tmp);
 		
-		RETURN_OBJ(&select->std);
-	}
-	
-	// No more channels left or non-blocking select early return.
-	if (group->count == 0 || timeout == 0) {
-		return;
-	}
-	
-	// Register select operations with input channels and start the race.
-	group->select.base.status = ASYNC_STATUS_PENDING;
-	group->select.base.flags = 0;
-	
-	group->select.pending = group->count;
-	group->select.entry = NULL;
-	
-	for (i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
-	
-		entry->base.status = ASYNC_STATUS_RUNNING;
-		entry->base.flags = 0;
-		entry->base.callback = continue_select_cb;
-		entry->base.arg = group;
-	
-		ASYNC_APPEND_OP(&entry->it->state->receivers, entry);
+		if (async_await_op(&group->select) == FAILURE) {
+			ASYNC_FORWARD_OP_ERROR(&group->select);
+			ASYNC_RESET_OP(&group->select);
+			
+			break;
+		}
 		
-		entry->it->flags |= ASYNC_CHANNEL_ITERATOR_FLAG_FETCHING;
+		ASYNC_RESET_OP(&group->select);
 	}
 	
-	context = async_context_get();
-	
-	if (!async_context_is_background(context)) {
-		ASYNC_BUSY_ENTER(group->scheduler);
-	}
-	
-	if (timeout > 0) {
-		uv_timer_start(&group->timer, timeout_select, timeout, 0);
-	}
-	
-	if (async_await_op((async_op *) &group->select) == FAILURE) {
-		forward_error(&group->select.base.result, execute_data);
-	}
-	
-	if (timeout > 0) {
-		uv_timer_stop(&group->timer);
-	}
-	
-	if (!async_context_is_background(context)) {
-		ASYNC_BUSY_EXIT(group->scheduler);
-	}
-	
-	// Populate return values.
-	if (EXPECTED(EG(exception) == NULL) && group->select.entry != NULL) {
-		select = async_channel_select_object_create(&group->select.entry->key, &group->select.base.result);
-	} else {
-		select = NULL;
-	}
-	
-	// Cleanup pending operations.
-	for (i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
-		
-		zval_ptr_dtor(&entry->base.result);
-		
-		if (entry->base.list) {
-			entry->it->flags &= ~ASYNC_CHANNEL_ITERATOR_FLAG_FETCHING;
-		
-			ASYNC_LIST_REMOVE(&entry->it->state->receivers, (async_op *) entry);
+	if (context != NULL) {
+		if (timeout > 0) {
+			uv_timer_stop(&group->timer);
 		}
-	}
-	
-	if (group->flags & ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED) {
-		group->flags &= ~ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED;
 		
-		compact_group(group, group->select.entry);
+		if (!async_context_is_background(context)) {
+			ASYNC_BUSY_EXIT(group->scheduler);
+		}
 	}
 	
-	zval_ptr_dtor(&group->select.base.result);
+	group->flags &= ~ASYNC_CHANNEL_GROUP_FLAG_TIMEOUT;
 	
 	if (EXPECTED(select != NULL)) {
 		RETURN_OBJ(&select->std);
@@ -1058,8 +1429,8 @@ static PHP_METHOD(ChannelGroup, send)
 	zval *millis;
 	zval *val;
 		
+	uint32_t offset;
 	uint32_t i;
-	uint32_t j;
 	
 	millis = NULL;
 	
@@ -1079,13 +1450,16 @@ static PHP_METHOD(ChannelGroup, send)
 	
 	group = (async_channel_group *) Z_OBJ_P(getThis());
 	
-	if (group->flags & ASYNC_CHANNEL_GROUP_FLAG_SHUFFLE) {
-		shuffle_group(group);
+	// Rotate the first channel to be considered instead of shuffling all channels.
+	if ((group->flags & ASYNC_CHANNEL_GROUP_FLAG_SHUFFLE) && group->count > 0) {
+		offset = group->next++ % group->count;
+	} else {
+		offset = 0;
 	}
 	
 	// Check for writable channels first.
 	for (first = NULL, i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
+		entry = group->entries[(offset + i) % group->count];
 		state = entry->it->state;
 		
 		if (first == NULL) {
@@ -1096,24 +1470,15 @@ static PHP_METHOD(ChannelGroup, send)
 			}
 		}
 		
-		// Perform inline compaction of the group.
+		// Remove the closed channel from the group.
 		if (state->flags & ASYNC_CHANNEL_FLAG_CLOSED) {
-			ASYNC_DELREF(&entry->it->std);
-			zval_ptr_dtor(&entry->key);
-			
-			for (j = i + 1; j < group->count; j++) {
-				group->entries[j - 1] = group->entries[j];
-			}
-			
-			group->count--;
-			i--;
-			
 			if (UNEXPECTED(Z_TYPE_P(&state->error) != IS_UNDEF)) {
 				forward_error(&state->error, execute_data);
-				return;
+			} else {
+				zend_throw_exception(async_channel_closed_exception_ce, "Channel has been closed", 0);
 			}
 			
-			zend_throw_exception(async_channel_closed_exception_ce, "Channel has been closed", 0);
+			remove_entry(group, entry);
 			return;
 		}
 	}
@@ -1126,10 +1491,7 @@ static PHP_METHOD(ChannelGroup, send)
 			ASYNC_NEXT_OP(&state->receivers, receiver);
 			ASYNC_RESOLVE_OP(receiver, val);	
 		} else {
-			ZVAL_COPY(&state->buffer.data[state->buffer.wpos], val);
-			
-			state->buffer.wpos = (state->buffer.wpos + 1) % state->buffer.size;
-			state->buffer.len++;
+			push_buffer(state, val);
 		}
 		
 		RETURN_ZVAL(&first->key, 1, 0);
@@ -1147,7 +1509,8 @@ static PHP_METHOD(ChannelGroup, send)
 	op = (async_channel_send_op *) ((char *) send + XtOffsetOf(async_channel_group_send_op, sends));
 	
 	for (i = 0; i < group->count; i++) {
-		entry = &group->entries[i];
+		entry = group->entries[i];
+		state = entry->it->state;
 		
 		ZVAL_ZVAL(&op->value, val, 0, 0);
 		
@@ -1156,7 +1519,14 @@ static PHP_METHOD(ChannelGroup, send)
 		op->base.callback = continue_send_cb;
 		op->base.arg = send;
 		
-		ASYNC_APPEND_OP(&entry->it->state->senders, op);
+		// Entries may be removed from the group by other tasks while the send is pending.
+		entry->refcount++;
+		
+		ASYNC_APPEND_OP(&state->senders, op);
+		
+		if (state->watchers.first != NULL) {
+			notify_watchers(state);
+		}
 		
 		op++;
 	}
@@ -1186,6 +1556,10 @@ static PHP_METHOD(ChannelGroup, send)
 		ZVAL_COPY(return_value, &send->entry->key);
 	}
 	
+	if (send->flags & ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED) {
+		compact_group(group, send->entry);
+	}
+	
 	op = (async_channel_send_op *) ((char *) send + XtOffsetOf(async_channel_group_send_op, sends));
 	
 	for (i = 0; i < send->count; i++) {
@@ -1194,14 +1568,12 @@ static PHP_METHOD(ChannelGroup, send)
 		if (op->base.list) {
 			ASYNC_LIST_REMOVE(&op->entry->it->state->senders, (async_op *) op);
 		}
+		
+		delref_entry(op->entry);
 	
 		op++;
 	}
 	
-	if (send->flags & ASYNC_CHANNEL_GROUP_FLAG_CHECK_CLOSED) {
-		compact_group(group, send->entry);
-	}
-	
 	if (timeout > 0) {
 		ASYNC_UV_CLOSE(&send->timer, dispose_send_timer_cb);
 	} else {
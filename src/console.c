@@ -695,7 +695,7 @@ ASYNC_CALLBACK write_fs_cb(uv_fs_t *req)
 	ASYNC_FINISH_OP(op);
 }
 
-static PHP_METHOD(WritablePipe, write)
+static void write_pipe(zend_string *data, INTERNAL_FUNCTION_PARAMETERS)
 {
 	async_writable_pipe *pipe;
 	async_stream *stream;
@@ -705,13 +705,8 @@ static PHP_METHOD(WritablePipe, write)
 	uv_buf_t bufs[1];
 	uv_fs_t req;
 	
-	zend_string *data;
 	int code;
 	
-	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
-		Z_PARAM_STR(data)
-	ZEND_PARSE_PARAMETERS_END();
-	
 	pipe = (async_writable_pipe *) Z_OBJ_P(getThis());
 	
 	if (UNEXPECTED(Z_TYPE_P(&pipe->error) != IS_UNDEF)) {
@@ -768,6 +763,34 @@ static PHP_METHOD(WritablePipe, write)
 	}
 }
 
+static PHP_METHOD(WritablePipe, write)
+{
+	zend_string *data;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_STR(data)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	write_pipe(data, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+
+static PHP_METHOD(WritablePipe, writeAll)
+{
+	HashTable *chunks;
+	zend_string *data;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ARRAY_HT(chunks)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	// Chunks are joined into a single write, console streams do not use vectored writes.
+	if (EXPECTED(NULL != (data = async_stream_join_chunks(chunks)))) {
+		write_pipe(data, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+		
+		zend_string_release(data);
+	}
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_CTOR(WritablePipe, async_writable_pipe_ce)
 ASYNC_METHOD_NO_WAKEUP(WritablePipe, async_writable_pipe_ce)
@@ -781,6 +804,7 @@ static const zend_function_entry async_writable_pipe_functions[] = {
 	PHP_ME(WritablePipe, isTerminal, arginfo_writable_console_stream_is_terminal, ZEND_ACC_PUBLIC)
 	PHP_ME(WritablePipe, close, arginfo_stream_close, ZEND_ACC_PUBLIC)
 	PHP_ME(WritablePipe, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(WritablePipe, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
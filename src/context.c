@@ -19,6 +19,7 @@
 #include "php_async.h"
 
 #include "async/fiber.h"
+#include "async/wheel.h"
 
 ASYNC_API zend_class_entry *async_context_ce;
 ASYNC_API zend_class_entry *async_context_var_ce;
@@ -29,7 +30,7 @@ static zend_object_handlers async_context_handlers;
 static zend_object_handlers async_context_var_handlers;
 static zend_object_handlers async_cancellation_handler_handlers;
 
-static async_context *async_context_object_create(async_context_var *var, zval *value);
+static async_context *async_context_object_create(async_context_vars *vars);
 static async_cancellation_handler *async_cancellation_handler_object_create(async_context_cancellation *cancel);
 
 
@@ -90,9 +91,10 @@ static zend_always_inline async_context *create_cancellable_context(async_contex
 	
 	ZEND_ASSERT(parent->output.context != NULL);
 	
-	context = async_context_object_create(NULL, NULL);
+	context = async_context_object_create(parent->vars);
 	context->parent = parent;
 	context->flags = parent->flags;
+	context->priority = parent->priority;
 	context->output.context = parent->output.context;
 	context->cancel = cancel;
 	
@@ -117,13 +119,9 @@ static zend_always_inline async_context *create_cancellable_context(async_contex
 	return context;
 }
 
-ASYNC_CALLBACK close_timeout(uv_handle_t *handle)
+static zend_always_inline void dispose_timeout(async_context_timeout *cancel)
 {
-	async_context_timeout *cancel;
-
-	cancel = (async_context_timeout *) handle->data;
-
-	ZEND_ASSERT(cancel != NULL);
+	async_timer_wheel_stop(&cancel->scheduler->timers, &cancel->timer);
 	
 	async_task_scheduler_unref(cancel->scheduler);
 
@@ -141,13 +139,13 @@ static zend_always_inline void release_cancellation(async_context_cancellation *
 	}
 	
 	if (cancel->flags & ASYNC_CONTEXT_CANCELLATION_FLAG_TIMEOUT) {
-		ASYNC_UV_TRY_CLOSE(&((async_context_timeout *) cancel)->timer, close_timeout);
+		dispose_timeout((async_context_timeout *) cancel);
 	} else {
 		efree(cancel);
 	}
 }
 
-ASYNC_CALLBACK timed_out(uv_timer_t *timer)
+ASYNC_CALLBACK timed_out(async_wheel_timer *timer)
 {
 	async_context_cancellation *cancel;
 	async_cancel_cb *callback;
@@ -169,12 +167,118 @@ ASYNC_CALLBACK timed_out(uv_timer_t *timer)
 
 		callback->func(callback->object, &cancel->error);
 	}
+}
+
+
+static zend_always_inline void release_vars(async_context_vars *vars)
+{
+	async_context_binding *binding;
+	uint32_t i;
+
+	if (--vars->refcount != 0) {
+		return;
+	}
+	
+	for (i = 0; i < vars->count; i++) {
+		binding = &vars->bindings[i];
+		
+		ASYNC_DELREF(&binding->var->std);
+		zval_ptr_dtor(&binding->value);
+	}
+	
+	efree(vars);
+}
+
+/* Binary search for the binding of the given var, returns the insert position if the var is not bound. */
+static zend_always_inline uint32_t search_binding(async_context_vars *vars, async_context_var *var, zend_bool *found)
+{
+	uint32_t low;
+	uint32_t high;
+	uint32_t mid;
+	
+	low = 0;
+	high = vars->count;
+	
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		
+		if (vars->bindings[mid].var == var) {
+			*found = 1;
+			
+			return mid;
+		}
+		
+		if ((uintptr_t) vars->bindings[mid].var < (uintptr_t) var) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	
+	*found = 0;
+	
+	return low;
+}
+
+/* Copies the bindings of a parent context, leaving room for the given number of additional bindings. */
+static async_context_vars *copy_vars(async_context_vars *parent, uint32_t capacity)
+{
+	async_context_vars *vars;
+	async_context_binding *binding;
+	uint32_t i;
+	
+	if (parent != NULL) {
+		capacity += parent->count;
+	}
+	
+	ZEND_ASSERT(capacity > 0);
+	
+	vars = emalloc(sizeof(async_context_vars) + sizeof(async_context_binding) * (capacity - 1));
+	vars->refcount = 1;
+	vars->count = 0;
+	
+	if (parent != NULL) {
+		for (i = 0; i < parent->count; i++) {
+			binding = &vars->bindings[i];
+			binding->var = parent->bindings[i].var;
+			
+			ASYNC_ADDREF(&binding->var->std);
+			ZVAL_COPY(&binding->value, &parent->bindings[i].value);
+		}
+		
+		vars->count = parent->count;
+	}
 	
-	release_cancellation(cancel);
+	return vars;
 }
 
+/* Binds a var in bindings that have not been shared yet (replaces an existing binding of the same var). */
+static void bind_var(async_context_vars *vars, async_context_var *var, zval *value)
+{
+	async_context_binding *binding;
+	uint32_t pos;
+	zend_bool found;
+	
+	ZEND_ASSERT(vars->refcount == 1);
+	
+	pos = search_binding(vars, var, &found);
+	binding = &vars->bindings[pos];
+	
+	if (found) {
+		zval_ptr_dtor(&binding->value);
+	} else {
+		memmove(binding + 1, binding, sizeof(async_context_binding) * (vars->count - pos));
+		
+		binding->var = var;
+		ASYNC_ADDREF(&var->std);
+		
+		vars->count++;
+	}
+	
+	ZVAL_COPY(&binding->value, value);
+}
 
-static async_context *async_context_object_create(async_context_var *var, zval *value)
+static async_context *async_context_object_create(async_context_vars *vars)
 {
 	async_context *context;
 
@@ -182,16 +286,12 @@ static async_context *async_context_object_create(async_context_var *var, zval *
 
 	zend_object_std_init(&context->std, async_context_ce);
 	context->std.handlers = &async_context_handlers;
+	
+	context->priority = ASYNC_TASK_PRIORITY_NORMAL;
 
-	if (var != NULL) {
-		context->var = var;
-		ASYNC_ADDREF(&var->std);
-	}
-
-	if (value == NULL) {
-		ZVAL_NULL(&context->value);
-	} else {
-		ZVAL_COPY(&context->value, value);
+	if (vars != NULL) {
+		context->vars = vars;
+		vars->refcount++;
 	}
 
 	return context;
@@ -204,11 +304,9 @@ static void async_context_object_destroy(zend_object *object)
 
 	context = (async_context *) object;
 
-	if (context->var != NULL) {
-		ASYNC_DELREF(&context->var->std);
+	if (context->vars != NULL) {
+		release_vars(context->vars);
 	}
-
-	zval_ptr_dtor(&context->value);
 	
 	if (context->cancel != NULL) {
 		release_cancellation(context->cancel);
@@ -252,6 +350,20 @@ static PHP_METHOD(Context, isCancelled)
 	RETURN_BOOL(context->cancel != NULL && context->cancel->flags & ASYNC_CONTEXT_CANCELLATION_FLAG_TRIGGERED);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_context_get_priority, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(Context, getPriority)
+{
+	async_context *context;
+
+	ZEND_PARSE_PARAMETERS_NONE();
+
+	context = (async_context *) Z_OBJ_P(getThis());
+
+	RETURN_LONG(context->priority);
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_context_with, 0, 2, Concurrent\\Context, 0)
 	ZEND_ARG_OBJ_INFO(0, var, Concurrent\\ContextVar, 0)
 	ZEND_ARG_INFO(0, value)
@@ -262,6 +374,7 @@ static PHP_METHOD(Context, with)
 	async_context *context;
 	async_context *current;
 	async_context_var *var;
+	async_context_vars *vars;
 
 	zval *key;
 	zval *value;
@@ -275,11 +388,90 @@ static PHP_METHOD(Context, with)
 	var = (async_context_var *) Z_OBJ_P(key);
 	
 	ZEND_ASSERT(current->output.context != NULL);
+	
+	vars = copy_vars(current->vars, 1);
+	bind_var(vars, var, value);
+
+	context = async_context_object_create(NULL);
+	context->parent = current;
+	context->flags = current->flags;
+	context->priority = current->priority;
+	context->output.context = current->output.context;
+	context->vars = vars;
+	
+	propagate_cancellation(current, context);
+
+	ASYNC_ADDREF(&current->std);
+
+	RETURN_OBJ(&context->std);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_context_with_many, 0, 1, Concurrent\\Context, 0)
+	ZEND_ARG_TYPE_INFO(0, bindings, IS_ARRAY, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(Context, withMany)
+{
+	async_context *context;
+	async_context *current;
+	async_context_vars *vars;
+
+	HashTable *map;
+	zval *entry;
+	zval *key;
+	zval *value;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ARRAY_HT(map)
+	ZEND_PARSE_PARAMETERS_END();
+
+	current = (async_context *) Z_OBJ_P(getThis());
+	
+	ZEND_ASSERT(current->output.context != NULL);
+	
+	if (zend_hash_num_elements(map) == 0) {
+		vars = current->vars;
+		
+		if (vars != NULL) {
+			vars->refcount++;
+		}
+	} else {
+		vars = copy_vars(current->vars, zend_hash_num_elements(map));
+		
+		ZEND_HASH_FOREACH_VAL(map, entry) {
+			ZVAL_DEREF(entry);
+			
+			key = NULL;
+			value = NULL;
+			
+			if (EXPECTED(Z_TYPE_P(entry) == IS_ARRAY)) {
+				key = zend_hash_index_find(Z_ARRVAL_P(entry), 0);
+				value = zend_hash_index_find(Z_ARRVAL_P(entry), 1);
+			}
+			
+			if (key != NULL) {
+				ZVAL_DEREF(key);
+			}
+			
+			if (UNEXPECTED(key == NULL || value == NULL || Z_TYPE_P(key) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(key), async_context_var_ce))) {
+				release_vars(vars);
+			
+				zend_throw_error(NULL, "Context vars must be bound using [ContextVar, value] pairs");
+				return;
+			}
+			
+			ZVAL_DEREF(value);
+			
+			bind_var(vars, (async_context_var *) Z_OBJ_P(key), value);
+		} ZEND_HASH_FOREACH_END();
+	}
 
-	context = async_context_object_create(var, value);
+	context = async_context_object_create(NULL);
 	context->parent = current;
 	context->flags = current->flags;
+	context->priority = current->priority;
 	context->output.context = current->output.context;
+	context->vars = vars;
 	
 	propagate_cancellation(current, context);
 
@@ -302,9 +494,10 @@ static PHP_METHOD(Context, withIsolatedOutput)
 	
 	ZEND_ASSERT(current->output.context != NULL);
 	
-	context = async_context_object_create(NULL, NULL);
+	context = async_context_object_create(current->vars);
 	context->parent = current;
 	context->flags = current->flags;
+	context->priority = current->priority;
 	context->output.context = context;
 	
 	propagate_cancellation(current, context);
@@ -335,12 +528,10 @@ static PHP_METHOD(Context, withTimeout)
 	
 	context = create_cancellable_context((async_context_cancellation *) cancel, parent);
 	
-	uv_timer_init(&cancel->scheduler->loop, &cancel->timer);
-
+	cancel->timer.func = timed_out;
 	cancel->timer.data = cancel;
 
-	uv_timer_start(&cancel->timer, timed_out, (uint64_t) timeout, 0);
-	uv_unref((uv_handle_t *) &cancel->timer);
+	async_timer_wheel_start(&cancel->scheduler->timers, &cancel->timer, (uint64_t) MAX(0, timeout));
 
 	RETURN_OBJ(&context->std);
 }
@@ -373,6 +564,40 @@ static PHP_METHOD(Context, withCancel)
 	RETURN_OBJ(&context->std);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_context_with_priority, 0, 1, Concurrent\\Context, 0)
+	ZEND_ARG_TYPE_INFO(0, priority, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(Context, withPriority)
+{
+	async_context *context;
+	async_context *current;
+
+	zend_long priority;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_LONG(priority)
+	ZEND_PARSE_PARAMETERS_END();
+
+	ASYNC_CHECK_ERROR(priority < ASYNC_TASK_PRIORITY_LOW || priority > ASYNC_TASK_PRIORITY_HIGH, "Invalid task priority: %d", (int) priority);
+
+	current = (async_context *) Z_OBJ_P(getThis());
+
+	ZEND_ASSERT(current->output.context != NULL);
+
+	context = async_context_object_create(current->vars);
+	context->parent = current;
+	context->flags = current->flags;
+	context->priority = (uint8_t) priority;
+	context->output.context = current->output.context;
+
+	propagate_cancellation(current, context);
+
+	ASYNC_ADDREF(&current->std);
+
+	RETURN_OBJ(&context->std);
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_context_shield, 0, 0, Concurrent\\Context, 0)
 ZEND_END_ARG_INFO();
 
@@ -387,9 +612,10 @@ static PHP_METHOD(Context, shield)
 	
 	ZEND_ASSERT(prev->output.context != NULL);
 
-	context = async_context_object_create(NULL, NULL);
+	context = async_context_object_create(prev->vars);
 	context->parent = prev;
 	context->flags = prev->flags;
+	context->priority = prev->priority;
 	context->output.context = prev->output.context;
 
 	ASYNC_ADDREF(&prev->std);
@@ -510,10 +736,13 @@ static const zend_function_entry async_context_functions[] = {
 	PHP_ME(Context, __construct, arginfo_no_ctor, ZEND_ACC_PRIVATE)
 	PHP_ME(Context, __wakeup, arginfo_no_wakeup, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, isCancelled, arginfo_context_is_cancelled, ZEND_ACC_PUBLIC)
+	PHP_ME(Context, getPriority, arginfo_context_get_priority, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, with, arginfo_context_with, ZEND_ACC_PUBLIC)
+	PHP_ME(Context, withMany, arginfo_context_with_many, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, withIsolatedOutput, arginfo_context_with_isolated_output, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, withTimeout, arginfo_context_with_timeout, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, withCancel, arginfo_context_with_cancel, ZEND_ACC_PUBLIC)
+	PHP_ME(Context, withPriority, arginfo_context_with_priority, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, shield, arginfo_context_shield, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, throwIfCancelled, arginfo_context_throw_if_cancelled, ZEND_ACC_PUBLIC)
 	PHP_ME(Context, run, arginfo_context_run, ZEND_ACC_PUBLIC)
@@ -560,6 +789,9 @@ static PHP_METHOD(ContextVar, get)
 {
 	async_context_var *var;
 	async_context *context;
+	
+	zend_bool found;
+	uint32_t pos;
 
 	zval *val;
 
@@ -578,13 +810,13 @@ static PHP_METHOD(ContextVar, get)
 		context = (async_context *) Z_OBJ_P(val);
 	}
 
-	do {
-		if (context->var == var) {
-			RETURN_ZVAL(&context->value, 1, 0);
+	if (context->vars != NULL) {
+		pos = search_binding(context->vars, var, &found);
+		
+		if (found) {
+			RETURN_ZVAL(&context->vars->bindings[pos].value, 1, 0);
 		}
-
-		context = context->parent;
-	} while (context != NULL);
+	}
 }
 
 //LCOV_EXCL_START
@@ -731,7 +963,7 @@ void async_context_init()
 {
 	async_context *context;
 	
-	context = async_context_object_create(NULL, NULL);
+	context = async_context_object_create(NULL);
 	
 	context->output.context = context;
 	context->output.handler = emalloc(sizeof(zend_output_globals));
@@ -739,7 +971,7 @@ void async_context_init()
 	ASYNC_G(context) = context;
 	ASYNC_G(foreground) = context;
 	
-	context = async_context_object_create(NULL, NULL);
+	context = async_context_object_create(NULL);
 	context->flags |= ASYNC_CONTEXT_FLAG_BACKGROUND;
 	
 	context->output.context = ASYNC_G(foreground);
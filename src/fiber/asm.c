@@ -115,8 +115,13 @@ zend_bool async_fiber_init(async_fiber *fiber, async_context *context, async_fib
 
 	ZEND_ASSERT(impl->initialized == 0);
 
-	if (UNEXPECTED(!async_fiber_stack_allocate(&impl->stack, stack_size))) {
-		return 0;
+	// Recycled fibers keep their stack if the size matches.
+	if (impl->stack.pointer == NULL || impl->stack.size != ASYNC_FIBER_STACK_SIZE(stack_size)) {
+		async_fiber_stack_free(&impl->stack);
+
+		if (UNEXPECTED(!async_fiber_stack_allocate(&impl->stack, stack_size, ASYNC_G(stack_lazy) ? ASYNC_FIBER_STACK_FLAG_LAZY : 0))) {
+			return 0;
+		}
 	}
 
 	if (UNEXPECTED(!record_size)) {
@@ -142,6 +147,39 @@ zend_bool async_fiber_init(async_fiber *fiber, async_context *context, async_fib
 	return 1;
 }
 
+zend_bool async_fiber_reset(async_fiber *fiber, int trim)
+{
+	async_fiber_asm *impl;
+
+	impl = (async_fiber_asm *) fiber;
+
+	if (UNEXPECTED(impl->root || impl->stack.pointer == NULL)) {
+		return 0;
+	}
+
+	async_fiber_stack_trim(&impl->stack, trim);
+
+	memset(&impl->base, 0, sizeof(async_fiber));
+
+	impl->ctx = NULL;
+	impl->initialized = 0;
+
+	return 1;
+}
+
+size_t async_fiber_stack_usage(async_fiber *fiber)
+{
+	async_fiber_asm *impl;
+
+	impl = (async_fiber_asm *) fiber;
+
+	if (UNEXPECTED(impl->root)) {
+		return 0;
+	}
+
+	return async_fiber_stack_used(&impl->stack);
+}
+
 void async_fiber_destroy(async_fiber *fiber)
 {
 	async_fiber_asm *impl;
@@ -149,7 +187,7 @@ void async_fiber_destroy(async_fiber *fiber)
 	impl = (async_fiber_asm *) fiber;
 
 	if (EXPECTED(impl != NULL)) {
-		if (EXPECTED(!impl->root && impl->initialized)) {
+		if (EXPECTED(!impl->root)) {
 			async_fiber_stack_free(&impl->stack);
 		}
 
@@ -0,0 +1,130 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) Martin Schröder 2019                                   |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  | Authors: Martin Schröder <m.schroeder2007@gmail.com>                 |
+  +----------------------------------------------------------------------+
+*/
+
+#include "php_async.h"
+
+#include "async/fiber.h"
+#include "async/stack.h"
+
+/* Takes a fiber (with an allocated C stack) from the pool or creates a new fiber if the pool is empty. */
+async_fiber *async_fiber_pool_acquire(async_fiber_pool *pool)
+{
+	async_fiber *fiber;
+
+	if (pool->first == NULL) {
+		pool->misses++;
+
+		return async_fiber_create();
+	}
+
+	ASYNC_LIST_EXTRACT_FIRST(pool, fiber);
+
+	pool->size--;
+	pool->hits++;
+
+	return fiber;
+}
+
+/* Puts a terminated fiber back into the pool, fibers are destroyed if the pool has reached the configured size. */
+void async_fiber_pool_release(async_fiber_pool *pool, async_fiber *fiber)
+{
+	int trim;
+
+	ZEND_ASSERT(fiber != NULL);
+	ZEND_ASSERT(!(fiber->flags & ASYNC_FIBER_FLAG_QUEUED));
+
+	// Stack usage tracking needs untouched pages, so pooled stacks must be discarded.
+	if (UNEXPECTED(ASYNC_G(stack_usage))) {
+		trim = ASYNC_FIBER_STACK_TRIM_DISCARD;
+	} else {
+		trim = ASYNC_G(fiber_pool_trim) ? ASYNC_FIBER_STACK_TRIM_LAZY : ASYNC_FIBER_STACK_TRIM_NONE;
+	}
+
+	if (pool->size < (uint32_t) ASYNC_G(fiber_pool_size) && async_fiber_reset(fiber, trim)) {
+		// Fibers are reused in LIFO order because the most recently used stack is likely to be hot.
+		ASYNC_LIST_PREPEND(pool, fiber);
+
+		pool->size++;
+
+		return;
+	}
+
+	pool->discarded++;
+
+	async_fiber_destroy(fiber);
+}
+
+/* Takes an initial VM stack page for a task from the pool or allocates a new page. */
+zend_vm_stack async_fiber_pool_acquire_vm_stack(async_fiber_pool *pool)
+{
+	zend_vm_stack stack;
+
+	if (pool->pages == NULL) {
+		return (zend_vm_stack) emalloc(ASYNC_FIBER_VM_STACK_SIZE);
+	}
+
+	stack = pool->pages;
+
+	pool->pages = stack->prev;
+	pool->page_count--;
+
+	return stack;
+}
+
+/* Releases a VM stack page chain, the initial page is kept for reuse if the pool has not reached the configured size. */
+void async_fiber_pool_release_vm_stack(async_fiber_pool *pool, zend_vm_stack stack)
+{
+	zend_vm_stack prev;
+
+	while (stack->prev != NULL) {
+		prev = stack->prev;
+		efree(stack);
+		stack = prev;
+	}
+
+	if (pool->page_count < (uint32_t) ASYNC_G(fiber_pool_size)) {
+		stack->prev = pool->pages;
+
+		pool->pages = stack;
+		pool->page_count++;
+	} else {
+		efree(stack);
+	}
+}
+
+void async_fiber_pool_dispose(async_fiber_pool *pool)
+{
+	async_fiber *fiber;
+	zend_vm_stack stack;
+
+	while (pool->first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(pool, fiber);
+
+		async_fiber_destroy(fiber);
+	}
+
+	while (pool->pages != NULL) {
+		stack = pool->pages;
+		pool->pages = stack->prev;
+
+		efree(stack);
+	}
+
+	pool->size = 0;
+	pool->page_count = 0;
+}
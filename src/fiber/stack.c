@@ -29,21 +29,31 @@
 
 #include "async/stack.h"
 
-zend_bool async_fiber_stack_allocate(async_fiber_stack *stack, unsigned int size)
+zend_bool async_fiber_stack_allocate(async_fiber_stack *stack, unsigned int size, int flags)
 {
 	size_t msize;
 
-	stack->size = ((size_t) size + ASYNC_STACK_PAGESIZE - 1) / ASYNC_STACK_PAGESIZE * ASYNC_STACK_PAGESIZE;
+	stack->size = ASYNC_FIBER_STACK_SIZE(size);
 
 #ifdef HAVE_MMAP
 
 	void *pointer;
+	int mflags;
+
+	mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_NORESERVE
+	// Reserve address space only, memory is committed when a page is touched for the first time.
+	if (flags & ASYNC_FIBER_STACK_FLAG_LAZY) {
+		mflags |= MAP_NORESERVE;
+	}
+#endif
 
 	msize = stack->size + ASYNC_FIBER_GUARDPAGES * ASYNC_STACK_PAGESIZE;
-	pointer = mmap(0, msize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	pointer = mmap(0, msize, PROT_READ | PROT_WRITE | PROT_EXEC, mflags, -1, 0);
 
 	if (pointer == (void *) -1) {
-		pointer = mmap(0, msize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		pointer = mmap(0, msize, PROT_READ | PROT_WRITE, mflags, -1, 0);
 
 		if (pointer == (void *) -1) {
 			return 0;
@@ -74,6 +84,63 @@ zend_bool async_fiber_stack_allocate(async_fiber_stack *stack, unsigned int size
 	return 1;
 }
 
+/*
+ * Allows the kernel to reclaim physical pages of an unused stack, the mapping itself remains valid.
+ * Lazy mode prefers MADV_FREE, discard mode drops all pages immediately (required for usage tracking).
+ */
+void async_fiber_stack_trim(async_fiber_stack *stack, int mode)
+{
+#if defined(HAVE_MMAP) && (defined(MADV_FREE) || defined(MADV_DONTNEED))
+	if (stack->pointer != NULL && mode != ASYNC_FIBER_STACK_TRIM_NONE) {
+#ifdef MADV_FREE
+		if (mode == ASYNC_FIBER_STACK_TRIM_LAZY && 0 == madvise(stack->pointer, stack->size, MADV_FREE)) {
+			return;
+		}
+#endif
+
+#ifdef MADV_DONTNEED
+		madvise(stack->pointer, stack->size, MADV_DONTNEED);
+#endif
+	}
+#endif
+}
+
+/* Computes the high-water mark of stack usage based on the lowest page that is backed by physical memory. */
+size_t async_fiber_stack_used(async_fiber_stack *stack)
+{
+#if defined(HAVE_MMAP) && defined(HAVE_MINCORE)
+	unsigned char *vec;
+	size_t count;
+	size_t i;
+
+	if (UNEXPECTED(stack->pointer == NULL)) {
+		return 0;
+	}
+
+	count = stack->size / ASYNC_STACK_PAGESIZE;
+	vec = emalloc(count);
+
+	if (UNEXPECTED(0 != mincore(stack->pointer, stack->size, (void *) vec))) {
+		efree(vec);
+
+		return 0;
+	}
+
+	// Stacks grow downwards, the first resident page marks the deepest point reached so far.
+	for (i = 0; i < count; i++) {
+		if (vec[i] & 1) {
+			break;
+		}
+	}
+
+	efree(vec);
+
+	return (count - i) * ASYNC_STACK_PAGESIZE;
+#else
+	return 0;
+#endif
+}
+
 void async_fiber_stack_free(async_fiber_stack *stack)
 {
 	if (stack->pointer != NULL) {
@@ -93,6 +93,17 @@ zend_bool async_fiber_init(async_fiber *fiber, async_context *context, async_fib
 	return 1;
 }
 
+zend_bool async_fiber_reset(async_fiber *fiber, int trim)
+{
+	// Windows fibers cannot be restarted with a different start routine.
+	return 0;
+}
+
+size_t async_fiber_stack_usage(async_fiber *fiber)
+{
+	return 0;
+}
+
 void async_fiber_destroy(async_fiber *fiber)
 {
 	async_fiber_win32 *impl;
@@ -639,6 +639,15 @@ static PHP_METHOD(Pipe, write)
 	async_stream_call_write(pipe->astream, &pipe->write_error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 
+static PHP_METHOD(Pipe, writeAll)
+{
+	async_pipe *pipe;
+
+	pipe = (async_pipe *) Z_OBJ_P(getThis());
+
+	async_stream_call_write_all(pipe->astream, &pipe->write_error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+
 static PHP_METHOD(Pipe, getWriteQueueSize)
 {
 	async_pipe *pipe;
@@ -685,6 +694,7 @@ static const zend_function_entry async_pipe_functions[] = {
 	PHP_ME(Pipe, read, arginfo_readable_stream_read, ZEND_ACC_PUBLIC)
 	PHP_ME(Pipe, getReadableStream, arginfo_duplex_stream_get_readable_stream, ZEND_ACC_PUBLIC)
 	PHP_ME(Pipe, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(Pipe, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_ME(Pipe, getWriteQueueSize, arginfo_socket_get_write_queue_size, ZEND_ACC_PUBLIC)
 	PHP_ME(Pipe, getWritableStream, arginfo_duplex_stream_get_writable_stream, ZEND_ACC_PUBLIC)
 	PHP_ME(Pipe, export, arginfo_pipe_export, ZEND_ACC_PUBLIC)
@@ -897,19 +897,10 @@ static PHP_METHOD(WritablePipe, close)
 	}
 }
 
-static PHP_METHOD(WritablePipe, write)
+static void write_process_pipe(async_writable_process_pipe *pipe, zend_string *data, zval *ref)
 {
-	async_writable_process_pipe *pipe;
 	async_stream_write_req write;
 
-	zend_string *data;
-
-	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
-		Z_PARAM_STR(data)
-	ZEND_PARSE_PARAMETERS_END();
-
-	pipe = (async_writable_process_pipe *) Z_OBJ_P(getThis());
-
 	if (UNEXPECTED(Z_TYPE_P(&pipe->state->error) != IS_UNDEF)) {
 		ASYNC_FORWARD_ERROR(&pipe->state->error);
 		return;
@@ -971,7 +962,7 @@ static PHP_METHOD(WritablePipe, write)
 	write.in.len = ZSTR_LEN(data);
 	write.in.buffer = ZSTR_VAL(data);
 	write.in.str = data;
-	write.in.ref = getThis();
+	write.in.ref = ref;
 
 	if (UNEXPECTED(FAILURE == async_stream_write(pipe->state->stream, &write))) {
 		forward_stream_write_error(pipe->state->stream, &write);
@@ -984,6 +975,46 @@ static PHP_METHOD(WritablePipe, write)
 #endif
 }
 
+static PHP_METHOD(WritablePipe, write)
+{
+	zend_string *data;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_STR(data)
+	ZEND_PARSE_PARAMETERS_END();
+
+	write_process_pipe((async_writable_process_pipe *) Z_OBJ_P(getThis()), data, getThis());
+}
+
+static PHP_METHOD(WritablePipe, writeAll)
+{
+	async_writable_process_pipe *pipe;
+
+	pipe = (async_writable_process_pipe *) Z_OBJ_P(getThis());
+	
+#ifdef ZEND_WIN32
+	// Input of an interactive shell is rewritten line by line, chunks are joined into a single write.
+	if (pipe->state->process->flags & ASYNC_PROCESS_FLAG_INTERACTIVE_SHELL) {
+		HashTable *chunks;
+		zend_string *data;
+		
+		ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+			Z_PARAM_ARRAY_HT(chunks)
+		ZEND_PARSE_PARAMETERS_END();
+		
+		if (EXPECTED(NULL != (data = async_stream_join_chunks(chunks)))) {
+			write_process_pipe(pipe, data, getThis());
+			
+			zend_string_release(data);
+		}
+		
+		return;
+	}
+#endif
+
+	async_stream_call_write_all(pipe->state->stream, &pipe->state->error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_CTOR(WritablePipe, async_writable_process_pipe_ce)
 ASYNC_METHOD_NO_WAKEUP(WritablePipe, async_writable_process_pipe_ce)
@@ -994,6 +1025,7 @@ static const zend_function_entry async_writable_process_pipe_functions[] = {
 	PHP_ME(WritablePipe, __wakeup, arginfo_no_wakeup, ZEND_ACC_PUBLIC)
 	PHP_ME(WritablePipe, close, arginfo_stream_close, ZEND_ACC_PUBLIC)
 	PHP_ME(WritablePipe, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(WritablePipe, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
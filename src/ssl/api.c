@@ -33,6 +33,7 @@ static zend_string *str_protocol;
 static zend_string *str_cipher_name;
 static zend_string *str_cipher_bits;
 static zend_string *str_alpn_protocol;
+static zend_string *str_session_reused;
 
 
 static zend_always_inline async_tls_info *async_tls_info_obj(zend_object *object)
@@ -87,6 +88,28 @@ static zend_always_inline zend_string *create_alpn_proto_list(zval *protos, uint
 	return zend_string_init(buffer, size, 0);
 }
 
+/* Maps a protocol name (as reported by TlsInfo) to the protocol version, returns 0 if the protocol is not supported. */
+static int parse_protocol_version(zend_string *name)
+{
+	if (zend_string_equals_literal(name, "TLSv1.3")) {
+		return ASYNC_TLS_VERSION_1_3;
+	}
+	
+	if (zend_string_equals_literal(name, "TLSv1.2")) {
+		return ASYNC_TLS_VERSION_1_2;
+	}
+	
+	if (zend_string_equals_literal(name, "TLSv1.1")) {
+		return ASYNC_TLS_VERSION_1_1;
+	}
+	
+	if (zend_string_equals_literal(name, "TLSv1")) {
+		return ASYNC_TLS_VERSION_1_0;
+	}
+	
+	return 0;
+}
+
 static zend_always_inline void dispose_cert(async_tls_cert *cert)
 {
 	if (cert->host != NULL) {
@@ -108,13 +131,20 @@ static zend_always_inline void dispose_cert(async_tls_cert *cert)
 		zend_string_release(cert->passphrase);
 		cert->passphrase = NULL;
 	}
+}
+
+static void release_cert_chain(async_tls_cert *cert)
+{
+	async_tls_cert *next;
 	
-#ifdef HAVE_ASYNC_SSL
-	if (cert->ctx != NULL) {
-		SSL_CTX_free(cert->ctx);
-		cert->ctx = NULL;
+	while (cert != NULL && --cert->refcount == 0) {
+		next = cert->next;
+		
+		dispose_cert(cert);
+		efree(cert);
+		
+		cert = next;
 	}
-#endif
 }
 
 
@@ -155,6 +185,8 @@ async_tls_client_encryption *async_clone_client_encryption(async_tls_client_encr
 	if (encryption->cafile != NULL) {
 		result->cafile = zend_string_copy(encryption->cafile);
 	}
+	
+	result->max_version = encryption->max_version;
 
 	return result;
 }
@@ -169,6 +201,10 @@ static void async_tls_client_encryption_object_destroy(zend_object *object)
 		zend_string_release(encryption->settings.peer_name);
 	}
 	
+	if (encryption->settings.session_key != NULL) {
+		zend_string_release(encryption->settings.session_key);
+	}
+	
 	if (encryption->alpn != NULL) {
 		zend_string_release(encryption->alpn);
 	}
@@ -332,6 +368,31 @@ PHP_METHOD(TlsClientEncryption, withCertificateAuthorityFile)
 	RETURN_OBJ(&encryption->std);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tls_client_encryption_with_max_version, 0, 1, Concurrent\\Network\\TlsClientEncryption, 0)
+	ZEND_ARG_TYPE_INFO(0, version, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+PHP_METHOD(TlsClientEncryption, withMaxVersion)
+{
+	async_tls_client_encryption *encryption;
+	
+	zend_string *name;
+	int version;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_STR(name)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	version = parse_protocol_version(name);
+	
+	ASYNC_CHECK_ERROR(version == 0, "Unsupported TLS protocol version: %s", ZSTR_VAL(name));
+	
+	encryption = async_clone_client_encryption((async_tls_client_encryption *) Z_OBJ_P(getThis()));
+	encryption->max_version = version;
+	
+	RETURN_OBJ(&encryption->std);
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_WAKEUP(TlsClientEncryption, async_tls_client_encryption_ce)
 //LCOV_EXCL_STOP
@@ -344,6 +405,7 @@ static const zend_function_entry async_tls_client_encryption_functions[] = {
 	PHP_ME(TlsClientEncryption, withAlpnProtocols, arginfo_tls_client_encryption_with_alpn_protocols, ZEND_ACC_PUBLIC)
 	PHP_ME(TlsClientEncryption, withCertificateAuthorityPath, arginfo_tls_client_encryption_with_capath, ZEND_ACC_PUBLIC)
 	PHP_ME(TlsClientEncryption, withCertificateAuthorityFile, arginfo_tls_client_encryption_with_cafile, ZEND_ACC_PUBLIC)
+	PHP_ME(TlsClientEncryption, withMaxVersion, arginfo_tls_client_encryption_with_max_version, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -356,6 +418,9 @@ static zend_object *async_tls_server_encryption_object_create(zend_class_entry *
 
 	zend_object_std_init(&encryption->std, ce);
 	encryption->std.handlers = &async_tls_server_encryption_handlers;
+	
+	encryption->session_cache = ASYNC_SSL_DEFAULT_SESSION_CACHE;
+	encryption->session_lifetime = ASYNC_SSL_DEFAULT_SESSION_LIFETIME;
 
 	return &encryption->std;
 }
@@ -387,6 +452,11 @@ static async_tls_server_encryption *clone_server_encryption(async_tls_server_enc
 		result->cert.passphrase = zend_string_copy(encryption->cert.passphrase);
 	}
 	
+	if (encryption->certs != NULL) {
+		result->certs = encryption->certs;
+		result->certs->refcount++;
+	}
+	
 	if (encryption->alpn != NULL) {
 		result->alpn = zend_string_copy(encryption->alpn);
 	}
@@ -398,6 +468,10 @@ static async_tls_server_encryption *clone_server_encryption(async_tls_server_enc
 	if (encryption->cafile != NULL) {
 		result->cafile = zend_string_copy(encryption->cafile);
 	}
+	
+	result->session_cache = encryption->session_cache;
+	result->session_lifetime = encryption->session_lifetime;
+	result->max_version = encryption->max_version;
 
 	return result;
 }
@@ -409,6 +483,13 @@ static void async_tls_server_encryption_object_destroy(zend_object *object)
 	encryption = (async_tls_server_encryption *) object;
 
 	dispose_cert(&encryption->cert);
+	release_cert_chain(encryption->certs);
+	
+#ifdef HAVE_ASYNC_SSL
+	if (encryption->index != NULL) {
+		async_ssl_dispose_cert_index(encryption->index);
+	}
+#endif
 
 	if (encryption->alpn != NULL) {
 		zend_string_release(encryption->alpn);
@@ -484,7 +565,6 @@ PHP_METHOD(TlsServerEncryption, withCertificate)
 {
 	async_tls_server_encryption *encryption;
 	async_tls_cert *cert;
-	async_tls_cert *current;
 
 	zend_string *host;
 	zend_string *file;
@@ -493,11 +573,7 @@ PHP_METHOD(TlsServerEncryption, withCertificate)
 	zval *passphrase;
 	
 	char path[MAXPATHLEN];
-	
-#ifdef HAVE_ASYNC_SSL
-	char *cafile;
-	char *capath;
-#endif
+	char *wildcard;
 	
 	key = NULL;
 	passphrase = NULL;
@@ -509,15 +585,20 @@ PHP_METHOD(TlsServerEncryption, withCertificate)
 		Z_PARAM_ZVAL(key)
 		Z_PARAM_ZVAL(passphrase)
 	ZEND_PARSE_PARAMETERS_END();
+	
+	wildcard = (char *) zend_memrchr(ZSTR_VAL(host), '*', ZSTR_LEN(host));
+	
+	// Only the left-most label may be a wildcard ("*.example.com").
+	ASYNC_CHECK_ERROR(ZSTR_LEN(host) == 0 || (wildcard != NULL && (wildcard != ZSTR_VAL(host) || ZSTR_LEN(host) < 3 || ZSTR_VAL(host)[1] != '.')),
+		"Invalid certificate host name: %s", ZSTR_VAL(host));
 
 	ASYNC_CHECK_ERROR(!VCWD_REALPATH(ZSTR_VAL(file), path), "Failed to locate certificate: %s", ZSTR_VAL(file));
 
-	encryption = clone_server_encryption((async_tls_server_encryption *) Z_OBJ_P(getThis()));
-
 	cert = ecalloc(1, sizeof(async_tls_cert));
 
-	cert->host = zend_string_copy(host);
+	cert->host = zend_string_tolower(host);
 	cert->file = zend_string_init(path, strlen(path), 0);
+	cert->refcount = 1;
 	
 	if (key != NULL && Z_TYPE_P(key) != IS_NULL) {
 		if (!VCWD_REALPATH(ZSTR_VAL(Z_STR_P(key)), path)) {
@@ -528,7 +609,7 @@ PHP_METHOD(TlsServerEncryption, withCertificate)
 			return;
 		}
 	
-		cert->key = zend_string_copy(Z_STR_P(key));
+		cert->key = zend_string_init(path, strlen(path), 0);
 	} else {
 		cert->key = zend_string_copy(cert->file);
 	}
@@ -536,32 +617,12 @@ PHP_METHOD(TlsServerEncryption, withCertificate)
 	if (passphrase != NULL && Z_TYPE_P(passphrase) != IS_NULL) {
 		cert->passphrase = zend_string_copy(Z_STR_P(passphrase));
 	}
-
-#ifdef HAVE_ASYNC_SSL
-	cafile = (encryption->cafile == NULL) ? NULL : ZSTR_VAL(encryption->cafile);
-	capath = (encryption->capath == NULL) ? NULL : ZSTR_VAL(encryption->capath);
-
-	cert->ctx = async_ssl_create_context(SSL_OP_SINGLE_DH_USE, cafile, capath);
-
-	SSL_CTX_set_default_passwd_cb(cert->ctx, async_ssl_cert_passphrase_cb);
-	SSL_CTX_set_default_passwd_cb_userdata(cert->ctx, cert);
-
-	SSL_CTX_use_certificate_chain_file(cert->ctx, ZSTR_VAL(cert->file));	
-	SSL_CTX_use_PrivateKey_file(cert->ctx, ZSTR_VAL(cert->key), SSL_FILETYPE_PEM);
-#endif
-
-	current = encryption->certs.first;
-
-	while (current != NULL) {
-		if (zend_string_equals(current->host, cert->host)) {
-			ASYNC_LIST_REMOVE(&encryption->certs, current);
-			break;
-		}
-
-		current = current->next;
-	}
-
-	ASYNC_LIST_APPEND(&encryption->certs, cert);
+	
+	encryption = clone_server_encryption((async_tls_server_encryption *) Z_OBJ_P(getThis()));
+	
+	// Takes over the reference to the chain of the cloned encryption.
+	cert->next = encryption->certs;
+	encryption->certs = cert;
 
 	RETURN_OBJ(&encryption->std);
 }
@@ -642,6 +703,61 @@ PHP_METHOD(TlsServerEncryption, withCertificateAuthorityFile)
 	RETURN_OBJ(&encryption->std);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tls_server_encryption_with_session_cache, 0, 1, Concurrent\\Network\\TlsServerEncryption, 0)
+	ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, lifetime, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+PHP_METHOD(TlsServerEncryption, withSessionCache)
+{
+	async_tls_server_encryption *encryption;
+	
+	zend_long size;
+	zend_long lifetime;
+	
+	lifetime = ASYNC_SSL_DEFAULT_SESSION_LIFETIME;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 2)
+		Z_PARAM_LONG(size)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_LONG(lifetime)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(size < 0, "Session cache size must not be negative");
+	ASYNC_CHECK_ERROR(lifetime < 1, "Session lifetime must be at least 1 second");
+	
+	encryption = clone_server_encryption((async_tls_server_encryption *) Z_OBJ_P(getThis()));
+	encryption->session_cache = (uint32_t) MIN(size, UINT32_MAX);
+	encryption->session_lifetime = (uint32_t) MIN(lifetime, UINT32_MAX);
+	
+	RETURN_OBJ(&encryption->std);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tls_server_encryption_with_max_version, 0, 1, Concurrent\\Network\\TlsServerEncryption, 0)
+	ZEND_ARG_TYPE_INFO(0, version, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+PHP_METHOD(TlsServerEncryption, withMaxVersion)
+{
+	async_tls_server_encryption *encryption;
+	
+	zend_string *name;
+	int version;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_STR(name)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	version = parse_protocol_version(name);
+	
+	ASYNC_CHECK_ERROR(version == 0, "Unsupported TLS protocol version: %s", ZSTR_VAL(name));
+	
+	encryption = clone_server_encryption((async_tls_server_encryption *) Z_OBJ_P(getThis()));
+	encryption->max_version = version;
+	
+	RETURN_OBJ(&encryption->std);
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_WAKEUP(TlsServerEncryption, async_tls_server_encryption_ce)
 //LCOV_EXCL_STOP
@@ -653,6 +769,8 @@ static const zend_function_entry async_tls_server_encryption_functions[] = {
 	PHP_ME(TlsServerEncryption, withAlpnProtocols, arginfo_tls_server_encryption_with_alpn_protocols, ZEND_ACC_PUBLIC)
 	PHP_ME(TlsServerEncryption, withCertificateAuthorityPath, arginfo_tls_server_encryption_with_capath, ZEND_ACC_PUBLIC)
 	PHP_ME(TlsServerEncryption, withCertificateAuthorityFile, arginfo_tls_server_encryption_with_cafile, ZEND_ACC_PUBLIC)
+	PHP_ME(TlsServerEncryption, withSessionCache, arginfo_tls_server_encryption_with_session_cache, ZEND_ACC_PUBLIC)
+	PHP_ME(TlsServerEncryption, withMaxVersion, arginfo_tls_server_encryption_with_max_version, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -676,6 +794,7 @@ async_tls_info *async_tls_info_object_create(SSL *ssl)
 	ZVAL_STRING(OBJ_PROP(&info->std, async_tls_info_prop_offset(str_protocol)), SSL_get_version(ssl));
 	ZVAL_STRING(OBJ_PROP(&info->std, async_tls_info_prop_offset(str_cipher_name)), SSL_CIPHER_get_name(cipher));
 	ZVAL_LONG(OBJ_PROP(&info->std, async_tls_info_prop_offset(str_cipher_bits)), SSL_CIPHER_get_bits(cipher, NULL));
+	ZVAL_BOOL(OBJ_PROP(&info->std, async_tls_info_prop_offset(str_session_reused)), SSL_session_reused(ssl) ? 1 : 0);
 	
 #ifdef ASYNC_TLS_ALPN
 	const unsigned char *protos;
@@ -753,12 +872,14 @@ void async_ssl_ce_register()
 	str_cipher_name = zend_new_interned_string(zend_string_init(ZEND_STRL("cipher_name"), 1));
 	str_cipher_bits = zend_new_interned_string(zend_string_init(ZEND_STRL("cipher_bits"), 1));
 	str_alpn_protocol = zend_new_interned_string(zend_string_init(ZEND_STRL("alpn_protocol"), 1));
+	str_session_reused = zend_new_interned_string(zend_string_init(ZEND_STRL("session_reused"), 1));
 
 #if PHP_VERSION_ID < 70400
 	zend_declare_property_null(async_tls_info_ce, ZEND_STRL("protocol"), ZEND_ACC_PUBLIC);
 	zend_declare_property_null(async_tls_info_ce, ZEND_STRL("cipher_name"), ZEND_ACC_PUBLIC);
 	zend_declare_property_null(async_tls_info_ce, ZEND_STRL("cipher_bits"), ZEND_ACC_PUBLIC);
 	zend_declare_property_null(async_tls_info_ce, ZEND_STRL("alpn_protocol"), ZEND_ACC_PUBLIC);
+	zend_declare_property_bool(async_tls_info_ce, ZEND_STRL("session_reused"), 0, ZEND_ACC_PUBLIC);
 #else
 	ZVAL_STRING(&tmp, "");
 	zend_declare_typed_property(async_tls_info_ce, str_protocol, &tmp, ZEND_ACC_PUBLIC, NULL, IS_STRING);
@@ -770,6 +891,9 @@ void async_ssl_ce_register()
 
 	ZVAL_NULL(&tmp);
 	zend_declare_typed_property(async_tls_info_ce, str_alpn_protocol, &tmp, ZEND_ACC_PUBLIC, NULL, ZEND_TYPE_ENCODE(IS_STRING, 1));
+
+	ZVAL_FALSE(&tmp);
+	zend_declare_typed_property(async_tls_info_ce, str_session_reused, &tmp, ZEND_ACC_PUBLIC, NULL, _IS_BOOL);
 #endif
 
 #ifdef HAVE_ASYNC_SSL
@@ -784,4 +908,5 @@ void async_ssl_ce_unregister()
 	zend_string_release(str_cipher_name);
 	zend_string_release(str_cipher_bits);
 	zend_string_release(str_alpn_protocol);
+	zend_string_release(str_session_reused);
 }
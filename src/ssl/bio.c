@@ -18,11 +18,13 @@
 
 #include "php_async.h"
 
+#include "async/buffer.h"
 #include "async/ssl.h"
 
 #ifdef HAVE_ASYNC_SSL
 
 static BIO_METHOD *php_method;
+static BIO_METHOD *php_out_method;
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 
@@ -131,6 +133,254 @@ ASYNC_API BIO *BIO_new_php(size_t size)
 	return b;
 }
 
+static zend_always_inline void release_out_buffer(async_ssl_bio_out *impl, char *buf, size_t size, zend_bool foreign)
+{
+	if (foreign) {
+		free(buf);
+	} else if (impl->pool != NULL) {
+		async_buffer_pool_release(impl->pool, buf, size);
+	} else {
+		// Only the first buffer replaced by a worker thread can be a pooled buffer.
+		ZEND_ASSERT(impl->stale == NULL);
+		
+		impl->stale = buf;
+		impl->stale_size = size;
+	}
+}
+
+/* Moves pending output into a buffer of at least the given size, the PHP allocator must not be used by worker threads. */
+static int grow_out_buffer(async_ssl_bio_out *impl, size_t size)
+{
+	char *buf;
+	size_t len;
+	zend_bool foreign;
+	
+	len = impl->len - impl->offset;
+	
+	if (impl->pool == NULL) {
+		if (UNEXPECTED(NULL == (buf = malloc(size)))) {
+			return FAILURE;
+		}
+		
+		foreign = 1;
+	} else {
+		size = async_buffer_pool_size(size);
+		buf = async_buffer_pool_acquire(impl->pool, size);
+		foreign = 0;
+	}
+	
+	if (impl->buf != NULL) {
+		memcpy(buf, impl->buf + impl->offset, len);
+		
+		release_out_buffer(impl, impl->buf, impl->size, impl->foreign);
+	}
+	
+	impl->buf = buf;
+	impl->size = size;
+	impl->len = len;
+	impl->offset = 0;
+	impl->foreign = foreign;
+	
+	return SUCCESS;
+}
+
+static int bio_php_out_write(BIO *b, const char *buf, int size)
+{
+	async_ssl_bio_out *impl;
+	size_t len;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	BIO_clear_retry_flags(b);
+	
+	if (UNEXPECTED(size < 1)) {
+		return 0;
+	}
+	
+	if ((impl->len + size) > impl->size) {
+		len = impl->len - impl->offset;
+		
+		if ((len + size) <= impl->size) {
+			memmove(impl->buf, impl->buf + impl->offset, len);
+			
+			impl->len = len;
+			impl->offset = 0;
+		} else if (UNEXPECTED(FAILURE == grow_out_buffer(impl, len + size))) {
+			return -1;
+		}
+	}
+	
+	memcpy(impl->buf + impl->len, buf, size);
+	impl->len += size;
+	
+	return size;
+}
+
+static int bio_php_out_read(BIO *b, char *buf, int size)
+{
+	async_ssl_bio_out *impl;
+	size_t len;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	BIO_clear_retry_flags(b);
+	
+	if (impl->len == impl->offset) {
+		BIO_set_retry_read(b);
+		
+		return -1;
+	}
+	
+	len = MIN((size_t) size, impl->len - impl->offset);
+	
+	memcpy(buf, impl->buf + impl->offset, len);
+	impl->offset += len;
+	
+	// Drained buffers are returned to the pool, idle connections do not hold output memory.
+	if (impl->offset == impl->len && impl->pool != NULL) {
+		release_out_buffer(impl, impl->buf, impl->size, impl->foreign);
+		
+		impl->buf = NULL;
+		impl->size = 0;
+		impl->len = 0;
+		impl->offset = 0;
+		impl->foreign = 0;
+	}
+	
+	return (int) len;
+}
+
+static long bio_php_out_ctrl(BIO *b, int cmd, long num, void *ptr)
+{
+	async_ssl_bio_out *impl;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	switch (cmd) {
+	case BIO_CTRL_EOF:
+		return (impl->len == impl->offset);
+	case BIO_CTRL_GET_CLOSE:
+		return BIO_get_shutdown(b);
+	case BIO_CTRL_SET_CLOSE:
+		BIO_set_shutdown(b, (int) num);
+		break;
+	case BIO_CTRL_WPENDING:
+		return 0;
+	case BIO_CTRL_PENDING:
+		return (long) (impl->len - impl->offset);
+	case BIO_CTRL_PUSH:
+	case BIO_CTRL_POP:
+		return 0;
+	}
+	
+	return 1;
+}
+
+static int bio_php_out_free(BIO *b)
+{
+	async_ssl_bio_out *impl;
+	
+	if (b == NULL) {
+		return 0;
+	}
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	if (impl->buf != NULL) {
+		release_out_buffer(impl, impl->buf, impl->size, impl->foreign);
+	}
+	
+	if (impl->stale != NULL && impl->pool != NULL) {
+		async_buffer_pool_release(impl->pool, impl->stale, impl->stale_size);
+	}
+	
+	efree(impl);
+	
+	return 1;
+}
+
+ASYNC_API BIO_METHOD *BIO_s_php_out()
+{
+	return php_out_method;
+}
+
+ASYNC_API BIO *BIO_new_php_out(async_buffer_pool *pool)
+{
+	BIO *b;
+	async_ssl_bio_out *impl;
+	
+	impl = ecalloc(1, sizeof(async_ssl_bio_out));
+	impl->pool = pool;
+	
+	b = BIO_new(BIO_s_php_out());
+	BIO_set_data(b, impl);
+	BIO_set_init(b, 1);
+	
+	return b;
+}
+
+/* Attaches a buffer pool (or detaches it by passing NULL before the engine is handed to a worker thread). */
+void async_ssl_bio_set_pool(BIO *b, async_buffer_pool *pool)
+{
+	async_ssl_bio_out *impl;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	impl->pool = pool;
+	
+	if (pool != NULL && impl->stale != NULL) {
+		async_buffer_pool_release(pool, impl->stale, impl->stale_size);
+		
+		impl->stale = NULL;
+		impl->stale_size = 0;
+	}
+}
+
+/* Makes sure that the given number of bytes can be written without growing the output buffer. */
+void async_ssl_bio_reserve(BIO *b, size_t len)
+{
+	async_ssl_bio_out *impl;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	if ((impl->len - impl->offset + len) > impl->size) {
+		grow_out_buffer(impl, impl->len - impl->offset + len);
+	}
+}
+
+/* Transfers ownership of the pending output to the caller, the buffer must be released into the pool using the returned size. */
+char *async_ssl_bio_detach_buffer(BIO *b, size_t *len, size_t *size)
+{
+	async_ssl_bio_out *impl;
+	char *buf;
+	
+	impl = (async_ssl_bio_out *) BIO_get_data(b);
+	
+	ZEND_ASSERT(impl->pool != NULL);
+	
+	if (impl->len == impl->offset) {
+		*len = 0;
+		*size = 0;
+		
+		return NULL;
+	}
+	
+	if (impl->offset > 0 || impl->foreign) {
+		grow_out_buffer(impl, impl->len - impl->offset);
+	}
+	
+	buf = impl->buf;
+	
+	*len = impl->len;
+	*size = impl->size;
+	
+	impl->buf = NULL;
+	impl->size = 0;
+	impl->len = 0;
+	impl->offset = 0;
+	
+	return buf;
+}
+
 #endif
 
 void async_ssl_bio_init()
@@ -141,5 +391,12 @@ void async_ssl_bio_init()
 	BIO_meth_set_read(php_method, bio_php_read);
 	BIO_meth_set_ctrl(php_method, bio_php_ctrl);
 	BIO_meth_set_destroy(php_method, bio_php_free);
+	
+	php_out_method = BIO_meth_new(BIO_TYPE_PHP_OUT, "PHP output buffer");
+	
+	BIO_meth_set_write(php_out_method, bio_php_out_write);
+	BIO_meth_set_read(php_out_method, bio_php_out_read);
+	BIO_meth_set_ctrl(php_out_method, bio_php_out_ctrl);
+	BIO_meth_set_destroy(php_out_method, bio_php_out_free);
 #endif
 }
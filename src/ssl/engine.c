@@ -20,9 +20,34 @@
 
 #include "async/ssl.h"
 
+#include "zend_smart_str.h"
+
 #ifdef HAVE_ASYNC_SSL
 
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#ifdef ASYNC_TLS_KTLS
+#include <openssl/kdf.h>
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
+
 static int async_index;
+static int async_ctx_index;
 
 #ifdef PHP_WIN32
 #include "win32/winutil.h"
@@ -54,13 +79,18 @@ int async_ssl_cert_passphrase_cb(char *buf, int size, int rwflag, void *obj)
 	return (int) ZSTR_LEN(cert->passphrase);
 }
 
+/* Must not use the PHP allocator, handshakes may be running on a worker thread. */
 static int ssl_servername_cb(SSL *ssl, int *ad, void *arg)
 {
-	async_tls_cert_list *q;
-	async_tls_cert *cert;
-	zend_string *key;
+	async_tls_cert_index *index;
+	SSL_CTX *ctx;
 
 	const char *name;
+	const char *dot;
+	
+	char host[TLSEXT_MAXLEN_host_name + 1];
+	size_t len;
+	size_t i;
 
 	if (UNEXPECTED(ssl == NULL)) {
 		return SSL_TLSEXT_ERR_NOACK;
@@ -71,47 +101,44 @@ static int ssl_servername_cb(SSL *ssl, int *ad, void *arg)
 	if (UNEXPECTED(name == NULL || name[0] == '\0')) {
 		return SSL_TLSEXT_ERR_NOACK;
 	}
-
-	q = (async_tls_cert_list *) arg;
-	key = zend_string_init(name, strlen(name), 0);
 	
-	cert = q->first;
-
-	while (cert != NULL) {
-		if (zend_string_equals(key, cert->host)) {
-			SSL_set_SSL_CTX(ssl, cert->ctx);
-			zend_string_release(key);
-			
-			return SSL_TLSEXT_ERR_OK;
-		}
+	if (UNEXPECTED((len = strlen(name)) > TLSEXT_MAXLEN_host_name)) {
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+	
+	for (i = 0; i < len; i++) {
+		host[i] = zend_tolower_ascii(name[i]);
+	}
+	
+	host[len] = '\0';
+	
+	index = (async_tls_cert_index *) arg;
+	ctx = (SSL_CTX *) zend_hash_str_find_ptr(&index->hosts, host, len);
+	
+	// A wildcard matches exactly one label (the left-most one).
+	if (ctx == NULL && NULL != (dot = memchr(host, '.', len)) && dot != host) {
+		ctx = (SSL_CTX *) zend_hash_str_find_ptr(&index->wildcards, dot + 1, len - (dot - host) - 1);
+	}
 
-		cert = cert->next;
+	if (ctx == NULL && (0 == strcmp(host, "127.0.0.1") || 0 == strcmp(host, "::"))) {
+		ctx = (SSL_CTX *) zend_hash_str_find_ptr(&index->hosts, "localhost", sizeof("localhost") - 1);
 	}
 
-	if (0 != strcmp(ZSTR_VAL(key), "127.0.0.1") && 0 != strcmp(ZSTR_VAL(key), "::")) {
-		zend_string_release(key);
-		
-		return SSL_TLSEXT_ERR_OK;
+	if (ctx != NULL) {
+		SSL_set_SSL_CTX(ssl, ctx);
 	}
 
-	zend_string_release(key);
+	return SSL_TLSEXT_ERR_OK;
+}
 
-	ASYNC_STR(key, "localhost");
+/* SSL contexts keep a reference to the encryption that owns their SNI index, connections keep their context alive. */
+static void ssl_ctx_ex_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx, long argl, void *argp)
+{
+	async_tls_server_encryption *encryption;
 	
-	while (cert != NULL) {
-		if (zend_string_equals(key, cert->host)) {
-			SSL_set_SSL_CTX(ssl, cert->ctx);
-			zend_string_release(key);
-			
-			return SSL_TLSEXT_ERR_OK;
-		}
-
-		cert = cert->next;
+	if ((encryption = (async_tls_server_encryption *) ptr) != NULL) {
+		ASYNC_DELREF(&encryption->std);
 	}
-	
-	zend_string_release(key);
-
-	return SSL_TLSEXT_ERR_OK;
 }
 
 static zend_bool async_ssl_match_hostname(const char *subjectname, const char *certname)
@@ -267,7 +294,7 @@ SSL_CTX *async_ssl_create_context(int options, char *cafile, char *capath)
 	int mask;
 
 	mask = SSL_OP_ALL | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3;	
-	mask |= SSL_OP_NO_COMPRESSION | SSL_OP_NO_TICKET;
+	mask |= SSL_OP_NO_COMPRESSION;
 	mask &= ~SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS;
 
 	ctx = SSL_CTX_new(SSLv23_method());
@@ -292,10 +319,104 @@ SSL_CTX *async_ssl_create_context(int options, char *cafile, char *capath)
 	}
 	
 	SSL_CTX_set_default_passwd_cb(ctx, async_ssl_cert_passphrase_cb);
+	
+	// Server sessions can only be resumed if the (SNI) context of the connection has a session ID context.
+	SSL_CTX_set_session_id_context(ctx, (const unsigned char *) "async", sizeof("async") - 1);
 
 	return ctx;
 }
 
+static zend_always_inline zend_string *create_context_key(int options, char *cafile, char *capath, int verify_depth, zend_string *alpn)
+{
+	smart_str key = {0};
+	
+	smart_str_append_long(&key, options);
+	smart_str_appendc(&key, ':');
+	smart_str_append_long(&key, verify_depth);
+	smart_str_appendc(&key, ':');
+	
+	if (cafile != NULL) {
+		smart_str_appends(&key, cafile);
+	}
+	
+	smart_str_appendc(&key, ':');
+	
+	if (capath != NULL) {
+		smart_str_appends(&key, capath);
+	}
+	
+	smart_str_appendc(&key, ':');
+	
+	if (alpn != NULL) {
+		smart_str_append(&key, alpn);
+	}
+	
+	smart_str_0(&key);
+	
+	return key.s;
+}
+
+/* Returns a (referenced) client context, contexts are cached by the scheduler and shared by all connections using the same settings. */
+SSL_CTX *async_ssl_get_client_context(async_task_scheduler *scheduler, int options, char *cafile, char *capath, async_ssl_settings *settings, zend_string *alpn)
+{
+	SSL_CTX *ctx;
+	zend_string *key;
+	zend_string *tmp;
+	
+	key = create_context_key(options, cafile, capath, settings->verify_depth, alpn);
+	ctx = (SSL_CTX *) zend_hash_find_ptr(&scheduler->contexts, key);
+	
+	if (ctx == NULL) {
+		ctx = async_ssl_create_context(options, cafile, capath);
+		
+		async_ssl_setup_verify_callback(ctx, settings);
+		async_ssl_setup_client_alpn(ctx, alpn, 0);
+		async_ssl_setup_client_sessions(ctx);
+		
+		// The oldest context is evicted when the cache is full, connections keep their own reference.
+		if (zend_hash_num_elements(&scheduler->contexts) >= ASYNC_SSL_MAX_CLIENT_CONTEXTS) {
+			ZEND_HASH_FOREACH_STR_KEY(&scheduler->contexts, tmp) {
+				zend_hash_del(&scheduler->contexts, tmp);
+				break;
+			} ZEND_HASH_FOREACH_END();
+		}
+		
+		zend_hash_add_new_ptr(&scheduler->contexts, key, ctx);
+		
+		scheduler->tls.context_misses++;
+	} else {
+		scheduler->tls.context_hits++;
+	}
+	
+	zend_string_release(key);
+	
+	SSL_CTX_up_ref(ctx);
+	
+	return ctx;
+}
+
+/* Creates the key of a client session, sessions must only be resumed by connections using the same verification settings. */
+zend_string *async_ssl_create_session_key(zend_string *host, int port, int options, char *cafile, char *capath, async_ssl_settings *settings, zend_string *alpn)
+{
+	zend_string *key;
+	zend_string *ctx;
+	
+	ctx = create_context_key(options, cafile, capath, settings->verify_depth, alpn);
+	
+	key = zend_strpprintf(0, "%s:%d/%s/%d/%s",
+		ZSTR_VAL(host), port, ZSTR_VAL(settings->peer_name), (int) settings->allow_self_signed, ZSTR_VAL(ctx)
+	);
+	
+	zend_string_release(ctx);
+	
+	return key;
+}
+
+void async_ssl_context_dtor(zval *zv)
+{
+	SSL_CTX_free((SSL_CTX *) Z_PTR_P(zv));
+}
+
 static zend_always_inline int configure_engine(SSL_CTX *ctx, SSL *ssl, BIO *rbio, BIO *wbio)
 {
 	SSL_set_bio(ssl, rbio, wbio);
@@ -310,13 +431,11 @@ static zend_always_inline int configure_engine(SSL_CTX *ctx, SSL *ssl, BIO *rbio
 	return SUCCESS;
 }
 
-int async_ssl_create_buffered_engine(async_ssl_engine *engine, size_t size)
+int async_ssl_create_buffered_engine(async_ssl_engine *engine, size_t size, async_buffer_pool *pool)
 {
 	engine->ssl = SSL_new(engine->ctx);
 	engine->rbio = BIO_new_php(size);
-	engine->wbio = BIO_new(BIO_s_mem());
-	
-	BIO_set_mem_eof_return(engine->wbio, -1);
+	engine->wbio = BIO_new_php_out(pool);
 	
 	return configure_engine(engine->ctx, engine->ssl, engine->rbio, engine->wbio);
 }
@@ -544,10 +663,357 @@ int async_ssl_setup_encryption(SSL *ssl, async_ssl_settings *settings)
 	return SSL_set_ex_data(ssl, async_index, settings);
 }
 
-void async_ssl_setup_server_sni(SSL_CTX *ctx, async_tls_server_encryption *encryption)
+void async_ssl_dispose_cert_index(async_tls_cert_index *index)
 {
+	zend_hash_destroy(&index->hosts);
+	zend_hash_destroy(&index->wildcards);
+	
+	efree(index);
+}
+
+static async_tls_cert_index *create_cert_index(async_tls_server_encryption *encryption)
+{
+	async_tls_cert_index *index;
+	async_tls_cert *cert;
+	HashTable *table;
+	SSL_CTX *ctx;
+	
+	char *cafile;
+	char *capath;
+	char *host;
+	size_t len;
+	
+	cafile = (encryption->cafile == NULL) ? NULL : ZSTR_VAL(encryption->cafile);
+	capath = (encryption->capath == NULL) ? NULL : ZSTR_VAL(encryption->capath);
+	
+	index = emalloc(sizeof(async_tls_cert_index));
+	
+	zend_hash_init(&index->hosts, 8, NULL, async_ssl_context_dtor, 0);
+	zend_hash_init(&index->wildcards, 0, NULL, async_ssl_context_dtor, 0);
+	
+	// Chains start with the most recently added certificate, it replaces older certificates of the same host.
+	for (cert = encryption->certs; cert != NULL; cert = cert->next) {
+		host = ZSTR_VAL(cert->host);
+		len = ZSTR_LEN(cert->host);
+		
+		if (host[0] == '*') {
+			table = &index->wildcards;
+			host += 2;
+			len -= 2;
+		} else {
+			table = &index->hosts;
+		}
+		
+		if (zend_hash_str_exists(table, host, len)) {
+			continue;
+		}
+		
+		ctx = async_ssl_create_context(SSL_OP_SINGLE_DH_USE | SSL_OP_CIPHER_SERVER_PREFERENCE, cafile, capath);
+
+		SSL_CTX_set_default_passwd_cb_userdata(ctx, cert);
+		
+		if (1 != SSL_CTX_use_certificate_chain_file(ctx, ZSTR_VAL(cert->file)) || 1 != SSL_CTX_use_PrivateKey_file(ctx, ZSTR_VAL(cert->key), SSL_FILETYPE_PEM)) {
+			zend_throw_exception_ex(async_socket_exception_ce, 0, "Failed to load certificate of host %s", ZSTR_VAL(cert->host));
+		
+			SSL_CTX_free(ctx);
+			async_ssl_dispose_cert_index(index);
+			
+			return NULL;
+		}
+		
+		async_ssl_setup_server_alpn(ctx, encryption);
+		
+		zend_hash_str_add_ptr(table, host, len, ctx);
+	}
+	
+	return index;
+}
+
+int async_ssl_setup_server_sni(SSL_CTX *ctx, async_tls_server_encryption *encryption)
+{
+	if (encryption->certs == NULL) {
+		return SUCCESS;
+	}
+	
+	if (encryption->index == NULL && NULL == (encryption->index = create_cert_index(encryption))) {
+		return FAILURE;
+	}
+	
+	SSL_CTX_set_ex_data(ctx, async_ctx_index, encryption);
+	ASYNC_ADDREF(&encryption->std);
+	
 	SSL_CTX_set_tlsext_servername_callback(ctx, ssl_servername_cb);
-	SSL_CTX_set_tlsext_servername_arg(ctx, &encryption->certs);
+	SSL_CTX_set_tlsext_servername_arg(ctx, encryption->index);
+	
+	return SUCCESS;
+}
+
+static zend_always_inline int generate_ticket_key(async_ssl_ticket_key *key)
+{
+	if (RAND_bytes(key->name, sizeof(key->name)) <= 0) {
+		return FAILURE;
+	}
+	
+	if (RAND_bytes(key->aes_key, sizeof(key->aes_key)) <= 0) {
+		return FAILURE;
+	}
+	
+	if (RAND_bytes(key->hmac_key, sizeof(key->hmac_key)) <= 0) {
+		return FAILURE;
+	}
+	
+	return SUCCESS;
+}
+
+static zend_always_inline int rotate_ticket_keys(async_ssl_ticket_keys *tickets, time_t now)
+{
+	if ((now - tickets->rotated) < (time_t) tickets->lifetime) {
+		return SUCCESS;
+	}
+	
+	memcpy(&tickets->keys[1], &tickets->keys[0], sizeof(async_ssl_ticket_key));
+	
+	if (UNEXPECTED(FAILURE == generate_ticket_key(&tickets->keys[0]))) {
+		return FAILURE;
+	}
+	
+	tickets->rotated = now;
+	
+	return SUCCESS;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+typedef EVP_MAC_CTX async_ssl_ticket_mac;
+
+#define ASYNC_SSL_SET_TICKET_KEY_CB SSL_CTX_set_tlsext_ticket_key_evp_cb
+
+static zend_always_inline int init_ticket_mac(EVP_MAC_CTX *hctx, async_ssl_ticket_key *key)
+{
+	OSSL_PARAM params[3];
+	
+	params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key->hmac_key, sizeof(key->hmac_key));
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *) "SHA256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+	
+	return EVP_MAC_CTX_set_params(hctx, params);
+}
+
+#else
+
+typedef HMAC_CTX async_ssl_ticket_mac;
+
+#define ASYNC_SSL_SET_TICKET_KEY_CB SSL_CTX_set_tlsext_ticket_key_cb
+
+static zend_always_inline int init_ticket_mac(HMAC_CTX *hctx, async_ssl_ticket_key *key)
+{
+	return HMAC_Init_ex(hctx, key->hmac_key, sizeof(key->hmac_key), EVP_sha256(), NULL);
+}
+
+#endif
+
+static int ssl_ticket_key_cb(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *ctx, async_ssl_ticket_mac *hctx, int enc)
+{
+	async_ssl_settings *settings;
+	async_ssl_ticket_keys *tickets;
+	async_ssl_ticket_key *key;
+	
+	int i;
+	
+	settings = (async_ssl_settings *) SSL_get_ex_data(ssl, async_index);
+	
+	if (UNEXPECTED(settings == NULL || settings->tickets == NULL)) {
+		return 0;
+	}
+	
+	tickets = settings->tickets;
+	
+	if (enc) {
+		// Keys are rotated lazily, tickets encrypted with the previous key are renewed on their next use.
+		if (!tickets->offload && UNEXPECTED(FAILURE == rotate_ticket_keys(tickets, time(NULL)))) {
+			return -1;
+		}
+		
+		key = &tickets->keys[0];
+		
+		if (UNEXPECTED(RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0)) {
+			return -1;
+		}
+		
+		memcpy(name, key->name, sizeof(key->name));
+		
+		if (UNEXPECTED(EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv) <= 0 || init_ticket_mac(hctx, key) <= 0)) {
+			return -1;
+		}
+		
+		return 1;
+	}
+	
+	for (i = 0; i < 2; i++) {
+		key = &tickets->keys[i];
+		
+		if (0 == memcmp(name, key->name, sizeof(key->name))) {
+			if (UNEXPECTED(init_ticket_mac(hctx, key) <= 0 || EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv) <= 0)) {
+				return -1;
+			}
+			
+			return (i == 0) ? 1 : 2;
+		}
+	}
+	
+	return 0;
+}
+
+void async_ssl_setup_server_sessions(SSL_CTX *ctx, async_tls_server_encryption *encryption, async_ssl_ticket_keys *tickets)
+{
+	if (encryption->session_cache > 0) {
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+		SSL_CTX_sess_set_cache_size(ctx, encryption->session_cache);
+	} else {
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+	}
+	
+	SSL_CTX_set_timeout(ctx, encryption->session_lifetime);
+	
+	tickets->lifetime = encryption->session_lifetime;
+	
+	// Keys are kept when the context of a server is replaced, issued tickets remain valid.
+	if (tickets->rotated == 0) {
+#ifdef ASYNC_TLS_OFFLOAD
+		tickets->offload = ASYNC_G(tls_offload);
+#else
+		tickets->offload = 0;
+#endif
+		tickets->busy = 0;
+		
+		if (UNEXPECTED(SUCCESS != generate_ticket_key(&tickets->keys[0]) || SUCCESS != generate_ticket_key(&tickets->keys[1]))) {
+			SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+			
+			return;
+		}
+		
+		tickets->rotated = time(NULL);
+	}
+	
+	ASYNC_SSL_SET_TICKET_KEY_CB(ctx, ssl_ticket_key_cb);
+}
+
+void async_ssl_session_dtor(zval *zv)
+{
+	SSL_SESSION_free((SSL_SESSION *) Z_PTR_P(zv));
+}
+
+static int store_session(async_ssl_settings *settings, SSL_SESSION *session)
+{
+	zend_string *key;
+	
+	if (UNEXPECTED(settings->sessions == NULL || settings->session_key == NULL)) {
+		return 0;
+	}
+	
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+	if (!SSL_SESSION_is_resumable(session)) {
+		return 0;
+	}
+#endif
+
+	// The oldest session is evicted when the store is full.
+	if (zend_hash_num_elements(settings->sessions) >= ASYNC_SSL_MAX_CLIENT_SESSIONS && !zend_hash_exists(settings->sessions, settings->session_key)) {
+		ZEND_HASH_FOREACH_STR_KEY(settings->sessions, key) {
+			zend_hash_del(settings->sessions, key);
+			break;
+		} ZEND_HASH_FOREACH_END();
+	}
+	
+	zend_hash_update_ptr(settings->sessions, settings->session_key, session);
+	
+	return 1;
+}
+
+static int ssl_new_session_cb(SSL *ssl, SSL_SESSION *session)
+{
+	async_ssl_settings *settings;
+	
+	settings = (async_ssl_settings *) SSL_get_ex_data(ssl, async_index);
+	
+	if (UNEXPECTED(settings == NULL)) {
+		return 0;
+	}
+	
+	// Sessions negotiated on a worker thread are stored by the event loop thread after the handshake step.
+	if (settings->offloaded) {
+		if (settings->session != NULL) {
+			SSL_SESSION_free(settings->session);
+		}
+		
+		settings->session = session;
+		
+		return 1;
+	}
+	
+	return store_session(settings, session);
+}
+
+void async_ssl_offload_begin(async_ssl_settings *settings)
+{
+	async_ssl_ticket_keys *tickets;
+	
+	if (settings->mode == ASYNC_SSL_MODE_CLIENT) {
+		settings->offloaded = 1;
+	}
+	
+	if ((tickets = settings->tickets) != NULL) {
+		// Keys are only rotated while no worker thread is using them.
+		if (tickets->busy == 0) {
+			rotate_ticket_keys(tickets, time(NULL));
+		}
+		
+		tickets->busy++;
+	}
+}
+
+void async_ssl_offload_end(async_ssl_settings *settings)
+{
+	SSL_SESSION *session;
+	
+	if (settings->tickets != NULL) {
+		settings->tickets->busy--;
+	}
+	
+	if (settings->mode == ASYNC_SSL_MODE_CLIENT) {
+		settings->offloaded = 0;
+		
+		if ((session = settings->session) != NULL) {
+			settings->session = NULL;
+			
+			if (!store_session(settings, session)) {
+				SSL_SESSION_free(session);
+			}
+		}
+	}
+}
+
+void async_ssl_setup_client_sessions(SSL_CTX *ctx)
+{
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx, ssl_new_session_cb);
+}
+
+int async_ssl_resume_session(SSL *ssl, async_ssl_settings *settings)
+{
+	SSL_SESSION *session;
+	
+	if (settings->sessions == NULL || settings->session_key == NULL) {
+		return FAILURE;
+	}
+	
+	session = (SSL_SESSION *) zend_hash_find_ptr(settings->sessions, settings->session_key);
+	
+	if (session == NULL || 1 != SSL_set_session(ssl, session)) {
+		return FAILURE;
+	}
+	
+	return SUCCESS;
 }
 
 #ifdef ASYNC_TLS_ALPN
@@ -604,11 +1070,199 @@ void async_ssl_setup_server_alpn(SSL_CTX *ctx, async_tls_server_encryption *encr
 #endif
 }
 
+#ifdef ASYNC_TLS_KTLS
+
+typedef union _async_ktls_crypto_info {
+	struct tls12_crypto_info_aes_gcm_128 gcm128;
+#ifdef TLS_CIPHER_AES_GCM_256
+	struct tls12_crypto_info_aes_gcm_256 gcm256;
+#endif
+} async_ktls_crypto_info;
+
+/* Derives the TLS 1.2 key block (client key, server key, client salt, server salt) from the session master secret. */
+static int derive_key_block(SSL *ssl, unsigned char *block, size_t len)
+{
+	EVP_PKEY_CTX *pctx;
+	
+	unsigned char master[SSL_MAX_MASTER_KEY_LENGTH];
+	unsigned char seed[2 * SSL3_RANDOM_SIZE];
+	size_t mlen;
+	int code;
+	
+	mlen = SSL_SESSION_get_master_key(SSL_get_session(ssl), master, sizeof(master));
+
+	SSL_get_server_random(ssl, seed, SSL3_RANDOM_SIZE);
+	SSL_get_client_random(ssl, seed + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+	
+	if (NULL == (pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, NULL))) {
+		OPENSSL_cleanse(master, sizeof(master));
+	
+		return FAILURE;
+	}
+	
+	code = EVP_PKEY_derive_init(pctx) > 0
+		&& EVP_PKEY_CTX_set_tls1_prf_md(pctx, SSL_CIPHER_get_handshake_digest(SSL_get_current_cipher(ssl))) > 0
+		&& EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, master, (int) mlen) > 0
+		&& EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, (const unsigned char *) "key expansion", sizeof("key expansion") - 1) > 0
+		&& EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed, sizeof(seed)) > 0
+		&& EVP_PKEY_derive(pctx, block, &len) > 0;
+	
+	EVP_PKEY_CTX_free(pctx);
+	OPENSSL_cleanse(master, sizeof(master));
+	
+	return code ? SUCCESS : FAILURE;
+}
+
+static socklen_t setup_crypto_info(async_ktls_crypto_info *info, int nid, unsigned char *key, unsigned char *salt)
+{
+	// Finished messages have been sent using sequence number 0 in both directions.
+	static const unsigned char seq[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	
+	memset(info, 0, sizeof(async_ktls_crypto_info));
+	
+#ifdef TLS_CIPHER_AES_GCM_256
+	if (nid == NID_aes_256_gcm) {
+		info->gcm256.info.version = TLS_1_2_VERSION;
+		info->gcm256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+		
+		memcpy(info->gcm256.key, key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+		memcpy(info->gcm256.salt, salt, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+		memcpy(info->gcm256.iv, seq, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+		memcpy(info->gcm256.rec_seq, seq, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+		
+		return sizeof(info->gcm256);
+	}
+#endif
+
+	info->gcm128.info.version = TLS_1_2_VERSION;
+	info->gcm128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+	
+	memcpy(info->gcm128.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+	memcpy(info->gcm128.salt, salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+	memcpy(info->gcm128.iv, seq, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+	memcpy(info->gcm128.rec_seq, seq, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+	
+	return sizeof(info->gcm128);
+}
+
+/*
+ * Installs the negotiated record keys of a TLS 1.2 AES-GCM connection into the kernel. The SSL engine must not hold
+ * any buffered data because record sequence numbers are assumed to continue right after the handshake.
+ *
+ * Returns FAILURE if the socket has not been changed (connection can keep using userspace encryption). The libuv
+ * error is set if the kernel accepted the receive key but rejected the send key, the connection is unusable then.
+ */
+int async_ssl_enable_ktls(SSL *ssl, int fd, int *error)
+{
+	async_ktls_crypto_info rx;
+	async_ktls_crypto_info tx;
+	
+	unsigned char block[2 * 32 + 2 * 4];
+	unsigned char *keys[2];
+	unsigned char *salts[2];
+	
+	size_t klen;
+	socklen_t size;
+	int nid;
+	int client;
+	int code;
+	
+	*error = 0;
+	
+	if (SSL_version(ssl) != TLS1_2_VERSION) {
+		return FAILURE;
+	}
+	
+	switch (nid = SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl))) {
+	case NID_aes_128_gcm:
+		klen = 16;
+		break;
+#ifdef TLS_CIPHER_AES_GCM_256
+	case NID_aes_256_gcm:
+		klen = 32;
+		break;
+#endif
+	default:
+		return FAILURE;
+	}
+	
+	if (SUCCESS != derive_key_block(ssl, block, 2 * klen + 8)) {
+		return FAILURE;
+	}
+	
+	client = SSL_is_server(ssl) ? 0 : 1;
+	
+	// Key block layout is client key, server key, client salt, server salt.
+	keys[0] = block;
+	keys[1] = block + klen;
+	salts[0] = block + 2 * klen;
+	salts[1] = block + 2 * klen + 4;
+	
+	setup_crypto_info(&tx, nid, keys[client ? 0 : 1], salts[client ? 0 : 1]);
+	size = setup_crypto_info(&rx, nid, keys[client ? 1 : 0], salts[client ? 1 : 0]);
+	
+	OPENSSL_cleanse(block, sizeof(block));
+	
+	code = FAILURE;
+	
+	// An attached ULP without keys is transparent, failing to install the receive key leaves the socket unchanged.
+	if (0 == setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls"))) {
+		if (0 == setsockopt(fd, SOL_TLS, TLS_RX, &rx, size)) {
+			if (0 == setsockopt(fd, SOL_TLS, TLS_TX, &tx, size)) {
+				code = SUCCESS;
+			} else {
+				*error = uv_translate_sys_error(errno);
+			}
+		}
+	}
+	
+	OPENSSL_cleanse(&rx, sizeof(rx));
+	OPENSSL_cleanse(&tx, sizeof(tx));
+	
+	return code;
+}
+
+/* Sends a close_notify alert, kernel TLS sockets require a control message to send non-data records. */
+void async_ssl_ktls_close_notify(int fd)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	
+	char buf[CMSG_SPACE(sizeof(unsigned char))];
+	unsigned char alert[2] = { SSL3_AL_WARNING, SSL3_AD_CLOSE_NOTIFY };
+	
+	memset(&msg, 0, sizeof(struct msghdr));
+	memset(buf, 0, sizeof(buf));
+	
+	iov.iov_base = alert;
+	iov.iov_len = sizeof(alert);
+	
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = buf;
+	msg.msg_controllen = sizeof(buf);
+	
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_TLS;
+	cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+	
+	*CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+	
+	msg.msg_controllen = cmsg->cmsg_len;
+	
+	sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+#endif
+
 #endif
 
 void async_ssl_engine_init()
 {
 #ifdef HAVE_ASYNC_SSL
 	async_index = SSL_get_ex_new_index(0, "async", NULL, NULL, NULL);
+	async_ctx_index = SSL_CTX_get_ex_new_index(0, "async", NULL, NULL, ssl_ctx_ex_free);
 #endif
 }
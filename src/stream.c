@@ -20,6 +20,7 @@
 
 #include "async/stream.h"
 #include "async/ssl.h"
+#include "async/wheel.h"
 
 #include "zend_smart_str.h"
 
@@ -37,6 +38,8 @@ ASYNC_API zend_class_entry *async_writable_stream_ce;
 static zend_object_handlers async_readable_memory_stream_handlers;
 static zend_object_handlers async_writable_memory_stream_handlers;
 
+#define ASYNC_STREAM_SCHEDULER(stream) ((async_task_scheduler *) (((char *) (stream)->handle->loop) - XtOffsetOf(async_task_scheduler, loop)))
+
 static zend_object_handlers async_stream_reader_handlers;
 static zend_object_handlers async_stream_writer_handlers;
 
@@ -118,12 +121,86 @@ ASYNC_CALLBACK ssl_sync_cb(uv_write_t *req, int status)
 	efree(sync);
 }
 
+static zend_always_inline zend_bool ssl_can_coalesce(async_stream_write_op *op, size_t len)
+{
+	async_stream_write_op *next;
+	
+	next = (async_stream_write_op *) op->base.next;
+	
+	if (next == NULL || next->flags & (ASYNC_STREAM_WRITE_OP_FLAG_STARTED | ASYNC_STREAM_WRITE_OP_FLAG_EXPORT)) {
+		return 0;
+	}
+	
+	return (len + next->in.size - next->in.offset) <= ASYNC_SSL_MAX_RECORD;
+}
+
+/* Copies queued writes into the given record buffer as long as they fit into a single TLS record. */
+static size_t ssl_coalesce_writes(async_stream_write_op *op, char *buf)
+{
+	async_stream_write_op *next;
+	
+	size_t len;
+	size_t n;
+	
+	len = op->in.size - op->in.offset;
+	
+	memcpy(buf, op->in.data + op->in.offset, len);
+	
+	next = (async_stream_write_op *) op->base.next;
+	
+	while (next != NULL && !(next->flags & (ASYNC_STREAM_WRITE_OP_FLAG_STARTED | ASYNC_STREAM_WRITE_OP_FLAG_EXPORT))) {
+		n = next->in.size - next->in.offset;
+		
+		if ((len + n) > ASYNC_SSL_MAX_RECORD) {
+			break;
+		}
+		
+		memcpy(buf + len, next->in.data + next->in.offset, n);
+		len += n;
+		
+		next = (async_stream_write_op *) next->base.next;
+	}
+	
+	return len;
+}
+
+/* Marks coalesced writes as completed by the given write operation. */
+static void ssl_finish_coalesce(async_stream_write_op *op, size_t len)
+{
+	async_stream_write_op *next;
+	
+	len -= op->in.size - op->in.offset;
+	
+	op->in.offset = op->in.size;
+	
+	next = (async_stream_write_op *) op->base.next;
+	
+	while (len > 0) {
+		ZEND_ASSERT(next != NULL);
+		
+		len -= next->in.size - next->in.offset;
+		
+		next->in.offset = next->in.size;
+		next->flags |= ASYNC_STREAM_WRITE_OP_FLAG_STARTED | ASYNC_STREAM_WRITE_OP_FLAG_GATHERED;
+		next->batch = op;
+		
+		next = (async_stream_write_op *) next->base.next;
+	}
+	
+	op->flags |= ASYNC_STREAM_WRITE_OP_FLAG_BATCH;
+}
+
 static int ssl_encode_buffer(async_stream *stream, async_stream_write_op *op)
 {
-	int code;
-	int error;
+	async_buffer_pool *pool;
 	
+	char *record;
+	char *data;
 	size_t len;
+	size_t written;
+	
+	int code;
+	int error;
 	
 	ZEND_ASSERT(op->in.offset < op->in.size);
 	
@@ -131,10 +208,40 @@ static int ssl_encode_buffer(async_stream *stream, async_stream_write_op *op)
 	op->out.size = 0;
 	op->out.offset = 0;
 	
-	op->flags &= ~ASYNC_STREAM_WRITE_OP_FLAG_NEEDS_FREE;
+	op->flags &= ~(ASYNC_STREAM_WRITE_OP_FLAG_NEEDS_FREE | ASYNC_STREAM_WRITE_OP_FLAG_POOLED);
 	
-	ERR_clear_error();
-	code = SSL_write(stream->ssl.ssl, op->in.data + op->in.offset, (int) (op->in.size - op->in.offset));
+	pool = &ASYNC_STREAM_SCHEDULER(stream)->buffers;
+	
+	data = op->in.data + op->in.offset;
+	len = op->in.size - op->in.offset;
+	record = NULL;
+	
+	// Small queued writes are packed into a single TLS record.
+	if (len < ASYNC_SSL_MAX_RECORD && ssl_can_coalesce(op, len)) {
+		record = async_buffer_pool_acquire(pool, ASYNC_SSL_MAX_RECORD);
+		
+		data = record;
+		len = ssl_coalesce_writes(op, record);
+	}
+	
+	// Encrypted data is written into a pooled buffer that is passed to libuv without copying it again.
+	async_ssl_bio_reserve(stream->ssl.wbio, MIN(len, ASYNC_SSL_MAX_RECORD) + ASYNC_SSL_RECORD_OVERHEAD);
+	
+	written = 0;
+	
+	// Coalesced data is encrypted as a whole, the peer may have limited the record size.
+	do {
+		ERR_clear_error();
+		code = SSL_write(stream->ssl.ssl, data + written, (int) (len - written));
+		
+		if (code > 0) {
+			written += code;
+		}
+	} while (record != NULL && code > 0 && written < len);
+	
+	if (record != NULL) {
+		async_buffer_pool_release(pool, record, ASYNC_SSL_MAX_RECORD);
+	}
 	
 	if (UNEXPECTED(code < 0)) {
 		error = SSL_get_error(stream->ssl.ssl, code);
@@ -156,50 +263,79 @@ static int ssl_encode_buffer(async_stream *stream, async_stream_write_op *op)
 		return FAILURE;
 	}
 	
-	op->in.offset += code;
-	
-	op->out.size = BIO_ctrl_pending(stream->ssl.wbio);
-	op->out.data = emalloc(op->out.size);
+	if (record != NULL && written == len) {
+		ssl_finish_coalesce(op, len);
+	} else {
+		op->in.offset += MIN(written, op->in.size - op->in.offset);
+	}
 	
-	len = 0;
+	op->out.data = async_ssl_bio_detach_buffer(stream->ssl.wbio, &op->out.size, &op->capacity);
 	
-	while (len < op->out.size) {
-		ERR_clear_error();
-		code = BIO_read(stream->ssl.wbio, op->out.data + len, (int) (op->out.size - len));
-		
-		if (UNEXPECTED(code < 1)) {
-			efree(op->out.data);
-			
-			op->out.data = NULL;
-			op->out.size = 0;
-			
-			op->code = UV_EPROTO;
-			op->ssl_error = (int) ERR_get_error();
-			
-			return FAILURE;
-		}
-		
-		len += code;
+	if (op->out.data != NULL) {
+		op->flags |= ASYNC_STREAM_WRITE_OP_FLAG_POOLED;
 	}
 	
-	op->flags |= ASYNC_STREAM_WRITE_OP_FLAG_NEEDS_FREE;
-	
-	return (int) len;
+	return (int) op->out.size;
 }
 
 #define ASYNC_STREAM_ENCODE_BUFFER(stream, op) (((stream)->ssl.ssl == NULL) ? encode_buffer(stream, op) : ssl_encode_buffer(stream, op))
+#define ASYNC_STREAM_CAN_GATHER(stream) ((stream)->ssl.ssl == NULL)
 
 #else
 
 #define ASYNC_STREAM_ENCODE_BUFFER(stream, op) encode_buffer(stream, op)
+#define ASYNC_STREAM_CAN_GATHER(stream) 1
 
 #endif
 
 static zend_always_inline void init_buffer(async_stream *stream)
 {
-	stream->buffer.base = emalloc(stream->buffer.size);
+	stream->buffer.base = async_buffer_pool_acquire(&ASYNC_STREAM_SCHEDULER(stream)->buffers, stream->buffer.size);
 	stream->buffer.rpos = stream->buffer.base;
 	stream->buffer.wpos = stream->buffer.base;
+	stream->peak = 0;
+}
+
+static zend_always_inline void grow_buffer(async_stream *stream)
+{
+	async_task_scheduler *scheduler;
+	char *base;
+	size_t prev;
+	size_t size;
+	
+	size = MIN(stream->buffer.size * 2, (size_t) MAX(ASYNC_G(read_buffer_max), ASYNC_G(read_buffer)));
+	
+	if (size <= stream->buffer.size) {
+		return;
+	}
+	
+	scheduler = ASYNC_STREAM_SCHEDULER(stream);
+	scheduler->buffers.grown++;
+	
+	base = stream->buffer.base;
+	prev = stream->buffer.size;
+	
+	async_ring_buffer_move(&stream->buffer, async_buffer_pool_acquire(&scheduler->buffers, size), size);
+	async_buffer_pool_release(&scheduler->buffers, base, prev);
+}
+
+static zend_always_inline void release_buffer(async_stream *stream)
+{
+	async_task_scheduler *scheduler;
+	
+	ZEND_ASSERT(stream->buffer.len == 0);
+	
+	scheduler = ASYNC_STREAM_SCHEDULER(stream);
+	
+	async_buffer_pool_release(&scheduler->buffers, stream->buffer.base, stream->buffer.size);
+	stream->buffer.base = NULL;
+	
+	// Buffers that have never been filled beyond a quarter of their size are shrunk before they are allocated again.
+	if (stream->peak <= (stream->buffer.size / 4) && stream->buffer.size > (size_t) ASYNC_G(read_buffer)) {
+		stream->buffer.size = MAX(stream->buffer.size / 2, (size_t) ASYNC_G(read_buffer));
+		
+		scheduler->buffers.shrunk++;
+	}
 }
 
 async_stream *async_stream_init(uv_stream_t *handle, size_t bufsize)
@@ -208,17 +344,14 @@ async_stream *async_stream_init(uv_stream_t *handle, size_t bufsize)
 	
 	stream = ecalloc(1, sizeof(async_stream));
 	
-	stream->buffer.size = MAX(bufsize, 0x8000);
+	stream->buffer.size = MAX(bufsize, (size_t) ASYNC_G(read_buffer));
 
 	stream->handle = handle;
 	handle->data = stream;
 	
-	uv_timer_init(handle->loop, &stream->timer);
-	
 	stream->timer.data = stream;
 	
 	uv_unref((uv_handle_t *) handle);
-	uv_unref((uv_handle_t *) &stream->timer);
 	
 	stream->shutdown.req.data = stream;
 	
@@ -227,9 +360,17 @@ async_stream *async_stream_init(uv_stream_t *handle, size_t bufsize)
 
 void async_stream_free(async_stream *stream)
 {
+	async_timer_wheel_stop(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer);
+	
+	if (stream->read.str != NULL) {
+		zend_string_release(stream->read.str);
+		stream->read.str = NULL;
+	}
+
 	if (stream->buffer.base != NULL) {
-		efree(stream->buffer.base);
-		stream->buffer.base = NULL;
+		stream->buffer.len = 0;
+		
+		release_buffer(stream);
 	}
 	
 	efree(stream);
@@ -242,6 +383,8 @@ ASYNC_CALLBACK close_stream_cb(uv_handle_t *handle)
 	stream = handle->data;
 
 	ZEND_ASSERT(stream != NULL);
+	
+	async_timer_wheel_stop(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer);
 
 	if (stream->dispose) {
 		stream->dispose(stream->arg);
@@ -288,6 +431,17 @@ static int shutdown_ssl(async_stream *stream)
 }
 #endif
 
+#ifdef ASYNC_TLS_KTLS
+static void shutdown_ktls(async_stream *stream)
+{
+	uv_os_fd_t fd;
+	
+	if (stream->flags & ASYNC_STREAM_KTLS && stream->writes.first == NULL && 0 == uv_fileno((uv_handle_t *) stream->handle, &fd)) {
+		async_ssl_ktls_close_notify((int) fd);
+	}
+}
+#endif
+
 ASYNC_CALLBACK dispose_read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 {
 	async_stream *stream;
@@ -336,11 +490,11 @@ ASYNC_CALLBACK dispose_alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_b
 	buf->base = emalloc(buf->len);
 }
 
-ASYNC_CALLBACK dispose_timer_cb(uv_timer_t *handle)
+ASYNC_CALLBACK dispose_timer_cb(async_wheel_timer *timer)
 {
 	async_stream *stream;
 	
-	stream = (async_stream *) handle->data;
+	stream = (async_stream *) timer->data;
 	
 	ZEND_ASSERT(stream != NULL);
 	
@@ -353,12 +507,18 @@ void async_stream_close_cb(async_stream *stream, async_stream_dispose_cb callbac
 		return;
 	}
 	
+#ifdef ASYNC_TLS_KTLS
+	if (!(stream->flags & ASYNC_STREAM_SHUT_WR)) {
+		shutdown_ktls(stream);
+	}
+#endif
+	
 	stream->flags |= ASYNC_STREAM_CLOSED | ASYNC_STREAM_EOF | ASYNC_STREAM_SHUT_RDWR;
 	
 	stream->dispose = callback;
 	stream->arg = data;
 
-	ASYNC_UV_TRY_CLOSE(&stream->timer, NULL);
+	async_timer_wheel_stop(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer);
 
 	if (stream->flags & ASYNC_STREAM_READING) {
 		uv_read_stop(stream->handle);
@@ -380,7 +540,9 @@ void async_stream_close_cb(async_stream *stream, async_stream_dispose_cb callbac
 			uv_ref((uv_handle_t *) stream->handle);
 			
 			uv_read_start(stream->handle, dispose_alloc_cb, dispose_read_cb);
-			uv_timer_start(&stream->timer, dispose_timer_cb, 5000, 0);
+			stream->timer.func = dispose_timer_cb;
+			
+			async_timer_wheel_start(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer, 5000);
 			
 			return;
 		}
@@ -445,6 +607,10 @@ static int trigger_shutdown_wr(async_stream *stream)
 	shutdown_ssl(stream);
 #endif
 
+#ifdef ASYNC_TLS_KTLS
+	shutdown_ktls(stream);
+#endif
+
 	code = uv_shutdown(&stream->shutdown.req, stream->handle, shutdown_cb);
 	
 	if (code == 0) {
@@ -676,9 +842,25 @@ static zend_always_inline int should_continue_read(async_stream *stream)
 	return ((stream->buffer.size - stream->buffer.len) >= 4096);
 }
 
+static zend_always_inline int should_read_direct(async_stream *stream, async_stream_read_req *req)
+{
+	if (req->in.buffer != NULL || req->in.flags & ASYNC_STREAM_READ_REQ_FLAG_IMPORT || stream->flags & ASYNC_STREAM_IPC) {
+		return 0;
+	}
+	
+#ifdef HAVE_ASYNC_SSL
+	if (stream->ssl.ssl != NULL) {
+		return 0;
+	}
+#endif
+
+	return (ASYNC_G(direct_read) > 0 && req->in.len >= (size_t) ASYNC_G(direct_read));
+}
+
 ASYNC_CALLBACK read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 {
 	async_stream *stream;
+	zend_string *str;
 	
 	size_t blen;
 	
@@ -688,10 +870,37 @@ ASYNC_CALLBACK read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 	
 	stream = (async_stream *) handle->data;
 	
+	if (stream->read.str != NULL && buf->base == ZSTR_VAL(stream->read.str)) {
+		str = stream->read.str;
+		stream->read.str = NULL;
+		
+		// Data has been read into the string of the pending read operation, it can be returned without copying.
+		if (EXPECTED(nread > 0)) {
+			ZEND_ASSERT(stream->read.base.status == ASYNC_STATUS_RUNNING);
+			
+			str = zend_string_truncate(str, (size_t) nread, 0);
+			ZSTR_VAL(str)[nread] = '\0';
+			
+			stream->read.req->out.str = str;
+			stream->read.req->out.len = (size_t) nread;
+			
+			ASYNC_FINISH_OP(&stream->read);
+			
+			return;
+		}
+		
+		zend_string_release(str);
+	}
+	
 	if (UNEXPECTED(nread == UV_ECONNRESET)) {
 		nread = UV_EOF;
 	}
 	
+	// Kernel TLS reports non-data records (close_notify and other alerts) as EIO.
+	if (UNEXPECTED(nread == UV_EIO && stream->flags & ASYNC_STREAM_KTLS)) {
+		nread = UV_EOF;
+	}
+	
 	if (UNEXPECTED(nread < 0 && nread != UV_EOF)) {
 		uv_read_stop(handle);
 		
@@ -749,6 +958,10 @@ ASYNC_CALLBACK read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 #endif
 	}
 
+	if (stream->buffer.len > stream->peak) {
+		stream->peak = stream->buffer.len;
+	}
+
 	while (stream->read.base.status == ASYNC_STATUS_RUNNING && (blen = ASYNC_STREAM_BUFFER_LEN(stream)) > 0) {
 		if (UNEXPECTED(stream->read.req->in.flags & ASYNC_STREAM_READ_REQ_FLAG_IMPORT)) {
 			stream->read.req->out.error = UV_ENOBUFS;
@@ -765,6 +978,15 @@ ASYNC_CALLBACK read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 		ASYNC_FINISH_OP(&stream->read);
 	}
 	
+	// Drained buffers are released, buffers that are about to fill up grow to keep up with the stream.
+	if (stream->buffer.base != NULL) {
+		if (stream->buffer.len == 0) {
+			release_buffer(stream);
+		} else if ((stream->buffer.size - stream->buffer.len) < 4096 && !(stream->flags & ASYNC_STREAM_EOF)) {
+			grow_buffer(stream);
+		}
+	}
+	
 	if (UNEXPECTED(nread == UV_EOF || stream->flags & ASYNC_STREAM_EOF)) {	
 #ifdef HAVE_ASYNC_SSL
 		if (stream->ssl.ssl && stream->writes.first == NULL) {
@@ -774,7 +996,9 @@ ASYNC_CALLBACK read_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
 				uv_ref((uv_handle_t *) stream->handle);
 				
 				uv_read_start(stream->handle, dispose_alloc_cb, dispose_read_cb);
-				uv_timer_start(&stream->timer, dispose_timer_cb, 5000, 0);
+				stream->timer.func = dispose_timer_cb;
+				
+				async_timer_wheel_start(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer, 5000);
 			}
 		} else {
 #endif
@@ -808,6 +1032,25 @@ ASYNC_CALLBACK read_alloc_cb(uv_handle_t *handle, size_t suggested, uv_buf_t *bu
 	
 	ZEND_ASSERT(stream != NULL);
 	
+	if (stream->read.base.status == ASYNC_STATUS_RUNNING) {
+		// Large reads bypass the ring buffer, libuv reads into the returned string instead.
+		if (stream->read.str == NULL && should_read_direct(stream, stream->read.req)) {
+			stream->read.str = zend_string_alloc(stream->read.req->in.len, 0);
+		}
+		
+		if (stream->read.str != NULL) {
+			buf->base = ZSTR_VAL(stream->read.str);
+			buf->len = (uv_buf_size_t) ZSTR_LEN(stream->read.str);
+			
+			return;
+		}
+	}
+	
+	// Buffer memory is only allocated when libuv is about to read data from the stream.
+	if (stream->buffer.base == NULL) {
+		init_buffer(stream);
+	}
+	
 	len = (uv_buf_size_t) async_ring_buffer_write_len(&stream->buffer);
 	
 #ifdef HAVE_ASYNC_SSL
@@ -826,7 +1069,7 @@ ASYNC_CALLBACK read_alloc_cb(uv_handle_t *handle, size_t suggested, uv_buf_t *bu
 	buf->len = len;
 }
 
-ASYNC_CALLBACK timeout_read(uv_timer_t *timer)
+ASYNC_CALLBACK timeout_read(async_wheel_timer *timer)
 {
 	async_stream *stream;
 	
@@ -864,10 +1107,6 @@ int async_stream_read(async_stream *stream, async_stream_read_req *req)
 		return FAILURE;
 	}
 	
-	if (UNEXPECTED(stream->buffer.base == NULL)) {
-		init_buffer(stream);
-	}
-	
 	if ((blen = ASYNC_STREAM_BUFFER_LEN(stream)) > 0) {
 		if (UNEXPECTED(req->in.flags & ASYNC_STREAM_READ_REQ_FLAG_IMPORT)) {
 			req->out.error = UV_EALREADY;
@@ -882,6 +1121,10 @@ int async_stream_read(async_stream *stream, async_stream_read_req *req)
 		
 		ASYNC_STREAM_BUFFER_CONSUME(stream, req->out.len);
 		
+		if (stream->buffer.len == 0) {
+			release_buffer(stream);
+		}
+		
 		if (!(stream->flags && ASYNC_STREAM_EOF) && should_start_read(stream)) {
 			if (!(stream->flags & ASYNC_STREAM_READING)) {
 				uv_read_start(stream->handle, read_alloc_cb, read_cb);
@@ -914,13 +1157,20 @@ int async_stream_read(async_stream *stream, async_stream_read_req *req)
 	stream->read.req = req;
 	
 	if (req->in.timeout > 0) {
-		uv_timer_start(&stream->timer, timeout_read, req->in.timeout, 0);
+		stream->timer.func = timeout_read;
+		
+		async_timer_wheel_start(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer, req->in.timeout);
 	}
 	
 	code = await_op(stream, (async_op *) &stream->read);
 	
 	if (req->in.timeout > 0) {
-		uv_timer_stop(&stream->timer);
+		async_timer_wheel_stop(&ASYNC_STREAM_SCHEDULER(stream)->timers, &stream->timer);
+	}
+	
+	if (UNEXPECTED(stream->read.str != NULL)) {
+		zend_string_release(stream->read.str);
+		stream->read.str = NULL;
 	}
 	
 	if (UNEXPECTED(code == FAILURE)) {
@@ -939,6 +1189,8 @@ static zend_always_inline void cleanup_write(async_stream_write_op *op)
 {
 	if (op->flags & ASYNC_STREAM_WRITE_OP_FLAG_NEEDS_FREE) {
 		efree(op->out.data);
+	} else if (op->flags & ASYNC_STREAM_WRITE_OP_FLAG_POOLED) {
+		async_buffer_pool_release(&ASYNC_STREAM_SCHEDULER(op->stream)->buffers, op->out.data, op->capacity);
 	}
 	
 	if (op->flags & ASYNC_STREAM_WRITE_OP_FLAG_CALLBACK) {
@@ -958,6 +1210,61 @@ static zend_always_inline void cleanup_write(async_stream_write_op *op)
 	ASYNC_FREE_OP(op);
 }
 
+static zend_always_inline void gather_writes(async_stream_write_op *op)
+{
+	async_stream_write_op *next;
+	
+	uv_buf_t bufs[ASYNC_STREAM_MAX_GATHER];
+	unsigned int count;
+	
+	bufs[0] = uv_buf_init(op->out.data + op->out.offset, (unsigned int) (op->out.size - op->out.offset));
+	count = 1;
+	
+	next = (async_stream_write_op *) op->base.next;
+	
+	// Append queued writes to the same write request, all of them are completed by a single write callback.
+	while (next != NULL && count < ASYNC_STREAM_MAX_GATHER && !(next->flags & (ASYNC_STREAM_WRITE_OP_FLAG_STARTED | ASYNC_STREAM_WRITE_OP_FLAG_EXPORT))) {
+		encode_buffer(op->stream, next);
+		
+		bufs[count++] = uv_buf_init(next->out.data + next->out.offset, (unsigned int) (next->out.size - next->out.offset));
+		
+		next->flags |= ASYNC_STREAM_WRITE_OP_FLAG_STARTED | ASYNC_STREAM_WRITE_OP_FLAG_GATHERED;
+		next->batch = op;
+		
+		next = (async_stream_write_op *) next->base.next;
+	}
+	
+	if (count > 1) {
+		op->flags |= ASYNC_STREAM_WRITE_OP_FLAG_BATCH;
+	}
+	
+	uv_write(&op->req, op->stream->handle, bufs, count, write_cb);
+	
+	op->flags |= ASYNC_STREAM_WRITE_OP_FLAG_STARTED;
+}
+
+static zend_always_inline void finish_gathered_writes(async_stream_write_op *op, int status)
+{
+	async_stream_write_op *current;
+	async_stream_write_op *next;
+	
+	current = (async_stream_write_op *) op->stream->writes.first;
+	
+	while (current != NULL) {
+		next = (async_stream_write_op *) current->base.next;
+		
+		if (current->flags & ASYNC_STREAM_WRITE_OP_FLAG_GATHERED && current->batch == op) {
+			current->code = status;
+			
+			ASYNC_FINISH_OP(current);
+			
+			cleanup_write(current);
+		}
+		
+		current = next;
+	}
+}
+
 static zend_always_inline int process_write(async_stream_write_op *op)
 {
 	uv_buf_t bufs[1];
@@ -985,6 +1292,8 @@ static zend_always_inline int process_write(async_stream_write_op *op)
 	
 	if (UNEXPECTED(code == 0)) {
 		op->stream->flags |= ASYNC_STREAM_WANT_READ;
+	} else if (ASYNC_STREAM_CAN_GATHER(op->stream) && op->base.next != NULL) {
+		gather_writes(op);
 	} else {
 		bufs[0] = uv_buf_init(op->out.data + op->out.offset, (unsigned int) (op->out.size - op->out.offset));
 		
@@ -1012,6 +1321,12 @@ ASYNC_CALLBACK write_cb(uv_write_t *req, int status)
 	
 	op->code = status;
 	
+	if (op->flags & ASYNC_STREAM_WRITE_OP_FLAG_BATCH) {
+		op->flags &= ~ASYNC_STREAM_WRITE_OP_FLAG_BATCH;
+		
+		finish_gathered_writes(op, status);
+	}
+	
 	if (status < 0 || op->in.offset == op->in.size) {
 		ASYNC_FINISH_OP(op);
 		
@@ -1095,6 +1410,7 @@ int async_stream_write(async_stream *stream, async_stream_write_req *req)
 	
 	ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_stream_write_op));
 	
+	op->stream = stream;
 	op->in.data = req->in.buffer;
 	op->in.size = req->in.len;
 	
@@ -1164,7 +1480,6 @@ int async_stream_write(async_stream *stream, async_stream_write_req *req)
 	
 	ASYNC_APPEND_OP(&stream->writes, op);
 	
-	op->stream = stream;
 	op->req.data = op;
 	
 	if (req->in.flags & ASYNC_STREAM_WRITE_REQ_FLAG_ASYNC) {
@@ -1205,6 +1520,86 @@ int async_stream_write(async_stream *stream, async_stream_write_req *req)
 	return SUCCESS;
 }
 
+int async_stream_writev(async_stream *stream, uv_buf_t *bufs, unsigned int nbufs, async_stream_write_req *req)
+{
+	zend_string *str;
+	
+	unsigned int i;
+	size_t len;
+	int code;
+	
+	req->out.error = 0;
+	
+#ifdef HAVE_ASYNC_SSL
+	req->out.ssl_error = 0;
+#endif
+	
+	if (UNEXPECTED(stream->flags & ASYNC_STREAM_SHUT_WR)) {
+		req->out.error = UV_EOF;
+		return FAILURE;
+	}
+	
+	// Attempt to write all buffers using a single vectored write if no other write is pending.
+	if (stream->writes.first == NULL && !(stream->flags & ASYNC_STREAM_WRITING) && ASYNC_STREAM_CAN_GATHER(stream)) {
+		while (nbufs > 0) {
+			code = uv_try_write(stream->handle, bufs, nbufs);
+			
+			if (code == UV_EAGAIN) {
+				break;
+			}
+			
+			if (UNEXPECTED(code < 0)) {
+				req->out.error = code;
+				
+				return FAILURE;
+			}
+			
+			while (nbufs > 0 && (size_t) code >= bufs->len) {
+				code -= (int) bufs->len;
+				
+				bufs++;
+				nbufs--;
+			}
+			
+			if (nbufs > 0) {
+				bufs->base += code;
+				bufs->len -= code;
+			}
+		}
+		
+		if (nbufs == 0) {
+			return SUCCESS;
+		}
+	}
+	
+	len = 0;
+	
+	for (i = 0; i < nbufs; i++) {
+		len += bufs[i].len;
+	}
+	
+	// Remaining data is merged into a single write operation (encrypted as a whole on TLS streams).
+	str = zend_string_alloc(len, 0);
+	len = 0;
+	
+	for (i = 0; i < nbufs; i++) {
+		memcpy(ZSTR_VAL(str) + len, bufs[i].base, bufs[i].len);
+		len += bufs[i].len;
+	}
+	
+	ZSTR_VAL(str)[len] = '\0';
+	
+	req->in.len = len;
+	req->in.buffer = ZSTR_VAL(str);
+	req->in.str = str;
+	
+	code = async_stream_write(stream, req);
+	
+	zend_string_release(str);
+	
+	return code;
+}
+
 #ifdef HAVE_ASYNC_SSL
 
 ASYNC_CALLBACK receive_handshake_bytes_cb(uv_stream_t *handle, ssize_t nread, const uv_buf_t *buf)
@@ -1376,6 +1771,134 @@ static int send_handshake_bytes(async_stream *stream, async_ssl_handshake_data *
 	return SUCCESS;
 }
 
+typedef struct _async_stream_ssl_work {
+	async_op base;
+	uv_work_t req;
+	SSL *ssl;
+	int code;
+	int error;
+	int ssl_error;
+} async_stream_ssl_work;
+
+static void ssl_handshake_work(uv_work_t *req)
+{
+	async_stream_ssl_work *work;
+	
+	work = (async_stream_ssl_work *) req->data;
+	
+	// OpenSSL error queues are thread-local, errors have to be collected by the worker thread.
+	ERR_clear_error();
+	
+	work->code = SSL_do_handshake(work->ssl);
+	
+	if (work->code != 1) {
+		work->error = SSL_get_error(work->ssl, work->code);
+		work->ssl_error = (int) ERR_get_error();
+	}
+	
+	ERR_clear_error();
+}
+
+ASYNC_CALLBACK ssl_handshake_work_cb(uv_work_t *req, int status)
+{
+	async_stream_ssl_work *work;
+	
+	work = (async_stream_ssl_work *) req->data;
+	
+	ZEND_ASSERT(work != NULL);
+	
+	ASYNC_FINISH_OP(work);
+}
+
+static zend_always_inline zend_bool ssl_can_offload(async_stream *stream, async_ssl_handshake_data *handshake)
+{
+#ifndef ASYNC_TLS_OFFLOAD
+	return 0;
+#else
+	async_task_scheduler *scheduler;
+	
+	if (!ASYNC_G(tls_offload) || ASYNC_G(task) == NULL) {
+		return 0;
+	}
+	
+#ifdef PHP_WIN32
+	// Certificate verification using the system store reports errors using PHP warnings.
+	if (handshake->settings->mode == ASYNC_SSL_MODE_CLIENT) {
+		return 0;
+	}
+#endif
+
+	// Steps without input (sending the client hello or waiting for it) are cheap enough to run inline.
+	if (BIO_ctrl_pending(stream->ssl.rbio) == 0) {
+		return 0;
+	}
+	
+	scheduler = ASYNC_STREAM_SCHEDULER(stream);
+	
+	return !(scheduler->flags & (ASYNC_TASK_SCHEDULER_FLAG_DISPOSED | ASYNC_TASK_SCHEDULER_FLAG_ERROR));
+#endif
+}
+
+/* Runs a single handshake step on the libuv thread pool, the calling task is suspended until the step has completed. */
+static int ssl_offload_handshake(async_stream *stream, async_ssl_handshake_data *handshake, int *result, int *error)
+{
+	async_stream_ssl_work *work;
+	async_op_list list;
+	
+	int code;
+	
+	ASYNC_ALLOC_CUSTOM_OP(work, sizeof(async_stream_ssl_work));
+	
+	work->req.data = work;
+	work->ssl = stream->ssl.ssl;
+	
+	// The operation cannot be cancelled or failed by the scheduler, the engine must not be disposed while a worker is using it.
+	memset(&list, 0, sizeof(async_op_list));
+	
+	ASYNC_APPEND_OP(&list, work);
+	
+	work->base.flags |= ASYNC_OP_FLAG_ATOMIC;
+	
+	async_ssl_offload_begin(handshake->settings);
+	async_ssl_bio_set_pool(stream->ssl.wbio, NULL);
+	
+	code = uv_queue_work(stream->handle->loop, &work->req, ssl_handshake_work, ssl_handshake_work_cb);
+	
+	if (UNEXPECTED(code < 0)) {
+		async_ssl_bio_set_pool(stream->ssl.wbio, &ASYNC_STREAM_SCHEDULER(stream)->buffers);
+		async_ssl_offload_end(handshake->settings);
+		ASYNC_FREE_OP(work);
+		
+		handshake->uv_error = code;
+		
+		return FAILURE;
+	}
+	
+	ASYNC_STREAM_SCHEDULER(stream)->tls.offloaded++;
+	
+	code = await_op(stream, (async_op *) work);
+	
+	async_ssl_bio_set_pool(stream->ssl.wbio, &ASYNC_STREAM_SCHEDULER(stream)->buffers);
+	async_ssl_offload_end(handshake->settings);
+	
+	if (UNEXPECTED(code == FAILURE)) {
+		ASYNC_FREE_OP(work);
+		
+		return FAILURE;
+	}
+	
+	*result = work->code;
+	*error = work->error;
+	
+	if (work->code != 1) {
+		handshake->ssl_error = work->ssl_error;
+	}
+	
+	ASYNC_FREE_OP(work);
+	
+	return SUCCESS;
+}
+
 int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *handshake)
 {
 	X509 *cert;
@@ -1383,14 +1906,11 @@ int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *h
 	long result;
 	int code;
 	int error;
+	zend_bool offload;
 	
 	ZEND_ASSERT(stream->ssl.ssl != NULL);
 	ZEND_ASSERT(handshake->settings != NULL);
 
-	if (UNEXPECTED(stream->buffer.base == NULL)) {
-		init_buffer(stream);
-	}
-
 	if (stream->flags & ASYNC_STREAM_READING) {
 		uv_read_stop(stream->handle);
 
@@ -1414,15 +1934,23 @@ int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *h
 	}
 	
 	do {
-		ERR_clear_error();
-		
-		code = SSL_do_handshake(stream->ssl.ssl);
+		if ((offload = ssl_can_offload(stream, handshake))) {
+			if (UNEXPECTED(SUCCESS != ssl_offload_handshake(stream, handshake, &code, &error))) {
+				return FAILURE;
+			}
+		} else {
+			ERR_clear_error();
+			
+			code = SSL_do_handshake(stream->ssl.ssl);
+		}
 		
 		if (code == 1) {
 			break;
 		}
 		
-		error = SSL_get_error(stream->ssl.ssl, code);
+		if (!offload) {
+			error = SSL_get_error(stream->ssl.ssl, code);
+		}
 		
 		switch (error) {
 		case SSL_ERROR_NONE:
@@ -1439,7 +1967,9 @@ int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *h
 			}
 			break;
 		default:
-			handshake->ssl_error = ERR_get_error();
+			if (!offload) {
+				handshake->ssl_error = ERR_get_error();
+			}
 			
 			return FAILURE;
 		}
@@ -1482,6 +2012,48 @@ int async_stream_ssl_handshake(async_stream *stream, async_ssl_handshake_data *h
 	return SUCCESS;
 }
 
+/*
+ * Hands record encryption over to the kernel and switches the stream to the plain read / write path. Only possible
+ * if neither the SSL engine nor the stream buffer hold any data, FAILURE indicates that the stream keeps using the
+ * SSL engine unless an error has been set.
+ */
+int async_stream_ssl_enable_ktls(async_stream *stream, zend_bool ctx, int *error)
+{
+#ifdef ASYNC_TLS_KTLS
+	uv_os_fd_t fd;
+	
+	*error = 0;
+	
+	if (stream->buffer.len > 0 || stream->writes.first != NULL || stream->flags & (ASYNC_STREAM_EOF | ASYNC_STREAM_SSL_FATAL)) {
+		return FAILURE;
+	}
+	
+	if (SSL_has_pending(stream->ssl.ssl) || BIO_ctrl_pending(stream->ssl.rbio) > 0 || BIO_ctrl_pending(stream->ssl.wbio) > 0) {
+		return FAILURE;
+	}
+	
+	if (0 != uv_fileno((uv_handle_t *) stream->handle, &fd)) {
+		return FAILURE;
+	}
+	
+	if (SUCCESS != async_ssl_enable_ktls(stream->ssl.ssl, (int) fd, error)) {
+		return FAILURE;
+	}
+	
+	async_ssl_dispose_engine(&stream->ssl, ctx);
+	
+	stream->ssl.available = 0;
+	stream->ssl.pending = 0;
+	stream->flags |= ASYNC_STREAM_KTLS;
+	
+	return SUCCESS;
+#else
+	*error = 0;
+	
+	return FAILURE;
+#endif
+}
+
 #endif
 
 
@@ -1497,10 +2069,12 @@ static const zend_function_entry async_readable_stream_functions[] = {
 
 static PHP_METHOD(WritableStream, close) { }
 static PHP_METHOD(WritableStream, write) { }
+static PHP_METHOD(WritableStream, writeAll) { }
 
 static const zend_function_entry async_writable_stream_functions[] = {
 	PHP_ME(WritableStream, close, arginfo_stream_close, ZEND_ACC_PUBLIC | ZEND_ACC_ABSTRACT)
 	PHP_ME(WritableStream, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC | ZEND_ACC_ABSTRACT)
+	PHP_ME(WritableStream, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC | ZEND_ACC_ABSTRACT)
 	PHP_FE_END
 };
 
@@ -1774,6 +2348,36 @@ static PHP_METHOD(WritableMemoryStream, write)
 	smart_str_append(&stream->data, data);
 }
 
+static PHP_METHOD(WritableMemoryStream, writeAll)
+{
+	async_writable_memory_stream *stream;
+
+	HashTable *chunks;
+	zend_string *data;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ARRAY_HT(chunks)
+	ZEND_PARSE_PARAMETERS_END();
+
+	stream = (async_writable_memory_stream *) Z_OBJ_P(getThis());
+
+	if (stream->flags & ASYNC_WRITABLE_MEMORY_STREAM_FLAG_CLOSED) {
+		zend_throw_exception(async_stream_closed_exception_ce, "Cannot write to closed stream", 0);
+
+		if (Z_TYPE(stream->error) != IS_UNDEF) {
+			zend_exception_set_previous(EG(exception), Z_OBJ(stream->error));
+			GC_ADDREF(Z_OBJ(stream->error));
+		}
+
+		return;
+	}
+
+	if (EXPECTED(NULL != (data = async_stream_join_chunks(chunks)))) {
+		smart_str_append(&stream->data, data);
+		zend_string_release(data);
+	}
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_WAKEUP(WritableMemoryStream, async_writable_memory_stream_ce)
 //LCOV_EXCL_STOP
@@ -1784,6 +2388,7 @@ static const zend_function_entry async_writable_memory_stream_functions[] = {
 	PHP_ME(WritableMemoryStream, getContents, arginfo_writable_memory_stream_get_contents, ZEND_ACC_PUBLIC)
 	PHP_ME(WritableMemoryStream, close, arginfo_stream_close, ZEND_ACC_PUBLIC)
 	PHP_ME(WritableMemoryStream, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(WritableMemoryStream, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -1936,6 +2541,15 @@ static PHP_METHOD(StreamWriter, write)
 	async_stream_call_write(writer->stream, writer->error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 
+static PHP_METHOD(StreamWriter, writeAll)
+{
+	async_stream_writer *writer;
+
+	writer = (async_stream_writer *) Z_OBJ_P(getThis());
+
+	async_stream_call_write_all(writer->stream, writer->error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_CTOR(StreamWriter, async_stream_writer_ce)
 ASYNC_METHOD_NO_WAKEUP(StreamWriter, async_stream_writer_ce)
@@ -1946,6 +2560,7 @@ static const zend_function_entry async_stream_writer_functions[] = {
 	PHP_ME(StreamWriter, __wakeup, arginfo_no_wakeup, ZEND_ACC_PUBLIC)
 	PHP_ME(StreamWriter, close, arginfo_stream_close, ZEND_ACC_PUBLIC)
 	PHP_ME(StreamWriter, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(StreamWriter, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
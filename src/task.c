@@ -18,9 +18,12 @@
 
 #include "php_async.h"
 
+#include "async/buffer.h"
 #include "async/helper.h"
 #include "async/fiber.h"
 #include "async/event.h"
+#include "async/ssl.h"
+#include "async/wheel.h"
 
 #include "zend_builtin_functions.h"
 
@@ -60,6 +63,9 @@ static void dispose_ticks(async_task_scheduler *scheduler);
 #define ASYNC_TASK_STATUS_FINISHED ASYNC_OP_RESOLVED
 #define ASYNC_TASK_STATUS_FAILED ASYNC_OP_FAILED
 
+#define ASYNC_TASK_CONST(name, value) \
+	zend_declare_class_constant_long(async_task_ce, name, sizeof(name)-1, (zend_long)value);
+
 static zend_string *str_main;
 static zend_string *str_status;
 static zend_string *str_file;
@@ -146,7 +152,7 @@ static int task_await_delegate(zend_object *obj, zval *result, async_task *calle
 		return ASYNC_OP_FAILED;
 	}
 
-	if (UNEXPECTED(flags & ASYNC_AWAIT_HANDLER_INLINE && task->fiber == NULL)) {
+	if (UNEXPECTED(flags & ASYNC_AWAIT_HANDLER_INLINE && task->fiber == NULL && task->status == ASYNC_TASK_STATUS_INIT)) {
 		if (caller == NULL || task->stack_size <= caller->stack_size) {
 			async_task_execute_inline(task, context);
 		}
@@ -398,7 +404,7 @@ ASYNC_FIBER_CALLBACK run_task_fiber(void *arg)
 	func.try_catch_array = &task_terminate_try_catch_array;
 	func.filename = (Z_TYPE_P(file) == IS_NULL) ? ZSTR_EMPTY_ALLOC() : zend_string_copy(Z_STR_P(file));
 
-	stack = (zend_vm_stack) emalloc(ASYNC_FIBER_VM_STACK_SIZE);
+	stack = async_fiber_pool_acquire_vm_stack(async_fiber_pool_get(task->scheduler));
 	stack->top = ZEND_VM_STACK_ELEMENTS(stack) + 1;
 	stack->end = (zval *) ((char *) stack + ASYNC_FIBER_VM_STACK_SIZE);
 	stack->prev = NULL;
@@ -438,7 +444,7 @@ ASYNC_FIBER_CALLBACK run_task_fiber(void *arg)
 	zend_string_release(func.function_name);
 	zend_string_release(func.filename);
 
-	zend_vm_stack_destroy();
+	async_fiber_pool_release_vm_stack(async_fiber_pool_get(task->scheduler), EG(vm_stack));
 
 	async_fiber_suspend(task->scheduler);
 }
@@ -493,6 +499,22 @@ static int task_run_opcode_handler(zend_execute_data *exec)
 	return ZEND_USER_OPCODE_RETURN;
 }
 
+static zend_always_inline void measure_stack_usage(async_task *task)
+{
+	async_task_scheduler *scheduler;
+
+	scheduler = task->scheduler;
+
+	task->stack_usage = async_fiber_stack_usage(task->fiber);
+
+	if (task->stack_usage > scheduler->stack_usage.max) {
+		scheduler->stack_usage.max = task->stack_usage;
+	}
+
+	scheduler->stack_usage.total += task->stack_usage;
+	scheduler->stack_usage.count++;
+}
+
 static zend_always_inline void async_task_dispose(async_task *task)
 {
 	if (task->flags & ASYNC_TASK_FLAG_DISPOSED) {
@@ -503,17 +525,34 @@ static zend_always_inline void async_task_dispose(async_task *task)
 
 	task->flags |= ASYNC_TASK_FLAG_DISPOSED;
 
+	// Fiber has terminated, it can be reused by another task.
+	if (task->fiber != NULL) {
+		if (UNEXPECTED(ASYNC_G(stack_usage))) {
+			measure_stack_usage(task);
+		}
+
+		async_fiber_pool_release(async_fiber_pool_get(task->scheduler), task->fiber);
+		task->fiber = NULL;
+	}
+
 	trigger_ops(task);
 	
 	ASYNC_DELREF(&task->std);
 }
 
+static zend_always_inline uint8_t ready_level(async_task *task)
+{
+	// Root pseudo task does not provide storage for a priority.
+	return (task->flags & ASYNC_TASK_FLAG_ROOT) ? ASYNC_TASK_PRIORITY_NORMAL : task->priority;
+}
+
 static void async_task_execute_inline(async_task *task, async_context *context)
 {
 	zval tmp;
 	zval *status;
 
-	ASYNC_LIST_REMOVE(&task->scheduler->ready, task);
+	ASYNC_LIST_REMOVE(&task->scheduler->ready[ready_level(task)], task);
+	task->scheduler->dispatch.depth--;
 
 	// Mark task fiber as suspended to avoid duplicate inlining attempts.
 	task->status = ASYNC_TASK_STATUS_RUNNING;
@@ -913,7 +952,7 @@ static async_task *async_task_object_create(zend_execute_data *call, async_task_
 	stack_size = ASYNC_G(stack_size);
 
 	if (stack_size == 0) {
-		stack_size = 4096 * (((sizeof(void *)) < 8) ? 16 : 128);
+		stack_size = ASYNC_FIBER_DEFAULT_STACK_SIZE;
 	}
 
 	task->stack_size = stack_size;
@@ -922,6 +961,7 @@ static async_task *async_task_object_create(zend_execute_data *call, async_task_
 
 	task->scheduler = scheduler;
 	task->context = context;
+	task->priority = context->priority;
 	
 	ASYNC_ADDREF(&context->std);
 
@@ -965,6 +1005,42 @@ static void async_task_object_destroy(zend_object *object)
 	zend_object_std_dtor(&task->std);
 }
 
+static ASYNC_DEBUG_INFO_HANDLER(task_debug_info)
+{
+	async_task *task;
+	zend_object *object;
+
+	zval info;
+
+	object = ASYNC_DEBUG_INFO_OBJ();
+
+	if (object->properties == NULL) {
+		rebuild_object_properties(object);
+	}
+
+	if (EXPECTED(!ASYNC_G(stack_usage))) {
+		*temp = 0;
+
+		return object->properties;
+	}
+
+	*temp = 1;
+
+	task = async_task_obj(object);
+
+	ZVAL_ARR(&info, zend_array_dup(object->properties));
+
+	add_assoc_long(&info, "stack_size", task->stack_size);
+
+	if (task->fiber != NULL) {
+		add_assoc_long(&info, "stack_usage", (zend_long) async_fiber_stack_usage(task->fiber));
+	} else {
+		add_assoc_long(&info, "stack_usage", (zend_long) task->stack_usage);
+	}
+
+	return Z_ARRVAL(info);
+}
+
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_task_async, 0, 1, Concurrent\\Awaitable, 0)
 	ZEND_ARG_CALLABLE_INFO(0, callback, 0)
 	ZEND_ARG_VARIADIC_INFO(0, arguments)
@@ -1145,17 +1221,84 @@ static const zend_function_entry task_functions[] = {
 };
 
 
+static zend_always_inline void track_queue_time(async_task_scheduler *scheduler, async_task *task)
+{
+	uint64_t wait;
+	int i;
+
+	// Bucket boundaries grow by a factor of 10 starting at 10 microseconds.
+	wait = (uv_hrtime() - task->enqueued) / 10000;
+
+	for (i = 0; i < ASYNC_TASK_SCHEDULER_WAIT_BUCKETS - 1 && wait > 0; i++) {
+		wait /= 10;
+	}
+
+	scheduler->dispatch.wait[i]++;
+}
+
+static zend_always_inline async_task *extract_ready_task(async_task_scheduler *scheduler)
+{
+	async_task *task;
+	int level;
+	int aged;
+	int i;
+
+	level = ASYNC_TASK_PRIORITY_LEVELS - 1;
+
+	while (scheduler->ready[level].first == NULL) {
+		ZEND_ASSERT(level > 0);
+
+		level--;
+	}
+
+	// Lower priority queues age while a higher level is dispatched, the lowest level that exceeds the limit runs instead.
+	if (ASYNC_G(priority_aging) > 0) {
+		aged = -1;
+
+		for (i = level - 1; i >= 0; i--) {
+			if (scheduler->ready[i].first != NULL && ++scheduler->ready[i].age > (uint32_t) ASYNC_G(priority_aging)) {
+				aged = i;
+			}
+		}
+
+		if (UNEXPECTED(aged >= 0)) {
+			level = aged;
+
+			scheduler->dispatch.aged++;
+		}
+	}
+
+	scheduler->ready[level].age = 0;
+
+	ASYNC_LIST_EXTRACT_FIRST(&scheduler->ready[level], task);
+
+	return task;
+}
+
 ASYNC_CALLBACK dispatch_tasks(uv_idle_t *idle)
 {
 	async_task_scheduler *scheduler;
 	async_task *task;
+	
+	zend_long budget;
+	uint64_t deadline;
 
 	scheduler = (async_task_scheduler *) idle->data;
 
 	ZEND_ASSERT(scheduler != NULL);
+	
+	budget = ASYNC_G(dispatch_budget);
+	deadline = (ASYNC_G(dispatch_time) > 0) ? (uv_hrtime() + (uint64_t) ASYNC_G(dispatch_time) * 1000) : 0;
 
-	while (scheduler->ready.first != NULL) {
-		ASYNC_LIST_EXTRACT_FIRST(&scheduler->ready, task);
+	while (scheduler->dispatch.depth > 0) {
+		task = extract_ready_task(scheduler);
+		
+		scheduler->dispatch.depth--;
+		scheduler->dispatch.dispatched++;
+		
+		if (ASYNC_G(dispatch_stats) && !(task->flags & ASYNC_TASK_FLAG_ROOT)) {
+			track_queue_time(scheduler, task);
+		}
 
 		if (EXPECTED(task->fiber == NULL)) {
 			if (UNEXPECTED(scheduler->flags & ASYNC_TASK_SCHEDULER_FLAG_ERROR)) {
@@ -1164,7 +1307,7 @@ ASYNC_CALLBACK dispatch_tasks(uv_idle_t *idle)
 				continue;
 			}
 
-			task->fiber = async_fiber_create();
+			task->fiber = async_fiber_pool_acquire(async_fiber_pool_get(scheduler));
 		
 			ASYNC_CHECK_FATAL(task->fiber == NULL, "Failed to create native fiber context");
 			ASYNC_CHECK_FATAL(!async_fiber_init(task->fiber, task->context, run_task_fiber, task, task->stack_size), "Failed to create native fiber");
@@ -1179,6 +1322,13 @@ ASYNC_CALLBACK dispatch_tasks(uv_idle_t *idle)
 		if (UNEXPECTED(task->status == ASYNC_OP_RESOLVED || task->status == ASYNC_OP_FAILED)) {
 			async_task_dispose(task);
 		}
+		
+		// Yield to the event loop when the budget is exhausted, idle handle stays active to continue after I/O polling.
+		if (scheduler->dispatch.depth > 0 && ((budget > 0 && --budget == 0) || (deadline > 0 && uv_hrtime() >= deadline))) {
+			scheduler->dispatch.exhausted++;
+			
+			return;
+		}
 	}
 	
 	uv_idle_stop(idle);
@@ -1199,6 +1349,10 @@ ASYNC_CALLBACK dispose_walk_cb(uv_handle_t *handle, void *arg)
 	if (UNEXPECTED((void *) handle == (void *) &scheduler->busy)) {
 		return;
 	}
+	
+	if (UNEXPECTED((void *) handle == (void *) &scheduler->timers.handle)) {
+		return;
+	}
 
 	ASYNC_UV_TRY_CLOSE(handle, NULL);
 }
@@ -1364,11 +1518,20 @@ static zend_always_inline void async_task_scheduler_enqueue(async_task *task)
 		}
 	}
 
-	if (scheduler->ready.first == NULL) {
+	if (scheduler->dispatch.depth == 0) {
 		uv_idle_start(&scheduler->idle, dispatch_tasks);
 	}
 
-	ASYNC_LIST_APPEND(&scheduler->ready, task);
+	ASYNC_LIST_APPEND(&scheduler->ready[ready_level(task)], task);
+	
+	if (++scheduler->dispatch.depth > scheduler->dispatch.max_depth) {
+		scheduler->dispatch.max_depth = scheduler->dispatch.depth;
+	}
+	
+	// Root pseudo task does not provide storage for the enqueue timestamp.
+	if (ASYNC_G(dispatch_stats) && !(task->flags & ASYNC_TASK_FLAG_ROOT)) {
+		task->enqueued = uv_hrtime();
+	}
 }
 
 static zend_always_inline void async_task_scheduler_run_loop(async_task_scheduler *scheduler)
@@ -1567,6 +1730,8 @@ static async_task_scheduler *async_task_scheduler_object_create()
 	uv_timer_init(&scheduler->loop, &scheduler->busy);
 	uv_timer_start(&scheduler->busy, busy_timer, 3600 * 1000, 3600 * 1000);	
 	uv_unref((uv_handle_t *) &scheduler->busy);
+	
+	async_timer_wheel_init(&scheduler->timers, &scheduler->loop, (uint64_t) ASYNC_G(timer_granularity));
 
 	scheduler->idle.data = scheduler;
 	
@@ -1575,6 +1740,11 @@ static async_task_scheduler *async_task_scheduler_object_create()
 	
 	zend_hash_init(&scheduler->components, 0, NULL, ZVAL_PTR_DTOR, 0);
 
+#ifdef HAVE_ASYNC_SSL
+	zend_hash_init(&scheduler->sessions, 0, NULL, async_ssl_session_dtor, 0);
+	zend_hash_init(&scheduler->contexts, 0, NULL, async_ssl_context_dtor, 0);
+#endif
+
 	scheduler->root.scheduler = scheduler;
 	scheduler->root.flags = ASYNC_TASK_FLAG_ROOT;
 	scheduler->root.status = ASYNC_TASK_STATUS_SUSPENDED;
@@ -1618,9 +1788,16 @@ static void async_task_scheduler_object_destroy(zend_object *object)
 	
 	zend_hash_destroy(&scheduler->components);
 
+#ifdef HAVE_ASYNC_SSL
+	zend_hash_destroy(&scheduler->sessions);
+	zend_hash_destroy(&scheduler->contexts);
+#endif
+
 	ASYNC_UV_CLOSE((uv_handle_t *) &scheduler->busy, NULL);
 	ASYNC_UV_CLOSE((uv_handle_t *) &scheduler->idle, NULL);
 	
+	async_timer_wheel_close(&scheduler->timers);
+	
 	// Run loop again to cleanup idle watcher.
 	uv_run(&scheduler->loop, UV_RUN_DEFAULT);
 
@@ -1639,9 +1816,12 @@ static void async_task_scheduler_object_destroy(zend_object *object)
 		async_fiber_destroy(scheduler->runner);
 	}
 	
+	async_fiber_pool_dispose(&scheduler->pool);
+	async_buffer_pool_dispose(&scheduler->buffers);
+	
 #if ZEND_DEBUG
 	ZEND_ASSERT(code == 0);
-	ZEND_ASSERT(scheduler->ready.first == NULL);
+	ZEND_ASSERT(scheduler->dispatch.depth == 0);
 	ZEND_ASSERT(scheduler->fibers.first == NULL);
 #endif
 
@@ -1655,6 +1835,7 @@ ASYNC_CALLBACK debug_pending_tasks(async_task_scheduler *scheduler, zend_fcall_i
 	async_task *task;
 
 	zend_ulong i;
+	int level;
 
 	zval args[1];
 	zval retval;
@@ -1662,17 +1843,20 @@ ASYNC_CALLBACK debug_pending_tasks(async_task_scheduler *scheduler, zend_fcall_i
 	
 	array_init(&args[0]);
 
-	task = scheduler->ready.first;
 	i = 0;
 
-	while (task != NULL) {
-		ZVAL_OBJ(&obj, &task->std);
-		ASYNC_ADDREF(&task->std);
+	for (level = ASYNC_TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+		task = scheduler->ready[level].first;
 
-		zend_hash_index_update(Z_ARRVAL_P(&args[0]), i, &obj);
+		while (task != NULL) {
+			ZVAL_OBJ(&obj, &task->std);
+			ASYNC_ADDREF(&task->std);
+
+			zend_hash_index_update(Z_ARRVAL_P(&args[0]), i, &obj);
 
-		task = task->next;
-		i++;
+			task = task->next;
+			i++;
+		}
 	}
 
 	fci->param_count = 1;
@@ -2100,6 +2284,141 @@ static PHP_METHOD(TaskScheduler, poll)
 	}
 }
 
+static zend_always_inline void stats_fiber_pool(async_fiber_pool *pool, zval *info)
+{
+	array_init(info);
+
+	add_assoc_bool(info, "shared", ASYNC_G(fiber_pool_shared));
+	add_assoc_long(info, "size", pool->size);
+	add_assoc_long(info, "max_size", ASYNC_G(fiber_pool_size));
+	add_assoc_long(info, "hits", (zend_long) pool->hits);
+	add_assoc_long(info, "misses", (zend_long) pool->misses);
+	add_assoc_long(info, "discarded", (zend_long) pool->discarded);
+	add_assoc_long(info, "vm_stacks", pool->page_count);
+}
+
+static zend_always_inline void stats_stack_usage(async_task_scheduler *scheduler, zval *info)
+{
+	array_init(info);
+
+	add_assoc_bool(info, "tracked", ASYNC_G(stack_usage));
+	add_assoc_long(info, "size", (ASYNC_G(stack_size) == 0) ? ASYNC_FIBER_DEFAULT_STACK_SIZE : ASYNC_G(stack_size));
+	add_assoc_long(info, "max_usage", (zend_long) scheduler->stack_usage.max);
+	add_assoc_long(info, "avg_usage", (zend_long) (scheduler->stack_usage.count ? (scheduler->stack_usage.total / scheduler->stack_usage.count) : 0));
+	add_assoc_long(info, "samples", (zend_long) scheduler->stack_usage.count);
+}
+
+static zend_always_inline void stats_dispatch(async_task_scheduler *scheduler, zval *info)
+{
+	static const char *labels[ASYNC_TASK_SCHEDULER_WAIT_BUCKETS] = { "10us", "100us", "1ms", "10ms", "100ms", "1s", "inf" };
+
+	zval wait;
+	int i;
+
+	array_init(info);
+
+	add_assoc_long(info, "budget", ASYNC_G(dispatch_budget));
+	add_assoc_long(info, "budget_time", ASYNC_G(dispatch_time));
+	add_assoc_bool(info, "tracked", ASYNC_G(dispatch_stats));
+	add_assoc_long(info, "ready", scheduler->dispatch.depth);
+	add_assoc_long(info, "max_ready", scheduler->dispatch.max_depth);
+	add_assoc_long(info, "dispatched", (zend_long) scheduler->dispatch.dispatched);
+	add_assoc_long(info, "exhausted", (zend_long) scheduler->dispatch.exhausted);
+	add_assoc_long(info, "priority_aging", ASYNC_G(priority_aging));
+	add_assoc_long(info, "aged", (zend_long) scheduler->dispatch.aged);
+
+	array_init_size(&wait, ASYNC_TASK_SCHEDULER_WAIT_BUCKETS);
+
+	for (i = 0; i < ASYNC_TASK_SCHEDULER_WAIT_BUCKETS; i++) {
+		add_assoc_long(&wait, labels[i], (zend_long) scheduler->dispatch.wait[i]);
+	}
+
+	add_assoc_zval(info, "wait_histogram", &wait);
+}
+
+static zend_always_inline void stats_buffers(async_task_scheduler *scheduler, zval *info)
+{
+	array_init(info);
+
+	add_assoc_long(info, "min_size", ASYNC_G(read_buffer));
+	add_assoc_long(info, "max_size", MAX(ASYNC_G(read_buffer_max), ASYNC_G(read_buffer)));
+	add_assoc_long(info, "count", (zend_long) scheduler->buffers.count);
+	add_assoc_long(info, "memory", (zend_long) scheduler->buffers.size);
+	add_assoc_long(info, "peak_memory", (zend_long) scheduler->buffers.peak);
+	add_assoc_long(info, "pooled", (zend_long) scheduler->buffers.pooled);
+	add_assoc_long(info, "max_pooled", ASYNC_G(buffer_pool));
+	add_assoc_long(info, "hits", (zend_long) scheduler->buffers.hits);
+	add_assoc_long(info, "misses", (zend_long) scheduler->buffers.misses);
+	add_assoc_long(info, "discarded", (zend_long) scheduler->buffers.discarded);
+	add_assoc_long(info, "grown", (zend_long) scheduler->buffers.grown);
+	add_assoc_long(info, "shrunk", (zend_long) scheduler->buffers.shrunk);
+}
+
+static zend_always_inline void stats_timers(async_task_scheduler *scheduler, zval *info)
+{
+	array_init(info);
+
+	add_assoc_long(info, "granularity", (zend_long) scheduler->timers.granularity);
+	add_assoc_long(info, "active", (zend_long) scheduler->timers.count);
+	add_assoc_long(info, "expired", (zend_long) scheduler->timers.expired);
+	add_assoc_long(info, "cascaded", (zend_long) scheduler->timers.cascaded);
+}
+
+static zend_always_inline void stats_tls(async_task_scheduler *scheduler, zval *info)
+{
+	array_init(info);
+
+#ifdef HAVE_ASYNC_SSL
+	add_assoc_long(info, "sessions", zend_hash_num_elements(&scheduler->sessions));
+	add_assoc_long(info, "contexts", zend_hash_num_elements(&scheduler->contexts));
+#else
+	add_assoc_long(info, "sessions", 0);
+	add_assoc_long(info, "contexts", 0);
+#endif
+	add_assoc_long(info, "client_hits", (zend_long) scheduler->tls.client_hits);
+	add_assoc_long(info, "client_misses", (zend_long) scheduler->tls.client_misses);
+	add_assoc_long(info, "server_hits", (zend_long) scheduler->tls.server_hits);
+	add_assoc_long(info, "server_misses", (zend_long) scheduler->tls.server_misses);
+	add_assoc_long(info, "context_hits", (zend_long) scheduler->tls.context_hits);
+	add_assoc_long(info, "context_misses", (zend_long) scheduler->tls.context_misses);
+	add_assoc_long(info, "offloaded", (zend_long) scheduler->tls.offloaded);
+	add_assoc_long(info, "ktls", (zend_long) scheduler->tls.ktls);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_task_scheduler_get_stats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(TaskScheduler, getStats)
+{
+	async_task_scheduler *scheduler;
+
+	zval info;
+
+	ZEND_PARSE_PARAMETERS_NONE();
+
+	scheduler = async_task_scheduler_get();
+
+	array_init(return_value);
+
+	stats_fiber_pool(async_fiber_pool_get(scheduler), &info);
+	add_assoc_zval(return_value, "fiber_pool", &info);
+
+	stats_stack_usage(scheduler, &info);
+	add_assoc_zval(return_value, "stack", &info);
+
+	stats_dispatch(scheduler, &info);
+	add_assoc_zval(return_value, "dispatch", &info);
+
+	stats_buffers(scheduler, &info);
+	add_assoc_zval(return_value, "buffers", &info);
+
+	stats_timers(scheduler, &info);
+	add_assoc_zval(return_value, "timers", &info);
+
+	stats_tls(scheduler, &info);
+	add_assoc_zval(return_value, "tls", &info);
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_CTOR(TaskScheduler, async_task_scheduler_ce)
 ASYNC_METHOD_NO_WAKEUP(TaskScheduler, async_task_scheduler_ce)
@@ -2112,6 +2431,7 @@ static const zend_function_entry task_scheduler_functions[] = {
 	PHP_ME(TaskScheduler, runWithContext, arginfo_task_scheduler_run_with_context, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(TaskScheduler, get, arginfo_task_scheduler_get, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(TaskScheduler, register, arginfo_task_scheduler_register, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(TaskScheduler, getStats, arginfo_task_scheduler_get_stats, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(TaskScheduler, tick, arginfo_task_scheduler_tick, ZEND_ACC_PUBLIC)
 	PHP_ME(TaskScheduler, timer, arginfo_task_scheduler_timer, ZEND_ACC_PUBLIC)
 	PHP_ME(TaskScheduler, poll, arginfo_task_scheduler_poll, ZEND_ACC_PUBLIC)
@@ -2206,6 +2526,11 @@ void async_task_ce_register()
 	async_task_handlers.free_obj = async_task_object_destroy;
 	async_task_handlers.clone_obj = NULL;
 	async_task_handlers.write_property = async_prop_write_handler_readonly;
+	async_task_handlers.get_debug_info = task_debug_info;
+	
+	ASYNC_TASK_CONST("PRIORITY_LOW", ASYNC_TASK_PRIORITY_LOW);
+	ASYNC_TASK_CONST("PRIORITY_NORMAL", ASYNC_TASK_PRIORITY_NORMAL);
+	ASYNC_TASK_CONST("PRIORITY_HIGH", ASYNC_TASK_PRIORITY_HIGH);
 	
 #if PHP_VERSION_ID < 70400
 	zend_declare_property_null(async_task_ce, ZEND_STRL("status"), ZEND_ACC_PUBLIC);
@@ -2262,6 +2587,8 @@ void async_task_scheduler_init()
 	async_task_scheduler *scheduler;
 	async_fiber *fiber;
 	
+	memset(&ASYNC_G(fiber_pool), 0, sizeof(async_fiber_pool));
+
 	scheduler = async_task_scheduler_object_create();
 	
 	ASYNC_G(executor) = scheduler;
@@ -2309,6 +2636,7 @@ void async_task_scheduler_shutdown()
 	zend_hash_destroy(ASYNC_G(factories));
 	FREE_HASHTABLE(ASYNC_G(factories));
 
+	async_fiber_pool_dispose(&ASYNC_G(fiber_pool));
 	async_fiber_destroy(ASYNC_G(root));
 
 	ASYNC_DELREF(ASYNC_G(awaitable));
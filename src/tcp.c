@@ -25,6 +25,7 @@
 #include "win32/sockets.h"
 #else
 #include <sys/uio.h>
+#include <fcntl.h>
 #endif
 
 #define ASYNC_SOCKET_TCP_NODELAY 100
@@ -41,6 +42,16 @@ static zend_string *str_wildcard;
 
 #define ASYNC_TCP_SERVER_FLAG_LAZY 1
 
+#define ASYNC_TCP_SERVER_BACKLOG 128
+
+#if SIZEOF_ZEND_LONG > SIZEOF_INT
+#define ASYNC_TCP_SERVER_BACKLOG_INVALID(backlog) ((backlog) < 1 || (backlog) > (zend_long) INT_MAX)
+#else
+#define ASYNC_TCP_SERVER_BACKLOG_INVALID(backlog) ((backlog) < 1)
+#endif
+
+#define ASYNC_TCP_SERVER_BATCH 64
+
 typedef struct _async_tcp_server {
 	/* PHP object handle. */
 	zend_object std;
@@ -60,7 +71,10 @@ typedef struct _async_tcp_server {
 	uint16_t port;
 
 	/* Number of pending connection attempts queued in the backlog. */
-	zend_uchar pending;
+	uint32_t pending;
+	
+	/* Maximum length of the queue of pending connections. */
+	int backlog;
 
 	/* Error being used to close the server. */
 	zval error;
@@ -81,6 +95,9 @@ typedef struct _async_tcp_server {
 
 	/* Server SSL context (shared between all socket connections). */
 	SSL_CTX *ctx;
+
+	/* Rotating keys being used to encrypt session tickets. */
+	async_ssl_ticket_keys tickets;
 #endif
 } async_tcp_server;
 
@@ -99,11 +116,12 @@ typedef struct _async_tcp_socket {
 	/* Hostname or IP address that was used to establish the connection. */
 	zend_string *name;
 	
-	zend_string *local_addr;
-	uint16_t local_port;
+	/* Socket addresses (AF_UNSPEC until they are known), converted into strings on first use. */
+	php_sockaddr_storage local_peer;
+	php_sockaddr_storage remote_peer;
 	
+	zend_string *local_addr;
 	zend_string *remote_addr;
-	uint16_t remote_port;
 
 	/* Refers to the (local) server that accepted the TCP socket connection. */
 	async_tcp_server *server;
@@ -316,7 +334,6 @@ static PHP_METHOD(TcpSocket, connect)
 	zval *tls;
 
 	uv_connect_t req;
-	uv_os_fd_t sock;
 	php_sockaddr_storage dest;
 	int code;
 
@@ -388,10 +405,8 @@ static PHP_METHOD(TcpSocket, connect)
 		return;
 	}
 	
-	if (EXPECTED(0 == uv_fileno((const uv_handle_t *) &socket->handle, &sock))) {
-		async_socket_get_local_peer((php_socket_t) sock, &socket->local_addr, &socket->local_port);
-		async_socket_get_remote_peer((php_socket_t) sock, &socket->remote_addr, &socket->remote_port);
-	}
+	// The local address is looked up on demand, the remote address is the connect destination.
+	memcpy(&socket->remote_peer, &dest, async_socket_addr_size((const struct sockaddr *) &dest));
 
 	RETURN_OBJ(&socket->std);
 }
@@ -432,13 +447,14 @@ static PHP_METHOD(TcpSocket, import)
 	}
 	
 	if (EXPECTED(0 == uv_fileno((const uv_handle_t *) &socket->handle, &sock))) {
-		if (EXPECTED(SUCCESS == async_socket_get_local_peer((php_socket_t) sock, &socket->local_addr, &socket->local_port))) {
-			socket->name = zend_string_copy(socket->local_addr);
-		} else {
-			socket->name = ZSTR_EMPTY_ALLOC();
-		}
-		
-		async_socket_get_remote_peer((php_socket_t) sock, &socket->remote_addr, &socket->remote_port);
+		async_socket_get_local_addr((php_socket_t) sock, &socket->local_peer);
+		async_socket_get_remote_addr((php_socket_t) sock, &socket->remote_peer);
+	}
+	
+	if (EXPECTED(SUCCESS == async_socket_get_peer((const struct sockaddr *) &socket->local_peer, &socket->local_addr, NULL))) {
+		socket->name = zend_string_copy(socket->local_addr);
+	} else {
+		socket->name = ZSTR_EMPTY_ALLOC();
 	}
 	
 	RETURN_OBJ(&socket->std);
@@ -621,6 +637,33 @@ static PHP_METHOD(TcpSocket, flush)
 	async_stream_flush(socket->stream);
 }
 
+/* Addresses that are not known yet are looked up when they are requested for the first time. */
+static const struct sockaddr *get_local_peer(async_tcp_socket *socket)
+{
+	uv_os_fd_t sock;
+	
+	if (socket->local_peer.ss_family == AF_UNSPEC && socket->local_addr == NULL) {
+		if (EXPECTED(0 == uv_fileno((const uv_handle_t *) &socket->handle, &sock))) {
+			async_socket_get_local_addr((php_socket_t) sock, &socket->local_peer);
+		}
+	}
+	
+	return (const struct sockaddr *) &socket->local_peer;
+}
+
+static const struct sockaddr *get_remote_peer(async_tcp_socket *socket)
+{
+	uv_os_fd_t sock;
+	
+	if (socket->remote_peer.ss_family == AF_UNSPEC && socket->remote_addr == NULL) {
+		if (EXPECTED(0 == uv_fileno((const uv_handle_t *) &socket->handle, &sock))) {
+			async_socket_get_remote_addr((php_socket_t) sock, &socket->remote_peer);
+		}
+	}
+	
+	return (const struct sockaddr *) &socket->remote_peer;
+}
+
 static PHP_METHOD(TcpSocket, getAddress)
 {
 	async_tcp_socket *socket;
@@ -629,6 +672,10 @@ static PHP_METHOD(TcpSocket, getAddress)
 
 	socket = (async_tcp_socket *) Z_OBJ_P(getThis());
 	
+	if (socket->local_addr == NULL && FAILURE == async_socket_get_peer(get_local_peer(socket), &socket->local_addr, NULL)) {
+		RETURN_EMPTY_STRING();
+	}
+	
 	RETURN_STR_COPY(socket->local_addr);
 }
 
@@ -640,7 +687,7 @@ static PHP_METHOD(TcpSocket, getPort)
 
 	socket = (async_tcp_socket *) Z_OBJ_P(getThis());
 	
-	RETURN_LONG(socket->local_port);
+	RETURN_LONG(async_socket_get_addr_port(get_local_peer(socket)));
 }
 
 static PHP_METHOD(TcpSocket, getRemoteAddress)
@@ -651,6 +698,10 @@ static PHP_METHOD(TcpSocket, getRemoteAddress)
 
 	socket = (async_tcp_socket *) Z_OBJ_P(getThis());
 	
+	if (socket->remote_addr == NULL && FAILURE == async_socket_get_peer(get_remote_peer(socket), &socket->remote_addr, NULL)) {
+		RETURN_EMPTY_STRING();
+	}
+	
 	RETURN_STR_COPY(socket->remote_addr);
 }
 
@@ -662,7 +713,7 @@ static PHP_METHOD(TcpSocket, getRemotePort)
 
 	socket = (async_tcp_socket *) Z_OBJ_P(getThis());
 	
-	RETURN_LONG(socket->remote_port);
+	RETURN_LONG(async_socket_get_addr_port(get_remote_peer(socket)));
 }
 
 static PHP_METHOD(TcpSocket, setOption)
@@ -736,6 +787,15 @@ static PHP_METHOD(TcpSocket, write)
 	async_stream_call_write(socket->stream, &socket->write_error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 
+static PHP_METHOD(TcpSocket, writeAll)
+{
+	async_tcp_socket *socket;
+
+	socket = (async_tcp_socket *) Z_OBJ_P(getThis());
+
+	async_stream_call_write_all(socket->stream, &socket->write_error, INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+
 static PHP_METHOD(TcpSocket, getWriteQueueSize)
 {
 	async_tcp_socket *socket;
@@ -771,6 +831,7 @@ static PHP_METHOD(TcpSocket, encrypt)
 
 	async_tcp_socket *socket;
 	async_ssl_handshake_data handshake;
+	async_tls_info *info;
 	
 	char *cafile;
 	char *capath;
@@ -792,14 +853,20 @@ static PHP_METHOD(TcpSocket, encrypt)
 		cafile = (socket->encryption->cafile == NULL) ? NULL : ZSTR_VAL(socket->encryption->cafile);
 		capath = (socket->encryption->capath == NULL) ? NULL : ZSTR_VAL(socket->encryption->capath);
 	
-		socket->stream->ssl.ctx = async_ssl_create_context(options, cafile, capath);
-		
-		async_ssl_setup_verify_callback(socket->stream->ssl.ctx, &socket->encryption->settings);
+		socket->stream->ssl.ctx = async_ssl_get_client_context(socket->scheduler, options, cafile, capath, &socket->encryption->settings, socket->encryption->alpn);
 		
 		handshake.settings = &socket->encryption->settings;
 		handshake.host = socket->name;
 		
-		async_ssl_setup_client_alpn(socket->stream->ssl.ctx, socket->encryption->alpn, 0);
+		if (socket->encryption->settings.session_key != NULL) {
+			zend_string_release(socket->encryption->settings.session_key);
+		}
+		
+		// Sessions are shared by all connections to the same host, port and peer name that verify the peer the same way.
+		socket->encryption->settings.sessions = &socket->scheduler->sessions;
+		socket->encryption->settings.session_key = async_ssl_create_session_key(
+			socket->name, (int) async_socket_get_addr_port(get_remote_peer(socket)), options, cafile, capath, &socket->encryption->settings, socket->encryption->alpn
+		);
 	} else {
 		ASYNC_CHECK_EXCEPTION(socket->server->encryption == NULL, async_socket_exception_ce, "No encryption settings have been passed to TcpServer::listen()");
 
@@ -808,9 +875,18 @@ static PHP_METHOD(TcpSocket, encrypt)
 		handshake.settings = &socket->server->settings;
 	}
 	
-	async_ssl_create_buffered_engine(&socket->stream->ssl, socket->stream->buffer.size);
+	async_ssl_create_buffered_engine(&socket->stream->ssl, socket->stream->buffer.size, &socket->scheduler->buffers);
 	async_ssl_setup_encryption(socket->stream->ssl.ssl, handshake.settings);
 	
+	if (socket->server == NULL) {
+		// Applied per connection because client contexts are shared regardless of the protocol version.
+		if (socket->encryption->max_version != 0) {
+			SSL_set_max_proto_version(socket->stream->ssl.ssl, socket->encryption->max_version);
+		}
+	
+		async_ssl_resume_session(socket->stream->ssl.ssl, handshake.settings);
+	}
+	
 	uv_tcp_nodelay(&socket->handle, 1);
 	
 	code = async_stream_ssl_handshake(socket->stream, &handshake);
@@ -839,7 +915,34 @@ static PHP_METHOD(TcpSocket, encrypt)
 		zend_string_release(handshake.error);
 	}
 	
-	RETURN_OBJ(&async_tls_info_object_create(socket->stream->ssl.ssl)->std);
+	if (SSL_session_reused(socket->stream->ssl.ssl)) {
+		if (socket->server == NULL) {
+			socket->scheduler->tls.client_hits++;
+		} else {
+			socket->scheduler->tls.server_hits++;
+		}
+	} else {
+		if (socket->server == NULL) {
+			socket->scheduler->tls.client_misses++;
+		} else {
+			socket->scheduler->tls.server_misses++;
+		}
+	}
+	
+	info = async_tls_info_object_create(socket->stream->ssl.ssl);
+	
+	if (ASYNC_G(ktls)) {
+		if (SUCCESS == async_stream_ssl_enable_ktls(socket->stream, (socket->server == NULL) ? 1 : 0, &code)) {
+			socket->scheduler->tls.ktls++;
+		} else if (UNEXPECTED(code < 0)) {
+			ASYNC_DELREF(&info->std);
+		
+			zend_throw_exception_ex(async_socket_exception_ce, 0, "Failed to enable kernel TLS: %s", uv_strerror(code));
+			return;
+		}
+	}
+	
+	RETURN_OBJ(&info->std);
 #endif
 }
 
@@ -865,6 +968,7 @@ static const zend_function_entry async_tcp_socket_functions[] = {
 	PHP_ME(TcpSocket, read, arginfo_readable_stream_read, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpSocket, getReadableStream, arginfo_duplex_stream_get_readable_stream, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpSocket, write, arginfo_writable_stream_write, ZEND_ACC_PUBLIC)
+	PHP_ME(TcpSocket, writeAll, arginfo_writable_stream_write_all, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpSocket, getWriteQueueSize, arginfo_socket_get_write_queue_size, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpSocket, getWritableStream, arginfo_duplex_stream_get_writable_stream, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpSocket, export, arginfo_tcp_socket_export, ZEND_ACC_PUBLIC)
@@ -1005,34 +1109,57 @@ ASYNC_CALLBACK server_connected(uv_stream_t *stream, int status)
 	}
 }
 
-static int setup_server_tls(async_tcp_server *server, zval *tls)
-{
 #ifdef HAVE_ASYNC_SSL
+static SSL_CTX *create_server_context(async_tcp_server *server, async_tls_server_encryption *encryption)
+{
+	SSL_CTX *ctx;
+	
 	int options;
 	char *cafile;
 	char *capath;
+	
+	options = SSL_OP_SINGLE_DH_USE | SSL_OP_CIPHER_SERVER_PREFERENCE;
+	
+	cafile = (encryption->cafile == NULL) ? NULL : ZSTR_VAL(encryption->cafile);
+	capath = (encryption->capath == NULL) ? NULL : ZSTR_VAL(encryption->capath);
+	
+	ctx = async_ssl_create_context(options, cafile, capath);
+
+	SSL_CTX_set_default_passwd_cb_userdata(ctx, &encryption->cert);
+
+	SSL_CTX_use_certificate_chain_file(ctx, ZSTR_VAL(encryption->cert.file));
+	SSL_CTX_use_PrivateKey_file(ctx, ZSTR_VAL(encryption->cert.key), SSL_FILETYPE_PEM);
+
+	if (UNEXPECTED(SUCCESS != async_ssl_setup_server_sni(ctx, encryption))) {
+		SSL_CTX_free(ctx);
+		
+		return NULL;
+	}
+	
+	async_ssl_setup_server_alpn(ctx, encryption);
+	async_ssl_setup_server_sessions(ctx, encryption, &server->tickets);
+	
+	if (encryption->max_version != 0) {
+		SSL_CTX_set_max_proto_version(ctx, encryption->max_version);
+	}
+	
+	return ctx;
+}
 #endif
 
+static int setup_server_tls(async_tcp_server *server, zval *tls)
+{
 	if (tls != NULL && Z_TYPE_P(tls) != IS_NULL) {
 #ifdef HAVE_ASYNC_SSL
+		if (UNEXPECTED(NULL == (server->ctx = create_server_context(server, (async_tls_server_encryption *) Z_OBJ_P(tls))))) {
+			return FAILURE;
+		}
+		
 		server->encryption = (async_tls_server_encryption *) Z_OBJ_P(tls);
 
 		ASYNC_ADDREF(&server->encryption->std);
 		
-		options = SSL_OP_SINGLE_DH_USE | SSL_OP_CIPHER_SERVER_PREFERENCE;
-		
-		cafile = (server->encryption->cafile == NULL) ? NULL : ZSTR_VAL(server->encryption->cafile);
-		capath = (server->encryption->capath == NULL) ? NULL : ZSTR_VAL(server->encryption->capath);
-		
-		server->ctx = async_ssl_create_context(options, cafile, capath);
-
-		SSL_CTX_set_default_passwd_cb_userdata(server->ctx, &server->encryption->cert);
-
-		SSL_CTX_use_certificate_chain_file(server->ctx, ZSTR_VAL(server->encryption->cert.file));
-		SSL_CTX_use_PrivateKey_file(server->ctx, ZSTR_VAL(server->encryption->cert.key), SSL_FILETYPE_PEM);
-
-		async_ssl_setup_server_sni(server->ctx, server->encryption);
-		async_ssl_setup_server_alpn(server->ctx, server->encryption);
+		server->settings.tickets = &server->tickets;
 #else
 		zend_throw_exception_ex(async_socket_exception_ce, 0, "Server encryption requires async extension to be compiled with SSL support");
 		
@@ -1053,6 +1180,8 @@ static void create_server(async_tcp_server **result, INTERNAL_FUNCTION_PARAMETER
 
 	zval *tls;
 	zend_bool reuseport;
+	zend_long backlog;
+	zend_bool nobacklog;
 
 	php_sockaddr_storage addr;
 	php_socket_t sock;
@@ -1064,14 +1193,23 @@ static void create_server(async_tcp_server **result, INTERNAL_FUNCTION_PARAMETER
 	port = 0;
 	tls = NULL;
 	reuseport = 0;
+	backlog = ASYNC_TCP_SERVER_BACKLOG;
+	nobacklog = 1;
 
-	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 4)
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 5)
 		Z_PARAM_OPTIONAL
 		Z_PARAM_ZVAL(name)
 		Z_PARAM_LONG(port)
 		Z_PARAM_OBJECT_OF_CLASS_EX(tls, async_tls_server_encryption_ce, 1, 0)
 		Z_PARAM_BOOL(reuseport)
+		Z_PARAM_LONG_EX(backlog, nobacklog, 1, 0)
 	ZEND_PARSE_PARAMETERS_END();
+	
+	if (nobacklog) {
+		backlog = ASYNC_TCP_SERVER_BACKLOG;
+	}
+	
+	ASYNC_CHECK_ERROR(ASYNC_TCP_SERVER_BACKLOG_INVALID(backlog), "Backlog must be between 1 and %d", INT_MAX);
 
 	if (name == NULL || Z_TYPE_P(name) == IS_NULL) {
 		host = str_wildcard;
@@ -1095,11 +1233,14 @@ static void create_server(async_tcp_server **result, INTERNAL_FUNCTION_PARAMETER
 	
 	server->name = zend_string_copy(host);
 	server->port = (uint16_t) port;
+	server->backlog = (int) backlog;
 	
 	async_socket_set_reuseaddr(sock, 1);
 	
-	if (reuseport) {
-		async_socket_set_reuseport(sock, 1);
+	if (reuseport && UNEXPECTED(0 != (code = async_socket_set_reuseport(sock, 1)))) {
+		zend_throw_exception_ex(async_socket_bind_exception_ce, 0, "Failed to enable port reuse: %s", uv_strerror(code));
+		ASYNC_DELREF(&server->std);
+		return;
 	}
 	
 #ifdef HAVE_IPV6
@@ -1133,6 +1274,7 @@ ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tcp_server_bind, 0, 0, Concurrent
 	ZEND_ARG_TYPE_INFO(0, port, IS_LONG, 1)
 	ZEND_ARG_OBJ_INFO(0, tls, Concurrent\\Network\\TlsServerEncryption, 1)
 	ZEND_ARG_TYPE_INFO(0, reuseport, _IS_BOOL, 1)
+	ZEND_ARG_TYPE_INFO(0, backlog, IS_LONG, 1)
 ZEND_END_ARG_INFO();
 
 static PHP_METHOD(TcpServer, bind)
@@ -1153,6 +1295,7 @@ ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tcp_server_listen, 0, 0, Concurre
 	ZEND_ARG_TYPE_INFO(0, port, IS_LONG, 1)
 	ZEND_ARG_OBJ_INFO(0, tls, Concurrent\\Network\\TlsServerEncryption, 1)
 	ZEND_ARG_TYPE_INFO(0, reuseport, _IS_BOOL, 1)
+	ZEND_ARG_TYPE_INFO(0, backlog, IS_LONG, 1)
 ZEND_END_ARG_INFO();
 
 static PHP_METHOD(TcpServer, listen)
@@ -1164,7 +1307,7 @@ static PHP_METHOD(TcpServer, listen)
 	create_server(&server, INTERNAL_FUNCTION_PARAM_PASSTHRU);
 	
 	if (EXPECTED(server)) {
-		code = uv_listen((uv_stream_t *) &server->handle, 128, server_connected);
+		code = uv_listen((uv_stream_t *) &server->handle, server->backlog, server_connected);
 
 		if (UNEXPECTED(code != 0)) {
 			zend_throw_exception_ex(async_socket_listen_exception_ce, 0, "Server failed to listen: %s", uv_strerror(code));
@@ -1179,6 +1322,7 @@ static PHP_METHOD(TcpServer, listen)
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_tcp_server_import, 0, 1, Concurrent\\Network\\TcpServer, 0)
 	ZEND_ARG_OBJ_INFO(0, pipe, Concurrent\\Network\\Pipe, 0)
 	ZEND_ARG_OBJ_INFO(0, tls, Concurrent\\Network\\TlsServerEncryption, 1)
+	ZEND_ARG_TYPE_INFO(0, backlog, IS_LONG, 1)
 ZEND_END_ARG_INFO();
 
 static PHP_METHOD(TcpServer, import)
@@ -1188,17 +1332,29 @@ static PHP_METHOD(TcpServer, import)
 	
 	zval *conn;
 	zval *tls;
+	zend_long backlog;
+	zend_bool nobacklog;
 	
 	tls = NULL;
+	backlog = ASYNC_TCP_SERVER_BACKLOG;
+	nobacklog = 1;
 	
-	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 2)
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 3)
 		Z_PARAM_OBJECT_OF_CLASS(conn, async_pipe_ce)
 		Z_PARAM_OPTIONAL
 		Z_PARAM_OBJECT_OF_CLASS_EX(tls, async_tls_server_encryption_ce, 1, 0)
+		Z_PARAM_LONG_EX(backlog, nobacklog, 1, 0)
 	ZEND_PARSE_PARAMETERS_END();
 	
+	if (nobacklog) {
+		backlog = ASYNC_TCP_SERVER_BACKLOG;
+	}
+	
+	ASYNC_CHECK_ERROR(ASYNC_TCP_SERVER_BACKLOG_INVALID(backlog), "Backlog must be between 1 and %d", INT_MAX);
+	
 	server = async_tcp_server_object_create(AF_UNSPEC);
 	server->flags = ASYNC_TCP_SERVER_FLAG_LAZY;
+	server->backlog = (int) backlog;
 	
 	async_pipe_import_stream((async_pipe *) Z_OBJ_P(conn), (uv_stream_t *) &server->handle);
 	
@@ -1217,6 +1373,11 @@ static PHP_METHOD(TcpServer, import)
 
 	uv_unref((uv_handle_t *) &server->handle);
 	
+	if (UNEXPECTED(SUCCESS != setup_server_tls(server, tls))) {
+		ASYNC_DELREF(&server->std);
+		return;
+	}
+	
 	RETURN_OBJ(&server->std);
 }
 
@@ -1321,83 +1482,264 @@ static PHP_METHOD(TcpServer, setOption)
 	RETURN_BOOL((code < 0) ? 0 : 1);
 }
 
-static PHP_METHOD(TcpServer, accept)
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_tcp_server_set_encryption, 0, 1, IS_VOID, 0)
+	ZEND_ARG_OBJ_INFO(0, tls, Concurrent\\Network\\TlsServerEncryption, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(TcpServer, setEncryption)
 {
 	async_tcp_server *server;
-	async_tcp_socket *socket;
-	async_context *context;
 	
-	async_uv_op *op;
-	uv_os_fd_t sock;
-
-	int code;
+	zval *tls;
+	
+#ifdef HAVE_ASYNC_SSL
+	SSL_CTX *ctx;
+#endif
 
-	ZEND_PARSE_PARAMETERS_NONE();
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_OBJECT_OF_CLASS(tls, async_tls_server_encryption_ce)
+	ZEND_PARSE_PARAMETERS_END();
 
 	server = (async_tcp_server *) Z_OBJ_P(getThis());
 	
-	if (server->flags & ASYNC_TCP_SERVER_FLAG_LAZY) {
-		code = uv_listen((uv_stream_t *) &server->handle, 128, server_connected);
+#ifdef HAVE_ASYNC_SSL
+	ASYNC_CHECK_EXCEPTION(server->encryption == NULL, async_socket_exception_ce, "No encryption settings have been passed to TcpServer::listen()");
 	
-		ASYNC_CHECK_EXCEPTION(code != 0, async_socket_listen_exception_ce, "Server failed to listen: %s", uv_strerror(code));
-		
-		server->flags ^= ASYNC_TCP_SERVER_FLAG_LAZY;
+	if (UNEXPECTED(NULL == (ctx = create_server_context(server, (async_tls_server_encryption *) Z_OBJ_P(tls))))) {
+		return;
 	}
+	
+	// Connections hold a reference to the context they have been created with, only new connections use the replacement.
+	SSL_CTX_free(server->ctx);
+	ASYNC_DELREF(&server->encryption->std);
+	
+	server->ctx = ctx;
+	server->encryption = (async_tls_server_encryption *) Z_OBJ_P(tls);
+	
+	ASYNC_ADDREF(&server->encryption->std);
+#else
+	zend_throw_exception_ex(async_socket_exception_ce, 0, "Server encryption requires async extension to be compiled with SSL support");
+#endif
+}
 
-	if (server->pending == 0) {
-		if (UNEXPECTED(Z_TYPE_P(&server->error) != IS_UNDEF)) {
-			ASYNC_FORWARD_ERROR(&server->error);
-			return;
-		}
-		
-		ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_uv_op));
-		ASYNC_APPEND_OP(&server->accepts, op);
-		
-		context = async_context_get();
-		
-		ASYNC_UNREF_ENTER(context, server);
-		code = async_await_op((async_op *) op);
-		ASYNC_UNREF_EXIT(context, server);
+static int await_connection(async_tcp_server *server, zend_execute_data *execute_data)
+{
+	async_context *context;
+	async_uv_op *op;
+
+	int code;
+	
+	if (server->flags & ASYNC_TCP_SERVER_FLAG_LAZY) {
+		code = uv_listen((uv_stream_t *) &server->handle, server->backlog, server_connected);
 		
-		if (UNEXPECTED(code == FAILURE)) {
-			ASYNC_FORWARD_OP_ERROR(op);
-			ASYNC_FREE_OP(op);
-			
-			return;
+		if (UNEXPECTED(code != 0)) {
+			zend_throw_exception_ex(async_socket_listen_exception_ce, 0, "Server failed to listen: %s", uv_strerror(code));
+			return FAILURE;
 		}
 		
-		code = op->code;
+		server->flags ^= ASYNC_TCP_SERVER_FLAG_LAZY;
+	}
+
+	if (server->pending > 0) {
+		server->pending--;
 		
+		return SUCCESS;
+	}
+	
+	if (UNEXPECTED(Z_TYPE_P(&server->error) != IS_UNDEF)) {
+		ASYNC_FORWARD_ERROR(&server->error);
+		return FAILURE;
+	}
+	
+	ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_uv_op));
+	ASYNC_APPEND_OP(&server->accepts, op);
+	
+	context = async_context_get();
+	
+	ASYNC_UNREF_ENTER(context, server);
+	code = async_await_op((async_op *) op);
+	ASYNC_UNREF_EXIT(context, server);
+	
+	if (UNEXPECTED(code == FAILURE)) {
+		ASYNC_FORWARD_OP_ERROR(op);
 		ASYNC_FREE_OP(op);
 		
-		ASYNC_CHECK_EXCEPTION(code < 0, async_socket_accept_exception_ce, "Failed to accept socket connection: %s", uv_strerror(code));
-	} else {
-		server->pending--;
+		return FAILURE;
 	}
+	
+	code = op->code;
+	
+	ASYNC_FREE_OP(op);
+	
+	if (UNEXPECTED(code < 0)) {
+		zend_throw_exception_ex(async_socket_accept_exception_ce, 0, "Failed to accept socket connection: %s", uv_strerror(code));
+		return FAILURE;
+	}
+	
+	return SUCCESS;
+}
 
+/* Takes the connection that has been reported by libuv, addresses are looked up on demand. */
+static int accept_connection(async_tcp_server *server, async_tcp_socket **result)
+{
+	async_tcp_socket *socket;
+	
+	int code;
+	
 	socket = async_tcp_socket_object_create();
 
 	code = uv_accept((uv_stream_t *) &server->handle, (uv_stream_t *) &socket->handle);
 
 	if (UNEXPECTED(code != 0)) {
-		zend_throw_exception_ex(async_socket_accept_exception_ce, 0, "Failed to accept socket connection: %s", uv_strerror(code));
 		ASYNC_DELREF(&socket->std);
 		
-		return;
+		return code;
 	}
 
 	socket->server = server;
 	
-	if (EXPECTED(0 == uv_fileno((const uv_handle_t *) &socket->handle, &sock))) {
-		async_socket_get_local_peer((php_socket_t) sock, &socket->local_addr, &socket->local_port);
-		async_socket_get_remote_peer((php_socket_t) sock, &socket->remote_addr, &socket->remote_port);
-	}
+	ASYNC_ADDREF(&server->std);
+	
+	*result = socket;
+	
+	return 0;
+}
 
+#ifndef PHP_WIN32
+/* Accepts a connection from the backlog without waiting for libuv to report it, returns NULL if there is none. */
+static async_tcp_socket *accept_queued_connection(async_tcp_server *server)
+{
+	async_tcp_socket *socket;
+	
+	uv_os_fd_t fd;
+	php_socket_t sock;
+	php_sockaddr_storage addr;
+	socklen_t len;
+	
+	if (UNEXPECTED(0 != uv_fileno((const uv_handle_t *) &server->handle, &fd))) {
+		return NULL;
+	}
+	
+	do {
+		len = sizeof(addr);
+		
+#if defined(__linux__) && defined(SOCK_CLOEXEC)
+		sock = accept4(fd, (struct sockaddr *) &addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		sock = accept(fd, (struct sockaddr *) &addr, &len);
+#endif
+	} while (sock == -1 && errno == EINTR);
+	
+	if (sock == -1) {
+		return NULL;
+	}
+	
+#if !defined(__linux__) || !defined(SOCK_CLOEXEC)
+	fcntl(sock, F_SETFD, FD_CLOEXEC);
+#endif
+	
+	socket = async_tcp_socket_object_create();
+	
+	if (UNEXPECTED(0 != uv_tcp_open(&socket->handle, (uv_os_sock_t) sock))) {
+		closesocket(sock);
+		ASYNC_DELREF(&socket->std);
+		
+		return NULL;
+	}
+	
+	memcpy(&socket->remote_peer, &addr, MIN(len, sizeof(addr)));
+	
+	socket->server = server;
+	
 	ASYNC_ADDREF(&server->std);
+	
+	return socket;
+}
+#endif
+
+static PHP_METHOD(TcpServer, accept)
+{
+	async_tcp_server *server;
+	async_tcp_socket *socket;
+
+	int code;
+
+	ZEND_PARSE_PARAMETERS_NONE();
+
+	server = (async_tcp_server *) Z_OBJ_P(getThis());
+	
+	if (UNEXPECTED(FAILURE == await_connection(server, execute_data))) {
+		return;
+	}
+	
+	code = accept_connection(server, &socket);
+	
+	ASYNC_CHECK_EXCEPTION(code != 0, async_socket_accept_exception_ce, "Failed to accept socket connection: %s", uv_strerror(code));
 
 	RETURN_OBJ(&socket->std);
 }
 
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_tcp_server_accept_batch, 0, 0, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, max, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(TcpServer, acceptBatch)
+{
+	async_tcp_server *server;
+	async_tcp_socket *socket;
+	
+	zend_long max;
+	zval obj;
+
+	int code;
+	
+	max = ASYNC_TCP_SERVER_BATCH;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 1)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_LONG(max)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(max < 1, "Batch size must be at least 1");
+
+	server = (async_tcp_server *) Z_OBJ_P(getThis());
+	
+	if (UNEXPECTED(FAILURE == await_connection(server, execute_data))) {
+		return;
+	}
+	
+	code = accept_connection(server, &socket);
+	
+	ASYNC_CHECK_EXCEPTION(code != 0, async_socket_accept_exception_ce, "Failed to accept socket connection: %s", uv_strerror(code));
+	
+	array_init_size(return_value, (uint32_t) MIN(max, ASYNC_TCP_SERVER_BATCH));
+	
+	ZVAL_OBJ(&obj, &socket->std);
+	zend_hash_next_index_insert(Z_ARRVAL_P(return_value), &obj);
+	
+	// Connections that are already queued are returned without suspending the calling task again.
+	while (zend_hash_num_elements(Z_ARRVAL_P(return_value)) < max) {
+		if (server->pending > 0) {
+			server->pending--;
+			
+			if (UNEXPECTED(0 != accept_connection(server, &socket))) {
+				break;
+			}
+		} else {
+#ifdef PHP_WIN32
+			break;
+#else
+			if (NULL == (socket = accept_queued_connection(server))) {
+				break;
+			}
+#endif
+		}
+		
+		ZVAL_OBJ(&obj, &socket->std);
+		zend_hash_next_index_insert(Z_ARRVAL_P(return_value), &obj);
+	}
+}
+
 //LCOV_EXCL_START
 ASYNC_METHOD_NO_CTOR(TcpServer, async_tcp_server_ce)
 ASYNC_METHOD_NO_WAKEUP(TcpServer, async_tcp_server_ce)
@@ -1413,7 +1755,9 @@ static const zend_function_entry async_tcp_server_functions[] = {
 	PHP_ME(TcpServer, getAddress, arginfo_socket_get_address, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpServer, getPort, arginfo_socket_get_port, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpServer, setOption, arginfo_socket_set_option, ZEND_ACC_PUBLIC)
+	PHP_ME(TcpServer, setEncryption, arginfo_tcp_server_set_encryption, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpServer, accept, arginfo_server_accept, ZEND_ACC_PUBLIC)
+	PHP_ME(TcpServer, acceptBatch, arginfo_tcp_server_accept_batch, ZEND_ACC_PUBLIC)
 	PHP_ME(TcpServer, export, arginfo_tcp_server_export, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
@@ -23,9 +23,17 @@
 #include "SAPI.h"
 #include "php_main.h"
 
+#include "zend_smart_str.h"
+#include "ext/standard/php_var.h"
+
+ASYNC_API zend_class_entry *async_job_failed_ce;
 ASYNC_API zend_class_entry *async_thread_ce;
+ASYNC_API zend_class_entry *async_thread_channel_ce;
+ASYNC_API zend_class_entry *async_thread_pool_ce;
 
 static zend_object_handlers async_thread_handlers;
+static zend_object_handlers async_thread_channel_handlers;
+static zend_object_handlers async_thread_pool_handlers;
 
 #ifdef ZTS
 
@@ -36,6 +44,10 @@ typedef int (*php_sapi_deactivate_t)(void);
 
 static php_sapi_deactivate_t sapi_deactivate_func;
 
+/* Process-wide registry of named thread channels, guarded by the registry mutex. */
+static HashTable thread_channels;
+static uv_mutex_t thread_channels_mutex;
+
 #endif
 
 #define ASYNC_THREAD_FLAG_RUNNING 1
@@ -75,22 +87,167 @@ typedef struct _async_thread {
 	async_op_list join;
 } async_thread;
 
+#define ASYNC_THREAD_POOL_FLAG_CLOSED 1
+
+#define ASYNC_THREAD_WORKER_FLAG_READY 1
+#define ASYNC_THREAD_WORKER_FLAG_IDLE (1 << 1)
+#define ASYNC_THREAD_WORKER_FLAG_CLOSED (1 << 2)
+#define ASYNC_THREAD_WORKER_FLAG_TERMINATED (1 << 3)
+
+typedef struct _async_thread_job async_thread_job;
+typedef struct _async_thread_pool async_thread_pool;
+
+struct _async_thread_job {
+	async_thread_job *prev;
+	async_thread_job *next;
+	
+	/* Operation of the submitting task, only accessed by the master thread. */
+	async_op *op;
+	
+	/* Name of the function (or static method) to be called by the worker. */
+	zend_string *name;
+	
+	/* Serialized arguments, replaced with the serialized result or an error message by the worker. */
+	zend_string *data;
+	
+	zend_bool failed;
+};
+
+typedef struct _async_thread_job_queue {
+	async_thread_job *first;
+	async_thread_job *last;
+} async_thread_job_queue;
+
+typedef struct _async_thread_job_op {
+	async_op base;
+	async_thread_job *job;
+} async_thread_job_op;
+
+typedef struct _async_thread_worker {
+	async_thread_pool *pool;
+	
+	/* Guarded by the worker mutex. */
+	uint16_t flags;
+	
+	uv_thread_t impl;
+	uv_async_t handle;
+	uv_mutex_t mutex;
+	
+	/* Jobs assigned to the worker, other workers steal from the end of the queue. */
+	async_thread_job_queue queue;
+	
+	/* Job being executed, only accessed by the worker thread. */
+	async_thread_job *current;
+	async_op wait;
+} async_thread_worker;
+
+struct _async_thread_pool {
+	zend_object std;
+	
+	uint16_t flags;
+	
+	async_task_scheduler *scheduler;
+	async_cancel_cb shutdown;
+	
+	uv_async_t handle;
+	uv_mutex_t mutex;
+	
+	zend_string *bootstrap;
+	
+	async_thread_worker *workers;
+	uint32_t size;
+	uint32_t started;
+	uint32_t next;
+	
+	/* Number of submitted jobs that have not been delivered to the master yet. */
+	uint32_t pending;
+	
+	/* Guarded by the pool mutex. */
+	uint32_t terminated;
+	async_thread_job_queue results;
+};
+
+#define ASYNC_THREAD_CHANNEL_MAX_CAPACITY 0x10000
+
+#define ASYNC_THREAD_CHANNEL_FLAG_CLOSED 1
+
+#define ASYNC_THREAD_CHANNEL_WAITING_RECEIVE 1
+#define ASYNC_THREAD_CHANNEL_WAITING_SEND (1 << 1)
+
+typedef struct _async_thread_channel async_thread_channel;
+typedef struct _async_thread_channel_waiter async_thread_channel_waiter;
+
+struct _async_thread_channel_waiter {
+	async_thread_channel_waiter *prev;
+	async_thread_channel_waiter *next;
+	async_thread_channel *channel;
+};
+
+typedef struct _async_thread_channel_waiter_list {
+	async_thread_channel_waiter *first;
+	async_thread_channel_waiter *last;
+} async_thread_channel_waiter_list;
+
+typedef struct _async_thread_channel_state {
+	/* Number of channel objects (in all threads), guarded by the registry mutex. */
+	uint32_t refcount;
+	
+	/* Name of the channel within the registry. */
+	zend_string *name;
+	
+	uv_mutex_t mutex;
+	
+	/* Guarded by the channel mutex. */
+	uint8_t flags;
+	
+	/* Ring buffer of serialized messages, guarded by the channel mutex. */
+	uint32_t size;
+	uint32_t len;
+	uint32_t rpos;
+	zend_string **data;
+	
+	/* Channel objects that have tasks waiting for a message / free space, guarded by the channel mutex. */
+	async_thread_channel_waiter_list receivers;
+	async_thread_channel_waiter_list senders;
+} async_thread_channel_state;
+
+struct _async_thread_channel {
+	zend_object std;
+	
+	async_task_scheduler *scheduler;
+	async_cancel_cb shutdown;
+	
+	async_thread_channel_state *state;
+	
+	/* Handle being used by other threads to wake up waiting tasks. */
+	uv_async_t handle;
+	
+	/* Registration with the wait lists of the channel state, guarded by the channel mutex. */
+	uint8_t waiting;
+	async_thread_channel_waiter receiver;
+	async_thread_channel_waiter sender;
+	
+	/* Tasks of the owning thread that are waiting for the channel. */
+	async_op_list receivers;
+	async_op_list senders;
+};
+
 
 #ifdef ZTS
 
-static void run_bootstrap(async_thread *thread)
+static void run_bootstrap(zend_string *file)
 {
 	zend_file_handle handle;
 	zend_op_array *ops;
 	
 	zval retval;
 	
-	if (SUCCESS != php_stream_open_for_zend_ex(ZSTR_VAL(thread->bootstrap), &handle, USE_PATH | REPORT_ERRORS | STREAM_OPEN_FOR_INCLUDE)) {
+	if (SUCCESS != php_stream_open_for_zend_ex(ZSTR_VAL(file), &handle, USE_PATH | REPORT_ERRORS | STREAM_OPEN_FOR_INCLUDE)) {
 		return;
 	}
 	
 	if (!handle.opened_path) {
-		handle.opened_path = zend_string_dup(thread->bootstrap, 0);
+		handle.opened_path = zend_string_dup(file, 0);
 	}
 	
 	zend_hash_add_empty_element(&EG(included_files), handle.opened_path);
@@ -116,6 +273,28 @@ static void run_bootstrap(async_thread *thread)
 	}
 }
 
+static void startup_request()
+{
+	PG(expose_php) = 0;
+	PG(auto_globals_jit) = 1;
+	
+	php_request_startup();
+	
+	zend_disable_function(ZEND_STRL("setlocale"));
+	zend_disable_function(ZEND_STRL("dl"));
+	
+#if PHP_VERSION_ID < 70400
+	zend_disable_function(ZEND_STRL("putenv"));
+#endif
+	
+	PG(during_request_startup) = 0;
+	SG(sapi_started) = 0;
+	SG(headers_sent) = 1;
+	SG(request_info).no_headers = 1;
+	
+	ASYNC_G(cli) = 1;
+}
+
 #ifdef PHP_WIN32
 
 ASYNC_CALLBACK ipc_connect_cb(uv_connect_t *req, int status)
@@ -181,24 +360,8 @@ ASYNC_CALLBACK run_thread(void *arg)
 	thread->interrupt = &EG(vm_interrupt);	
 	uv_mutex_unlock(&thread->mutex);
 	
-	PG(expose_php) = 0;
-	PG(auto_globals_jit) = 1;
-	
-	php_request_startup();
-	
-	zend_disable_function(ZEND_STRL("setlocale"));
-	zend_disable_function(ZEND_STRL("dl"));
-	
-#if PHP_VERSION_ID < 70400
-	zend_disable_function(ZEND_STRL("putenv"));
-#endif
-	
-	PG(during_request_startup) = 0;
-	SG(sapi_started) = 0;
-	SG(headers_sent) = 1;
-	SG(request_info).no_headers = 1;
+	startup_request();
 	
-	ASYNC_G(cli) = 1;
 	ASYNC_G(thread) = &thread->std;
 	
 #ifdef PHP_WIN32
@@ -222,7 +385,7 @@ ASYNC_CALLBACK run_thread(void *arg)
 	scheduler = async_task_scheduler_get();
 
 	zend_first_try {
-		run_bootstrap(thread);
+		run_bootstrap(thread->bootstrap);
 	} zend_catch {
 		async_task_scheduler_handle_exit(scheduler);
 	} zend_end_try();
@@ -709,62 +872,1516 @@ static const zend_function_entry thread_functions[] = {
 
 #ifdef ZTS
 
-static void interrupt_thread(zend_execute_data *exec)
+static zend_string *serialize_job_data(zval *value)
 {
-	async_thread *thread;
+	php_serialize_data_t vars;
+	smart_str buf = {0};
 	
-	if (ASYNC_G(thread)) {
-		thread = (async_thread *) ASYNC_G(thread);
-
-		if (thread->flags & ASYNC_THREAD_FLAG_KILLED) {
-			zend_bailout();
-		}
+	zend_string *data;
+	
+	PHP_VAR_SERIALIZE_INIT(vars);
+	php_var_serialize(&buf, value, &vars);
+	PHP_VAR_SERIALIZE_DESTROY(vars);
+	
+	if (UNEXPECTED(EG(exception))) {
+		smart_str_free(&buf);
+		
+		return NULL;
 	}
 	
-	if (prev_interrupt_handler) {
-		prev_interrupt_handler(exec);
+	smart_str_0(&buf);
+	
+	// Data is handed over to another thread, it must not be allocated in the request heap.
+	data = zend_string_init(ZSTR_VAL(buf.s), ZSTR_LEN(buf.s), 1);
+	
+	smart_str_free(&buf);
+	
+	return data;
+}
+
+static int unserialize_job_data(zval *value, zend_string *data)
+{
+	php_unserialize_data_t vars;
+	const unsigned char *pos;
+	
+	zval *tmp;
+	int code;
+	
+	pos = (const unsigned char *) ZSTR_VAL(data);
+	
+	PHP_VAR_UNSERIALIZE_INIT(vars);
+	
+	tmp = var_tmp_var(&vars);
+	code = php_var_unserialize(tmp, &pos, pos + ZSTR_LEN(data), &vars);
+	
+	if (EXPECTED(code)) {
+		ZVAL_COPY(value, tmp);
 	}
+	
+	PHP_VAR_UNSERIALIZE_DESTROY(vars);
+	
+	return code ? SUCCESS : FAILURE;
 }
 
-#endif
+static zend_always_inline void free_job(async_thread_job *job)
+{
+	zend_string_release(job->name);
+	
+	if (job->data != NULL) {
+		zend_string_release(job->data);
+	}
+	
+	pefree(job, 1);
+}
 
-void async_thread_ce_register()
+static void fail_job(async_thread_job *job, zend_string *message)
 {
-	zend_class_entry ce;
+	if (job->data != NULL) {
+		zend_string_release(job->data);
+	}
+	
+	job->data = zend_string_init(ZSTR_VAL(message), ZSTR_LEN(message), 1);
+	job->failed = 1;
+	
+	zend_string_release(message);
+}
 
-	INIT_NS_CLASS_ENTRY(ce, "Concurrent", "Thread", thread_functions);
-	async_thread_ce = zend_register_internal_class(&ce);
-	async_thread_ce->ce_flags |= ZEND_ACC_FINAL;
-	async_thread_ce->create_object = async_thread_object_create;
-	async_thread_ce->serialize = zend_class_serialize_deny;
-	async_thread_ce->unserialize = zend_class_unserialize_deny;
+static void execute_job(async_thread_job *job)
+{
+	zend_execute_data dummy;
+	zend_execute_data *prev;
+	zend_class_entry *base;
+	zend_object *error;
+	zend_string *message;
+	zend_string *data;
+	
+	zend_fcall_info fci;
+	zend_fcall_info_cache fcc;
+	
+	zval callable;
+	zval args;
+	zval retval;
+	zval obj;
+	zval tmp;
+	
+	char *info;
+	
+	ZVAL_STRINGL(&callable, ZSTR_VAL(job->name), ZSTR_LEN(job->name));
+	
+	info = NULL;
+	
+	if (UNEXPECTED(FAILURE == zend_fcall_info_init(&callable, 0, &fci, &fcc, NULL, &info))) {
+		fail_job(job, zend_strpprintf(0, "Job %s is not callable: %s", ZSTR_VAL(job->name), (info == NULL) ? "unknown error" : info));
+		
+		if (info != NULL) {
+			efree(info);
+		}
+		
+		zval_ptr_dtor(&callable);
+		
+		return;
+	}
+	
+	if (info != NULL) {
+		efree(info);
+	}
+	
+	if (UNEXPECTED(FAILURE == unserialize_job_data(&args, job->data))) {
+		fail_job(job, zend_strpprintf(0, "Failed to unserialize arguments of job %s", ZSTR_VAL(job->name)));
+		zval_ptr_dtor(&callable);
+		
+		return;
+	}
+	
+	// Jobs are called from the root of the worker, a dummy frame keeps uncaught errors from becoming fatal.
+	memset(&dummy, 0, sizeof(zend_execute_data));
+	
+	prev = EG(current_execute_data);
+	EG(current_execute_data) = &dummy;
+	
+	ZVAL_UNDEF(&retval);
+	
+	zend_fcall_info_args(&fci, &args);
+	
+	fci.retval = &retval;
+	fci.no_separation = 1;
+	
+	zend_call_function(&fci, &fcc);
+	zend_fcall_info_args_clear(&fci, 1);
+	
+	zval_ptr_dtor(&args);
+	
+	data = NULL;
+	
+	if (EXPECTED(EG(exception) == NULL)) {
+		data = serialize_job_data(&retval);
+	}
+	
+	zval_ptr_dtor(&retval);
+	
+	if (UNEXPECTED(EG(exception))) {
+		if (data != NULL) {
+			zend_string_release(data);
+		}
+		
+		error = EG(exception);
+		base = instanceof_function(error->ce, zend_ce_exception) ? zend_ce_exception : zend_ce_error;
+		
+		ZVAL_OBJ(&obj, error);
+		message = zval_get_string(zend_read_property_ex(base, &obj, ZSTR_KNOWN(ZEND_STR_MESSAGE), 1, &tmp));
+		
+		fail_job(job, zend_strpprintf(0, "Job %s failed with %s: %s", ZSTR_VAL(job->name), ZSTR_VAL(error->ce->name), ZSTR_VAL(message)));
+		
+		zend_string_release(message);
+		zend_clear_exception();
+	} else {
+		zend_string_release(job->data);
+		job->data = data;
+	}
+	
+	EG(current_execute_data) = prev;
+	
+	zval_ptr_dtor(&callable);
+}
 
-	memcpy(&async_thread_handlers, &std_object_handlers, sizeof(zend_object_handlers));
-	async_thread_handlers.free_obj = async_thread_object_destroy;
-	async_thread_handlers.dtor_obj = async_thread_object_dtor;
-	async_thread_handlers.clone_obj = NULL;
+static async_thread_job *next_job(async_thread_worker *worker, zend_bool *closed)
+{
+	async_thread_pool *pool;
+	async_thread_worker *victim;
+	async_thread_job *job;
+	
+	uint32_t i;
+	
+	pool = worker->pool;
+	
+	uv_mutex_lock(&worker->mutex);
+	
+	ASYNC_LIST_EXTRACT_FIRST(&worker->queue, job);
+	
+	*closed = (worker->flags & ASYNC_THREAD_WORKER_FLAG_CLOSED) ? 1 : 0;
+	
+	// Worker must be flagged as idle before looking at other queues, submitting a job will wake it up.
+	if (job == NULL && !*closed) {
+		worker->flags |= ASYNC_THREAD_WORKER_FLAG_IDLE;
+	} else {
+		worker->flags &= ~ASYNC_THREAD_WORKER_FLAG_IDLE;
+	}
+	
+	uv_mutex_unlock(&worker->mutex);
+	
+	if (job != NULL || *closed) {
+		return job;
+	}
+	
+	// Steal the most recently queued job of another worker.
+	for (i = 1; i < pool->size; i++) {
+		victim = &pool->workers[((uint32_t) (worker - pool->workers) + i) % pool->size];
+		
+		uv_mutex_lock(&victim->mutex);
+		ASYNC_LIST_EXTRACT_LAST(&victim->queue, job);
+		uv_mutex_unlock(&victim->mutex);
+		
+		if (job != NULL) {
+			uv_mutex_lock(&worker->mutex);
+			worker->flags &= ~ASYNC_THREAD_WORKER_FLAG_IDLE;
+			uv_mutex_unlock(&worker->mutex);
+			
+			return job;
+		}
+	}
+	
+	return NULL;
+}
 
-#ifdef ZTS
-	str_main = zend_new_interned_string(zend_string_init(ZEND_STRL("main"), 1));
+static void run_jobs(async_thread_worker *worker)
+{
+	async_thread_pool *pool;
+	async_thread_job *job;
 	
-	if (ASYNC_G(cli)) {
-		sapi_deactivate_func = sapi_module.deactivate;
-		sapi_module.deactivate = NULL;
+	zend_bool closed;
+	
+	pool = worker->pool;
+	
+	while (1) {
+		job = next_job(worker, &closed);
 		
-		prev_interrupt_handler = zend_interrupt_function;
-		zend_interrupt_function = interrupt_thread;
+		if (job == NULL) {
+			if (closed) {
+				break;
+			}
+			
+			if (UNEXPECTED(FAILURE == async_await_op(&worker->wait))) {
+				ASYNC_RESET_OP(&worker->wait);
+				break;
+			}
+			
+			ASYNC_RESET_OP(&worker->wait);
+			continue;
+		}
+		
+		worker->current = job;
+		
+		execute_job(job);
+		
+		worker->current = NULL;
+		
+		uv_mutex_lock(&pool->mutex);
+		ASYNC_LIST_APPEND(&pool->results, job);
+		uv_mutex_unlock(&pool->mutex);
+		
+		uv_async_send(&pool->handle);
 	}
-#endif
 }
 
-void async_thread_ce_unregister()
+ASYNC_CALLBACK notify_worker_cb(uv_async_t *handle)
 {
-#ifdef ZTS
-	if (ASYNC_G(cli)) {
-		zend_interrupt_function = prev_interrupt_handler;
-		sapi_module.deactivate = sapi_deactivate_func;
+	async_thread_worker *worker;
+	
+	worker = (async_thread_worker *) handle->data;
+	
+	ZEND_ASSERT(worker != NULL);
+	
+	if (worker->wait.status == ASYNC_STATUS_RUNNING) {
+		ASYNC_FINISH_OP(&worker->wait);
 	}
+}
 
-	zend_string_release(str_main);
+ASYNC_CALLBACK run_worker(void *arg)
+{
+	async_thread_worker *worker;
+	async_thread_pool *pool;
+	async_thread_job_queue jobs;
+	async_thread_job *job;
+	async_task_scheduler *scheduler;
+	
+	worker = (async_thread_worker *) arg;
+	pool = worker->pool;
+	
+	ts_resource(0);
+
+	TSRMLS_CACHE_UPDATE();
+	
+	startup_request();
+	
+	scheduler = async_task_scheduler_get();
+	
+	uv_async_init(&scheduler->loop, &worker->handle, notify_worker_cb);
+	worker->handle.data = worker;
+	
+	uv_mutex_lock(&worker->mutex);
+	worker->flags |= ASYNC_THREAD_WORKER_FLAG_READY;
+	uv_mutex_unlock(&worker->mutex);
+	
+	zend_first_try {
+		run_bootstrap(pool->bootstrap);
+		run_jobs(worker);
+	} zend_catch {
+		async_task_scheduler_handle_exit(scheduler);
+	} zend_end_try();
+	
+	uv_mutex_lock(&worker->mutex);
+	
+	worker->flags &= ~(ASYNC_THREAD_WORKER_FLAG_READY | ASYNC_THREAD_WORKER_FLAG_IDLE);
+	worker->flags |= ASYNC_THREAD_WORKER_FLAG_TERMINATED;
+	
+	jobs = worker->queue;
+	
+	worker->queue.first = NULL;
+	worker->queue.last = NULL;
+	
+	uv_mutex_unlock(&worker->mutex);
+	
+	ASYNC_UV_CLOSE(&worker->handle, NULL);
+	
+	// Job has been interrupted by exit() or a fatal error.
+	if (UNEXPECTED(worker->current != NULL)) {
+		ASYNC_LIST_PREPEND(&jobs, worker->current);
+		
+		worker->current = NULL;
+	}
+	
+	for (job = jobs.first; job != NULL; job = job->next) {
+		fail_job(job, zend_strpprintf(0, "Worker thread terminated before job %s has been completed", ZSTR_VAL(job->name)));
+	}
+	
+	php_request_shutdown(NULL);
+	ts_free_thread();
+	
+	uv_mutex_lock(&pool->mutex);
+	
+	while (jobs.first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(&jobs, job);
+		ASYNC_LIST_APPEND(&pool->results, job);
+	}
+	
+	pool->terminated++;
+	
+	uv_mutex_unlock(&pool->mutex);
+	
+	uv_async_send(&pool->handle);
+}
+
+static void deliver_job(async_thread_pool *pool, async_thread_job *job, zval *error)
+{
+	async_thread_job_op *op;
+	
+	zval tmp;
+	
+	if (--pool->pending == 0 && !(pool->flags & ASYNC_THREAD_POOL_FLAG_CLOSED)) {
+		uv_unref((uv_handle_t *) &pool->handle);
+	}
+	
+	op = (async_thread_job_op *) job->op;
+	
+	if (op != NULL) {
+		op->job = NULL;
+		
+		if (error != NULL) {
+			ASYNC_FAIL_OP(op, error);
+		} else if (job->failed) {
+			ASYNC_PREPARE_SCHEDULER_EXCEPTION(&tmp, async_job_failed_ce, "%s", ZSTR_VAL(job->data));
+			ASYNC_FAIL_OP(op, &tmp);
+			
+			zval_ptr_dtor(&tmp);
+		} else {
+			ZVAL_STRINGL(&tmp, ZSTR_VAL(job->data), ZSTR_LEN(job->data));
+			ASYNC_RESOLVE_OP(op, &tmp);
+			
+			zval_ptr_dtor(&tmp);
+		}
+	}
+	
+	free_job(job);
+}
+
+ASYNC_CALLBACK close_pool_cb(uv_handle_t *handle)
+{
+	async_thread_pool *pool;
+	
+	pool = (async_thread_pool *) handle->data;
+	
+	ZEND_ASSERT(pool != NULL);
+	
+	ASYNC_DELREF(&pool->std);
+}
+
+ASYNC_CALLBACK notify_pool_cb(uv_async_t *handle)
+{
+	async_thread_pool *pool;
+	async_thread_job_queue jobs;
+	async_thread_job *job;
+	
+	uint32_t terminated;
+	
+	pool = (async_thread_pool *) handle->data;
+	
+	ZEND_ASSERT(pool != NULL);
+	
+	uv_mutex_lock(&pool->mutex);
+	
+	jobs = pool->results;
+	terminated = pool->terminated;
+	
+	pool->results.first = NULL;
+	pool->results.last = NULL;
+	
+	uv_mutex_unlock(&pool->mutex);
+	
+	while (jobs.first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(&jobs, job);
+		
+		deliver_job(pool, job, NULL);
+	}
+	
+	if (terminated == pool->size) {
+		pool->flags |= ASYNC_THREAD_POOL_FLAG_CLOSED;
+		
+		if (pool->shutdown.func != NULL) {
+			pool->shutdown.func = NULL;
+			
+			ASYNC_LIST_REMOVE(&pool->scheduler->shutdown, &pool->shutdown);
+		}
+		
+		ASYNC_UV_TRY_CLOSE(handle, close_pool_cb);
+	}
+}
+
+ASYNC_CALLBACK shutdown_pool_cb(void *arg, zval *error)
+{
+	async_thread_pool *pool;
+	async_thread_worker *worker;
+	async_thread_job_queue jobs;
+	async_thread_job *job;
+	
+	zval tmp;
+	
+	uint32_t i;
+	
+	pool = (async_thread_pool *) arg;
+	
+	pool->shutdown.func = NULL;
+	pool->flags |= ASYNC_THREAD_POOL_FLAG_CLOSED;
+	
+	jobs.first = NULL;
+	jobs.last = NULL;
+	
+	for (i = 0; i < pool->size; i++) {
+		worker = &pool->workers[i];
+		
+		uv_mutex_lock(&worker->mutex);
+		
+		while (worker->queue.first != NULL) {
+			ASYNC_LIST_EXTRACT_FIRST(&worker->queue, job);
+			ASYNC_LIST_APPEND(&jobs, job);
+		}
+		
+		worker->flags |= ASYNC_THREAD_WORKER_FLAG_CLOSED;
+		
+		if (worker->flags & ASYNC_THREAD_WORKER_FLAG_READY) {
+			uv_async_send(&worker->handle);
+		}
+		
+		uv_mutex_unlock(&worker->mutex);
+	}
+	
+	if (jobs.first != NULL) {
+		ASYNC_PREPARE_SCHEDULER_ERROR(&tmp, "Thread pool has been closed");
+		
+		if (error != NULL) {
+			zend_exception_set_previous(Z_OBJ_P(&tmp), Z_OBJ_P(error));
+			Z_ADDREF_P(error);
+		}
+		
+		while (jobs.first != NULL) {
+			ASYNC_LIST_EXTRACT_FIRST(&jobs, job);
+			
+			deliver_job(pool, job, &tmp);
+		}
+		
+		zval_ptr_dtor(&tmp);
+	}
+	
+	// Keep the loop alive until all workers have terminated.
+	if (!uv_is_closing((uv_handle_t *) &pool->handle)) {
+		uv_ref((uv_handle_t *) &pool->handle);
+	}
+}
+
+static int enqueue_job(async_thread_pool *pool, async_thread_job *job)
+{
+	async_thread_worker *worker;
+	
+	uint32_t i;
+	uint32_t j;
+	
+	for (i = 0; i < pool->size; i++) {
+		worker = &pool->workers[pool->next++ % pool->size];
+		
+		uv_mutex_lock(&worker->mutex);
+		
+		if (UNEXPECTED(worker->flags & ASYNC_THREAD_WORKER_FLAG_TERMINATED)) {
+			uv_mutex_unlock(&worker->mutex);
+			
+			continue;
+		}
+		
+		ASYNC_LIST_APPEND(&worker->queue, job);
+		
+		if (worker->flags & ASYNC_THREAD_WORKER_FLAG_IDLE) {
+			worker->flags &= ~ASYNC_THREAD_WORKER_FLAG_IDLE;
+			
+			uv_async_send(&worker->handle);
+			uv_mutex_unlock(&worker->mutex);
+			
+			return SUCCESS;
+		}
+		
+		uv_mutex_unlock(&worker->mutex);
+		
+		// Worker is busy, wake up an idle worker that can steal the job.
+		for (j = 0; j < pool->size; j++) {
+			worker = &pool->workers[j];
+			
+			uv_mutex_lock(&worker->mutex);
+			
+			if (worker->flags & ASYNC_THREAD_WORKER_FLAG_IDLE) {
+				worker->flags &= ~ASYNC_THREAD_WORKER_FLAG_IDLE;
+				
+				uv_async_send(&worker->handle);
+				uv_mutex_unlock(&worker->mutex);
+				
+				break;
+			}
+			
+			uv_mutex_unlock(&worker->mutex);
+		}
+		
+		return SUCCESS;
+	}
+	
+	return FAILURE;
+}
+
+#endif
+
+static zend_object *async_thread_pool_object_create(zend_class_entry *ce)
+{
+	async_thread_pool *pool;
+	
+	pool = ecalloc(1, sizeof(async_thread_pool));
+	
+	zend_object_std_init(&pool->std, ce);
+	pool->std.handlers = &async_thread_pool_handlers;
+	
+	return &pool->std;
+}
+
+static void async_thread_pool_object_dtor(zend_object *object)
+{
+#ifdef ZTS
+	async_thread_pool *pool;
+	
+	pool = (async_thread_pool *) object;
+	
+	if (pool->shutdown.func != NULL) {
+		ASYNC_LIST_REMOVE(&pool->scheduler->shutdown, &pool->shutdown);
+		
+		pool->shutdown.func(pool, NULL);
+	}
+#endif
+}
+
+static void async_thread_pool_object_destroy(zend_object *object)
+{
+	async_thread_pool *pool;
+	
+#ifdef ZTS
+	async_thread_job *job;
+	
+	uint32_t i;
+#endif
+	
+	pool = (async_thread_pool *) object;
+	
+#ifdef ZTS
+	if (pool->workers != NULL) {
+		for (i = 0; i < pool->started; i++) {
+			uv_thread_join(&pool->workers[i].impl);
+		}
+		
+		for (i = 0; i < pool->size; i++) {
+			uv_mutex_destroy(&pool->workers[i].mutex);
+		}
+		
+		while (pool->results.first != NULL) {
+			ASYNC_LIST_EXTRACT_FIRST(&pool->results, job);
+			
+			free_job(job);
+		}
+		
+		pefree(pool->workers, 1);
+		
+		uv_mutex_destroy(&pool->mutex);
+		
+		async_task_scheduler_unref(pool->scheduler);
+		
+		zend_string_release(pool->bootstrap);
+	}
+#endif
+	
+	zend_object_std_dtor(&pool->std);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_thread_pool_ctor, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, file, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 1)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadPool, __construct)
+{
+#ifndef ZTS
+	zend_throw_error(NULL, "Threads require PHP to be compiled in thread safe mode (ZTS)");
+#else
+	async_thread_pool *pool;
+	async_thread_worker *worker;
+	uv_cpu_info_t *info;
+	zend_string *file;
+	
+	char path[MAXPATHLEN];
+	zend_long size;
+	zval *val;
+	
+	uint32_t i;
+	int count;
+	int code;
+	
+	val = NULL;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 2)
+		Z_PARAM_STR(file)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_ZVAL(val)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(!ASYNC_G(cli), "Threads are only supported if PHP is run from the command line (cli)");
+	
+	pool = (async_thread_pool *) Z_OBJ_P(getThis());
+	
+	ASYNC_CHECK_ERROR(pool->workers != NULL, "Thread pool has already been started");
+	
+	if (val == NULL || Z_TYPE_P(val) == IS_NULL) {
+		size = 1;
+		
+		if (EXPECTED(0 == uv_cpu_info(&info, &count))) {
+			size = MAX(1, count);
+			
+			uv_free_cpu_info(info, count);
+		}
+	} else {
+		size = zval_get_long(val);
+	}
+	
+	ASYNC_CHECK_ERROR(size < 1, "Thread pool size must be at least 1");
+	ASYNC_CHECK_ERROR(!VCWD_REALPATH(ZSTR_VAL(file), path), "Failed to locate thread bootstrap file: %s", ZSTR_VAL(file));
+	
+	pool->scheduler = async_task_scheduler_ref();
+	pool->bootstrap = zend_string_init(path, strlen(path), 1);
+	
+	pool->size = (uint32_t) size;
+	pool->workers = pecalloc(pool->size, sizeof(async_thread_worker), 1);
+	
+	uv_mutex_init(&pool->mutex);
+	
+	// Handle is only referenced while jobs are pending.
+	uv_async_init(&pool->scheduler->loop, &pool->handle, notify_pool_cb);
+	uv_unref((uv_handle_t *) &pool->handle);
+	
+	pool->handle.data = pool;
+	
+	ASYNC_ADDREF(&pool->std);
+	
+	pool->shutdown.func = shutdown_pool_cb;
+	pool->shutdown.object = pool;
+	
+	ASYNC_LIST_APPEND(&pool->scheduler->shutdown, &pool->shutdown);
+	
+	for (i = 0; i < pool->size; i++) {
+		worker = &pool->workers[i];
+		worker->pool = pool;
+		
+		uv_mutex_init(&worker->mutex);
+	}
+	
+	for (code = 0; pool->started < pool->size; pool->started++) {
+		code = uv_thread_create(&pool->workers[pool->started].impl, run_worker, &pool->workers[pool->started]);
+		
+		if (UNEXPECTED(code < 0)) {
+			break;
+		}
+	}
+	
+	if (UNEXPECTED(code < 0)) {
+		for (i = pool->started; i < pool->size; i++) {
+			pool->workers[i].flags |= ASYNC_THREAD_WORKER_FLAG_TERMINATED;
+		}
+		
+		uv_mutex_lock(&pool->mutex);
+		pool->terminated += pool->size - pool->started;
+		uv_mutex_unlock(&pool->mutex);
+		
+		ASYNC_LIST_REMOVE(&pool->scheduler->shutdown, &pool->shutdown);
+		
+		shutdown_pool_cb(pool, NULL);
+		
+		uv_async_send(&pool->handle);
+		
+		zend_throw_error(NULL, "Failed to create thread: %s", uv_strerror(code));
+	}
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_pool_get_size, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadPool, getSize)
+{
+	ZEND_PARSE_PARAMETERS_NONE();
+	
+#ifdef ZTS
+	RETURN_LONG(((async_thread_pool *) Z_OBJ_P(getThis()))->size);
+#else
+	RETURN_LONG(0);
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_pool_close, 0, 0, IS_VOID, 0)
+	ZEND_ARG_OBJ_INFO(0, error, Throwable, 1)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadPool, close)
+{
+#ifdef ZTS
+	async_thread_pool *pool;
+#endif
+	
+	zval *val;
+	
+	val = NULL;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 1)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_OBJECT_OF_CLASS_EX(val, zend_ce_throwable, 1, 0)
+	ZEND_PARSE_PARAMETERS_END();
+	
+#ifdef ZTS
+	pool = (async_thread_pool *) Z_OBJ_P(getThis());
+	
+	if (EXPECTED(pool->shutdown.func != NULL)) {
+		ASYNC_LIST_REMOVE(&pool->scheduler->shutdown, &pool->shutdown);
+		
+		pool->shutdown.func(pool, (val == NULL || Z_TYPE_P(val) == IS_NULL) ? NULL : val);
+	}
+#endif
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_thread_pool_submit, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, job, IS_STRING, 0)
+	ZEND_ARG_VARIADIC_INFO(0, arguments)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadPool, submit)
+{
+#ifdef ZTS
+	async_thread_pool *pool;
+	async_thread_job *job;
+	async_thread_job_op *op;
+	
+	zend_string *data;
+	zval args;
+	
+	uint32_t i;
+#endif
+	
+	zend_string *name;
+	zval *params;
+	uint32_t count;
+	
+	params = NULL;
+	count = 0;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, -1)
+		Z_PARAM_STR(name)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_VARIADIC('+', params, count)
+	ZEND_PARSE_PARAMETERS_END();
+	
+#ifndef ZTS
+	zend_throw_error(NULL, "Threads require PHP to be compiled in thread safe mode (ZTS)");
+#else
+	pool = (async_thread_pool *) Z_OBJ_P(getThis());
+	
+	ASYNC_CHECK_ERROR(pool->workers == NULL || pool->flags & ASYNC_THREAD_POOL_FLAG_CLOSED, "Thread pool has been closed");
+	
+	// Arguments are transferred to the worker thread in serialized form.
+	array_init_size(&args, count);
+	
+	for (i = 0; i < count; i++) {
+		Z_TRY_ADDREF(params[i]);
+		zend_hash_next_index_insert(Z_ARRVAL(args), &params[i]);
+	}
+	
+	data = serialize_job_data(&args);
+	
+	zval_ptr_dtor(&args);
+	
+	if (UNEXPECTED(data == NULL)) {
+		return;
+	}
+	
+	job = pecalloc(1, sizeof(async_thread_job), 1);
+	job->name = zend_string_init(ZSTR_VAL(name), ZSTR_LEN(name), 1);
+	job->data = data;
+	
+	ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_thread_job_op));
+	
+	op->job = job;
+	job->op = (async_op *) op;
+	
+	if (UNEXPECTED(FAILURE == enqueue_job(pool, job))) {
+		ASYNC_FREE_OP(op);
+		free_job(job);
+		
+		zend_throw_error(NULL, "Thread pool has no running worker threads");
+		return;
+	}
+	
+	if (pool->pending++ == 0) {
+		uv_ref((uv_handle_t *) &pool->handle);
+	}
+	
+	if (UNEXPECTED(FAILURE == async_await_op((async_op *) op))) {
+		// Result of the job will be discarded when it is delivered.
+		if (op->job != NULL) {
+			op->job->op = NULL;
+		}
+		
+		ASYNC_FORWARD_OP_ERROR(op);
+		ASYNC_FREE_OP(op);
+		
+		return;
+	}
+	
+	if (UNEXPECTED(FAILURE == unserialize_job_data(return_value, Z_STR_P(&op->base.result)))) {
+		zend_throw_error(NULL, "Failed to unserialize result of job %s", ZSTR_VAL(name));
+	}
+	
+	ASYNC_FREE_OP(op);
+#endif
+}
+
+//LCOV_EXCL_START
+ASYNC_METHOD_NO_WAKEUP(ThreadPool, async_thread_pool_ce)
+//LCOV_EXCL_STOP
+
+static const zend_function_entry thread_pool_functions[] = {
+	PHP_ME(ThreadPool, __construct, arginfo_thread_pool_ctor, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadPool, __wakeup, arginfo_no_wakeup, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadPool, getSize, arginfo_thread_pool_get_size, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadPool, close, arginfo_thread_pool_close, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadPool, submit, arginfo_thread_pool_submit, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
+
+#ifdef ZTS
+
+static async_thread_channel_state *open_channel_state(zend_string *name, uint32_t size)
+{
+	async_thread_channel_state *state;
+	
+	uv_mutex_lock(&thread_channels_mutex);
+	
+	state = zend_hash_str_find_ptr(&thread_channels, ZSTR_VAL(name), ZSTR_LEN(name));
+	
+	// Capacity is fixed by the thread that creates the channel.
+	if (state == NULL) {
+		state = pecalloc(1, sizeof(async_thread_channel_state), 1);
+		state->name = zend_string_init(ZSTR_VAL(name), ZSTR_LEN(name), 1);
+		state->size = size;
+		state->data = pecalloc(size, sizeof(zend_string *), 1);
+		
+		uv_mutex_init(&state->mutex);
+		
+		zend_hash_str_add_ptr(&thread_channels, ZSTR_VAL(state->name), ZSTR_LEN(state->name), state);
+	}
+	
+	state->refcount++;
+	
+	uv_mutex_unlock(&thread_channels_mutex);
+	
+	return state;
+}
+
+static void release_channel_state(async_thread_channel_state *state)
+{
+	uv_mutex_lock(&thread_channels_mutex);
+	
+	if (--state->refcount > 0) {
+		uv_mutex_unlock(&thread_channels_mutex);
+		
+		return;
+	}
+	
+	zend_hash_str_del(&thread_channels, ZSTR_VAL(state->name), ZSTR_LEN(state->name));
+	
+	uv_mutex_unlock(&thread_channels_mutex);
+	
+	while (state->len > 0) {
+		zend_string_release(state->data[state->rpos]);
+		
+		state->rpos = (state->rpos + 1) % state->size;
+		state->len--;
+	}
+	
+	uv_mutex_destroy(&state->mutex);
+	
+	zend_string_release(state->name);
+	
+	pefree(state->data, 1);
+	pefree(state, 1);
+}
+
+/* Wakes up all registered channel objects, the channel mutex must be held by the caller. */
+static void wake_channel_waiters(async_thread_channel_waiter_list *list, uint8_t flag)
+{
+	async_thread_channel_waiter *waiter;
+	
+	while (list->first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(list, waiter);
+		
+		waiter->channel->waiting &= ~flag;
+		
+		uv_async_send(&waiter->channel->handle);
+	}
+}
+
+static int push_channel_message(async_thread_channel *channel, zend_string *data, zend_bool *closed)
+{
+	async_thread_channel_state *state;
+	
+	state = channel->state;
+	
+	uv_mutex_lock(&state->mutex);
+	
+	*closed = (channel->shutdown.func == NULL || state->flags & ASYNC_THREAD_CHANNEL_FLAG_CLOSED) ? 1 : 0;
+	
+	if (UNEXPECTED(*closed)) {
+		uv_mutex_unlock(&state->mutex);
+		
+		return FAILURE;
+	}
+	
+	if (state->len < state->size) {
+		state->data[(state->rpos + state->len++) % state->size] = data;
+		
+		wake_channel_waiters(&state->receivers, ASYNC_THREAD_CHANNEL_WAITING_RECEIVE);
+		uv_mutex_unlock(&state->mutex);
+		
+		return SUCCESS;
+	}
+	
+	// Registration must happen while the mutex is held, otherwise a receiver could miss the waiting sender.
+	if (!(channel->waiting & ASYNC_THREAD_CHANNEL_WAITING_SEND)) {
+		channel->waiting |= ASYNC_THREAD_CHANNEL_WAITING_SEND;
+		
+		ASYNC_LIST_APPEND(&state->senders, &channel->sender);
+	}
+	
+	uv_mutex_unlock(&state->mutex);
+	
+	return FAILURE;
+}
+
+static int pop_channel_message(async_thread_channel *channel, zend_string **data, zend_bool *closed)
+{
+	async_thread_channel_state *state;
+	
+	state = channel->state;
+	
+	uv_mutex_lock(&state->mutex);
+	
+	if (state->len > 0 && channel->shutdown.func != NULL) {
+		*data = state->data[state->rpos];
+		*closed = 0;
+		
+		state->rpos = (state->rpos + 1) % state->size;
+		state->len--;
+		
+		wake_channel_waiters(&state->senders, ASYNC_THREAD_CHANNEL_WAITING_SEND);
+		uv_mutex_unlock(&state->mutex);
+		
+		return SUCCESS;
+	}
+	
+	*closed = (channel->shutdown.func == NULL || state->flags & ASYNC_THREAD_CHANNEL_FLAG_CLOSED) ? 1 : 0;
+	
+	if (EXPECTED(!*closed) && !(channel->waiting & ASYNC_THREAD_CHANNEL_WAITING_RECEIVE)) {
+		channel->waiting |= ASYNC_THREAD_CHANNEL_WAITING_RECEIVE;
+		
+		ASYNC_LIST_APPEND(&state->receivers, &channel->receiver);
+	}
+	
+	uv_mutex_unlock(&state->mutex);
+	
+	return FAILURE;
+}
+
+static int await_channel(async_thread_channel *channel, async_op_list *list, async_op *op)
+{
+	async_context *context;
+	
+	int code;
+	
+	ASYNC_APPEND_OP(list, op);
+	
+	context = async_context_get();
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_ENTER(channel->scheduler);
+	}
+	
+	code = async_await_op(op);
+	
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_EXIT(channel->scheduler);
+	}
+	
+	return code;
+}
+
+static void resume_channel_tasks(async_thread_channel *channel)
+{
+	async_op *op;
+	
+	// Woken tasks retry their operation and wait again if another task was faster.
+	while (channel->receivers.first != NULL) {
+		ASYNC_NEXT_OP(&channel->receivers, op);
+		ASYNC_FINISH_OP(op);
+	}
+	
+	while (channel->senders.first != NULL) {
+		ASYNC_NEXT_OP(&channel->senders, op);
+		ASYNC_FINISH_OP(op);
+	}
+}
+
+ASYNC_CALLBACK notify_channel_cb(uv_async_t *handle)
+{
+	async_thread_channel *channel;
+	
+	channel = (async_thread_channel *) handle->data;
+	
+	ZEND_ASSERT(channel != NULL);
+	
+	resume_channel_tasks(channel);
+}
+
+ASYNC_CALLBACK close_channel_cb(uv_handle_t *handle)
+{
+	async_thread_channel *channel;
+	
+	channel = (async_thread_channel *) handle->data;
+	
+	ZEND_ASSERT(channel != NULL);
+	
+	ASYNC_DELREF(&channel->std);
+}
+
+ASYNC_CALLBACK shutdown_channel_cb(void *arg, zval *error)
+{
+	async_thread_channel *channel;
+	async_thread_channel_state *state;
+	
+	channel = (async_thread_channel *) arg;
+	state = channel->state;
+	
+	channel->shutdown.func = NULL;
+	
+	// Other threads must not signal the handle once it is being closed.
+	uv_mutex_lock(&state->mutex);
+	
+	if (channel->waiting & ASYNC_THREAD_CHANNEL_WAITING_RECEIVE) {
+		ASYNC_LIST_REMOVE(&state->receivers, &channel->receiver);
+	}
+	
+	if (channel->waiting & ASYNC_THREAD_CHANNEL_WAITING_SEND) {
+		ASYNC_LIST_REMOVE(&state->senders, &channel->sender);
+	}
+	
+	channel->waiting = 0;
+	
+	uv_mutex_unlock(&state->mutex);
+	
+	resume_channel_tasks(channel);
+	
+	ASYNC_UV_TRY_CLOSE_REF(&channel->std, &channel->handle, close_channel_cb);
+}
+
+#endif
+
+static zend_object *async_thread_channel_object_create(zend_class_entry *ce)
+{
+	async_thread_channel *channel;
+	
+	channel = ecalloc(1, sizeof(async_thread_channel));
+	
+	zend_object_std_init(&channel->std, ce);
+	channel->std.handlers = &async_thread_channel_handlers;
+	
+	return &channel->std;
+}
+
+static void async_thread_channel_object_dtor(zend_object *object)
+{
+#ifdef ZTS
+	async_thread_channel *channel;
+	
+	channel = (async_thread_channel *) object;
+	
+	if (channel->shutdown.func != NULL) {
+		ASYNC_LIST_REMOVE(&channel->scheduler->shutdown, &channel->shutdown);
+		
+		channel->shutdown.func(channel, NULL);
+	}
+#endif
+}
+
+static void async_thread_channel_object_destroy(zend_object *object)
+{
+	async_thread_channel *channel;
+	
+	channel = (async_thread_channel *) object;
+	
+#ifdef ZTS
+	if (channel->state != NULL) {
+		release_channel_state(channel->state);
+		
+		async_task_scheduler_unref(channel->scheduler);
+	}
+#endif
+	
+	zend_object_std_dtor(&channel->std);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_thread_channel_ctor, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, capacity, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, __construct)
+{
+#ifdef ZTS
+	async_thread_channel *channel;
+#endif
+	
+	zend_string *name;
+	zend_long size;
+	
+	size = 1;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 2)
+		Z_PARAM_STR(name)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_LONG(size)
+	ZEND_PARSE_PARAMETERS_END();
+	
+#ifndef ZTS
+	zend_throw_error(NULL, "Threads require PHP to be compiled in thread safe mode (ZTS)");
+#else
+	ASYNC_CHECK_ERROR(size < 1 || size > ASYNC_THREAD_CHANNEL_MAX_CAPACITY, "Channel capacity must be between 1 and %d", ASYNC_THREAD_CHANNEL_MAX_CAPACITY);
+	
+	channel = (async_thread_channel *) Z_OBJ_P(getThis());
+	
+	ASYNC_CHECK_ERROR(channel->state != NULL, "Thread channel has already been opened");
+	
+	channel->scheduler = async_task_scheduler_ref();
+	channel->state = open_channel_state(name, (uint32_t) size);
+	
+	channel->receiver.channel = channel;
+	channel->sender.channel = channel;
+	
+	// Handle must not keep the loop alive, waiting tasks mark the scheduler as busy instead.
+	uv_async_init(&channel->scheduler->loop, &channel->handle, notify_channel_cb);
+	uv_unref((uv_handle_t *) &channel->handle);
+	
+	channel->handle.data = channel;
+	
+	channel->shutdown.func = shutdown_channel_cb;
+	channel->shutdown.object = channel;
+	
+	ASYNC_LIST_APPEND(&channel->scheduler->shutdown, &channel->shutdown);
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_channel_get_name, 0, 0, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, getName)
+{
+#ifdef ZTS
+	zend_string *name;
+#endif
+	
+	ZEND_PARSE_PARAMETERS_NONE();
+	
+#ifdef ZTS
+	// Name is allocated in persistent memory, it must be copied into the request heap.
+	name = ((async_thread_channel *) Z_OBJ_P(getThis()))->state->name;
+	
+	RETURN_STRINGL(ZSTR_VAL(name), ZSTR_LEN(name));
+#else
+	RETURN_EMPTY_STRING();
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_channel_close, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, close)
+{
+#ifdef ZTS
+	async_thread_channel_state *state;
+#endif
+	
+	ZEND_PARSE_PARAMETERS_NONE();
+	
+#ifdef ZTS
+	state = ((async_thread_channel *) Z_OBJ_P(getThis()))->state;
+	
+	uv_mutex_lock(&state->mutex);
+	
+	if (!(state->flags & ASYNC_THREAD_CHANNEL_FLAG_CLOSED)) {
+		state->flags |= ASYNC_THREAD_CHANNEL_FLAG_CLOSED;
+		
+		wake_channel_waiters(&state->receivers, ASYNC_THREAD_CHANNEL_WAITING_RECEIVE);
+		wake_channel_waiters(&state->senders, ASYNC_THREAD_CHANNEL_WAITING_SEND);
+	}
+	
+	uv_mutex_unlock(&state->mutex);
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_channel_is_closed, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, isClosed)
+{
+#ifdef ZTS
+	async_thread_channel_state *state;
+	
+	zend_bool closed;
+#endif
+	
+	ZEND_PARSE_PARAMETERS_NONE();
+	
+#ifdef ZTS
+	state = ((async_thread_channel *) Z_OBJ_P(getThis()))->state;
+	
+	uv_mutex_lock(&state->mutex);
+	closed = (state->flags & ASYNC_THREAD_CHANNEL_FLAG_CLOSED) ? 1 : 0;
+	uv_mutex_unlock(&state->mutex);
+	
+	RETURN_BOOL(closed);
+#else
+	RETURN_TRUE;
+#endif
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_thread_channel_send, 0, 1, IS_VOID, 0)
+	ZEND_ARG_INFO(0, message)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, send)
+{
+#ifdef ZTS
+	async_thread_channel *channel;
+	async_op *op;
+	
+	zend_string *data;
+	zend_bool closed;
+#endif
+	
+	zval *val;
+	
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 1, 1)
+		Z_PARAM_ZVAL(val)
+	ZEND_PARSE_PARAMETERS_END();
+	
+#ifdef ZTS
+	channel = (async_thread_channel *) Z_OBJ_P(getThis());
+	
+	// Messages are transferred to other threads in serialized form.
+	data = serialize_job_data(val);
+	
+	if (UNEXPECTED(data == NULL)) {
+		return;
+	}
+	
+	op = NULL;
+	
+	while (FAILURE == push_channel_message(channel, data, &closed)) {
+		if (UNEXPECTED(closed)) {
+			zend_throw_exception(async_channel_closed_exception_ce, "Channel has been closed", 0);
+			break;
+		}
+		
+		if (op == NULL) {
+			ASYNC_ALLOC_OP(op);
+		}
+		
+		if (UNEXPECTED(FAILURE == await_channel(channel, &channel->senders, op))) {
+			ASYNC_FORWARD_OP_ERROR(op);
+			break;
+		}
+		
+		ASYNC_RESET_OP(op);
+	}
+	
+	if (UNEXPECTED(EG(exception))) {
+		zend_string_release(data);
+	}
+	
+	if (op != NULL) {
+		ASYNC_FREE_OP(op);
+	}
+#endif
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_thread_channel_receive, 0, 0, 0)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(ThreadChannel, receive)
+{
+#ifdef ZTS
+	async_thread_channel *channel;
+	async_op *op;
+	
+	zend_string *data;
+	zend_bool closed;
+	int code;
+#endif
+	
+	ZEND_PARSE_PARAMETERS_NONE();
+	
+#ifdef ZTS
+	channel = (async_thread_channel *) Z_OBJ_P(getThis());
+	
+	op = NULL;
+	data = NULL;
+	
+	while (FAILURE == pop_channel_message(channel, &data, &closed)) {
+		if (UNEXPECTED(closed)) {
+			zend_throw_exception(async_channel_closed_exception_ce, "Channel has been closed", 0);
+			break;
+		}
+		
+		if (op == NULL) {
+			ASYNC_ALLOC_OP(op);
+		}
+		
+		if (UNEXPECTED(FAILURE == await_channel(channel, &channel->receivers, op))) {
+			ASYNC_FORWARD_OP_ERROR(op);
+			break;
+		}
+		
+		ASYNC_RESET_OP(op);
+	}
+	
+	if (op != NULL) {
+		ASYNC_FREE_OP(op);
+	}
+	
+	if (EXPECTED(data != NULL)) {
+		code = unserialize_job_data(return_value, data);
+		
+		zend_string_release(data);
+		
+		ASYNC_CHECK_ERROR(code == FAILURE, "Failed to unserialize channel message");
+	}
+#endif
+}
+
+//LCOV_EXCL_START
+ASYNC_METHOD_NO_WAKEUP(ThreadChannel, async_thread_channel_ce)
+//LCOV_EXCL_STOP
+
+static const zend_function_entry thread_channel_functions[] = {
+	PHP_ME(ThreadChannel, __construct, arginfo_thread_channel_ctor, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, __wakeup, arginfo_no_wakeup, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, getName, arginfo_thread_channel_get_name, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, close, arginfo_thread_channel_close, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, isClosed, arginfo_thread_channel_is_closed, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, send, arginfo_thread_channel_send, ZEND_ACC_PUBLIC)
+	PHP_ME(ThreadChannel, receive, arginfo_thread_channel_receive, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
+
+static const zend_function_entry empty_funcs[] = {
+	PHP_FE_END
+};
+
+#ifdef ZTS
+
+static void interrupt_thread(zend_execute_data *exec)
+{
+	async_thread *thread;
+	
+	if (ASYNC_G(thread)) {
+		thread = (async_thread *) ASYNC_G(thread);
+
+		if (thread->flags & ASYNC_THREAD_FLAG_KILLED) {
+			zend_bailout();
+		}
+	}
+	
+	if (prev_interrupt_handler) {
+		prev_interrupt_handler(exec);
+	}
+}
+
+#endif
+
+void async_thread_ce_register()
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "Concurrent", "Thread", thread_functions);
+	async_thread_ce = zend_register_internal_class(&ce);
+	async_thread_ce->ce_flags |= ZEND_ACC_FINAL;
+	async_thread_ce->create_object = async_thread_object_create;
+	async_thread_ce->serialize = zend_class_serialize_deny;
+	async_thread_ce->unserialize = zend_class_unserialize_deny;
+
+	memcpy(&async_thread_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	async_thread_handlers.free_obj = async_thread_object_destroy;
+	async_thread_handlers.dtor_obj = async_thread_object_dtor;
+	async_thread_handlers.clone_obj = NULL;
+
+	INIT_NS_CLASS_ENTRY(ce, "Concurrent", "ThreadPool", thread_pool_functions);
+	async_thread_pool_ce = zend_register_internal_class(&ce);
+	async_thread_pool_ce->ce_flags |= ZEND_ACC_FINAL;
+	async_thread_pool_ce->create_object = async_thread_pool_object_create;
+	async_thread_pool_ce->serialize = zend_class_serialize_deny;
+	async_thread_pool_ce->unserialize = zend_class_unserialize_deny;
+
+	memcpy(&async_thread_pool_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	async_thread_pool_handlers.free_obj = async_thread_pool_object_destroy;
+	async_thread_pool_handlers.dtor_obj = async_thread_pool_object_dtor;
+	async_thread_pool_handlers.clone_obj = NULL;
+
+	INIT_NS_CLASS_ENTRY(ce, "Concurrent", "ThreadChannel", thread_channel_functions);
+	async_thread_channel_ce = zend_register_internal_class(&ce);
+	async_thread_channel_ce->ce_flags |= ZEND_ACC_FINAL;
+	async_thread_channel_ce->create_object = async_thread_channel_object_create;
+	async_thread_channel_ce->serialize = zend_class_serialize_deny;
+	async_thread_channel_ce->unserialize = zend_class_unserialize_deny;
+
+	memcpy(&async_thread_channel_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	async_thread_channel_handlers.free_obj = async_thread_channel_object_destroy;
+	async_thread_channel_handlers.dtor_obj = async_thread_channel_object_dtor;
+	async_thread_channel_handlers.clone_obj = NULL;
+
+	INIT_NS_CLASS_ENTRY(ce, "Concurrent", "JobFailedException", empty_funcs);
+	async_job_failed_ce = zend_register_internal_class(&ce);
+
+	zend_do_inheritance(async_job_failed_ce, zend_ce_exception);
+
+#ifdef ZTS
+	str_main = zend_new_interned_string(zend_string_init(ZEND_STRL("main"), 1));
+	
+	zend_hash_init(&thread_channels, 0, NULL, NULL, 1);
+	uv_mutex_init(&thread_channels_mutex);
+	
+	if (ASYNC_G(cli)) {
+		sapi_deactivate_func = sapi_module.deactivate;
+		sapi_module.deactivate = NULL;
+		
+		prev_interrupt_handler = zend_interrupt_function;
+		zend_interrupt_function = interrupt_thread;
+	}
+#endif
+}
+
+void async_thread_ce_unregister()
+{
+#ifdef ZTS
+	if (ASYNC_G(cli)) {
+		zend_interrupt_function = prev_interrupt_handler;
+		sapi_module.deactivate = sapi_deactivate_func;
+	}
+
+	zend_string_release(str_main);
+	
+	zend_hash_destroy(&thread_channels);
+	uv_mutex_destroy(&thread_channels_mutex);
 #endif
 }
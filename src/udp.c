@@ -18,9 +18,14 @@
 
 #include "php_async.h"
 
+#include "async/buffer.h"
 #include "async/helper.h"
 #include "async/socket.h"
 
+#ifndef ZEND_WIN32
+#include <sys/uio.h>
+#endif
+
 #define ASYNC_SOCKET_UDP_TTL 200
 #define ASYNC_SOCKET_UDP_MULTICAST_LOOP 250
 #define ASYNC_SOCKET_UDP_MULTICAST_TTL 251
@@ -37,6 +42,10 @@ static zend_string *str_data;
 static zend_string *str_address;
 static zend_string *str_port;
 
+static uint32_t off_datagram_data;
+static uint32_t off_datagram_address;
+static uint32_t off_datagram_port;
+
 static zend_object *async_udp_datagram_object_create(zend_class_entry *ce);
 
 #define ASYNC_UDP_SOCKET_CONST(name, value) \
@@ -45,8 +54,21 @@ static zend_object *async_udp_datagram_object_create(zend_class_entry *ce);
 #define ASYNC_UDP_FLAG_RECEIVING 1
 #define ASYNC_UDP_FLAG_CONNECTED (1 << 1)
 
+#define ASYNC_UDP_DATAGRAM_FLAG_LAZY_PEER 1
+
+#define ASYNC_UDP_RECEIVE_SIZE 8192
+
+/* Default number of datagrams returned by receiveBatch(). */
+#define ASYNC_UDP_BATCH 64
+
+/* Number of datagrams being read using a single call to recvmmsg(). */
+#define ASYNC_UDP_MMSG 16
+
 typedef struct _async_udp_datagram {
+	/* Peer address, AF_UNSPEC if the datagram has no peer. */
 	php_sockaddr_storage peer;
+	
+	uint8_t flags;
 
 	zend_object std;
 } async_udp_datagram;
@@ -61,6 +83,25 @@ static zend_always_inline uint32_t async_udp_datagram_prop_offset(zend_string *n
 	return zend_get_property_info(async_udp_datagram_ce, name, 1)->offset;
 }
 
+/* Received datagrams convert the peer address into address and port properties on first access. */
+static void resolve_datagram_peer(async_udp_datagram *datagram)
+{
+	zend_string *ip;
+	uint16_t port;
+	
+	if (datagram->flags & ASYNC_UDP_DATAGRAM_FLAG_LAZY_PEER) {
+		datagram->flags &= ~ASYNC_UDP_DATAGRAM_FLAG_LAZY_PEER;
+		
+		if (EXPECTED(SUCCESS == async_socket_get_peer((const struct sockaddr *) &datagram->peer, &ip, &port))) {
+			ZVAL_STR(OBJ_PROP(&datagram->std, off_datagram_address), ip);
+			ZVAL_LONG(OBJ_PROP(&datagram->std, off_datagram_port), port);
+		} else {
+			ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_address));
+			ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_port));
+		}
+	}
+}
+
 typedef struct _async_udp_socket {
 	zend_object std;
 	
@@ -531,15 +572,32 @@ static PHP_METHOD(UdpSocket, setOption)
 	RETURN_BOOL((code < 0) ? 0 : 1);
 }
 
+static async_udp_datagram *create_datagram(const char *data, size_t len, const struct sockaddr *addr)
+{
+	async_udp_datagram *datagram;
+	
+	datagram = async_udp_datagram_obj(async_udp_datagram_object_create(async_udp_datagram_ce));
+	
+	ZVAL_STRINGL(OBJ_PROP(&datagram->std, off_datagram_data), data, len);
+
+	if (EXPECTED(addr != NULL && addr->sa_family != AF_UNSPEC)) {
+		memcpy(&datagram->peer, addr, async_socket_addr_size(addr));
+		
+		datagram->flags |= ASYNC_UDP_DATAGRAM_FLAG_LAZY_PEER;
+	} else {
+		ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_address));
+		ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_port));
+	}
+	
+	return datagram;
+}
+
 ASYNC_CALLBACK socket_received(uv_udp_t *udp, ssize_t nread, const uv_buf_t *buffer, const struct sockaddr *addr, unsigned int flags)
 {
 	async_udp_socket *socket;
 	async_udp_datagram *datagram;
 	
 	async_udp_recv_op *op;
-	
-	zend_string *ip;
-	uint16_t port;
 
 	socket = (async_udp_socket *) udp->data;
 	
@@ -547,7 +605,7 @@ ASYNC_CALLBACK socket_received(uv_udp_t *udp, ssize_t nread, const uv_buf_t *buf
 	ZEND_ASSERT(socket->receivers.first != NULL);
 	
 	if (UNEXPECTED(nread == 0)) {
-		efree(buffer->base);
+		async_buffer_pool_release(&socket->scheduler->buffers, buffer->base, buffer->len);
 		
 		return;
 	}
@@ -555,22 +613,15 @@ ASYNC_CALLBACK socket_received(uv_udp_t *udp, ssize_t nread, const uv_buf_t *buf
 	ASYNC_NEXT_CUSTOM_OP(&socket->receivers, op, async_udp_recv_op);
 	
 	if (EXPECTED(nread > 0)) {
-		datagram = async_udp_datagram_obj(async_udp_datagram_object_create(async_udp_datagram_ce));
-		
-		ZVAL_STRINGL(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data)), buffer->base, (size_t) nread);
-		efree(buffer->base);
-
-		if (EXPECTED(addr)) {
-			memcpy(&datagram->peer, addr, async_socket_addr_size(addr));
-			async_socket_get_peer(addr, &ip, &port);
-
-			ZVAL_STR(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address)), ip);
-			ZVAL_LONG(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_port)), port);
-		}
+		datagram = create_datagram(buffer->base, (size_t) nread, addr);
 		
 		ZVAL_OBJ(&op->base.result, &datagram->std);
 	}
 	
+	if (EXPECTED(buffer->base != NULL)) {
+		async_buffer_pool_release(&socket->scheduler->buffers, buffer->base, buffer->len);
+	}
+	
 	op->code = (int) nread;
 	
 	ASYNC_FINISH_OP(op);
@@ -592,46 +643,32 @@ ASYNC_CALLBACK socket_alloc_buffer(uv_handle_t *handle, size_t suggested_size, u
 	ZEND_ASSERT(socket->receivers.first != NULL);
 
 	buffer->len = ((async_udp_recv_op *) socket->receivers.first)->size;
-	buffer->base = emalloc(buffer->len);
+	buffer->base = async_buffer_pool_acquire(&socket->scheduler->buffers, buffer->len);
 }
 
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_udp_socket_receive, 0, 0, Concurrent\\Network\\UdpDatagram, 0)
 	ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 1)
 ZEND_END_ARG_INFO();
 
-static PHP_METHOD(UdpSocket, receive)
+static int await_datagram(async_udp_socket *socket, zend_long size, zval *result, zend_execute_data *execute_data)
 {
-	async_udp_socket *socket;
 	async_context *context;
 	async_udp_recv_op *op;
 	
-	zend_long size;
 	int code;
 	
-	size = 0;
-
-	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 1)
-		Z_PARAM_OPTIONAL
-		Z_PARAM_LONG(size)
-	ZEND_PARSE_PARAMETERS_END();
-	
-	ASYNC_CHECK_ERROR(size < 0, "UDP receive buffer size must not be negative");
-
-	if (size == 0) {
-		size = 8192;
-	}
-
-	socket = (async_udp_socket *) Z_OBJ_P(getThis());
-	
 	if (UNEXPECTED(Z_TYPE_P(&socket->error) != IS_UNDEF)) {
 		ASYNC_FORWARD_ERROR(&socket->error);
-		return;
+		return FAILURE;
 	}
 
 	if (!(socket->flags & ASYNC_UDP_FLAG_RECEIVING)) {
 		code = uv_udp_recv_start(&socket->handle, socket_alloc_buffer, socket_received);
 		
-		ASYNC_CHECK_EXCEPTION(code != 0, async_socket_exception_ce, "Failed to receive UDP data: %s", uv_strerror(code));
+		if (UNEXPECTED(code != 0)) {
+			zend_throw_exception_ex(async_socket_exception_ce, 0, "Failed to receive UDP data: %s", uv_strerror(code));
+			return FAILURE;
+		}
 		
 		socket->flags |= ASYNC_UDP_FLAG_RECEIVING;
 	}
@@ -654,12 +691,177 @@ static PHP_METHOD(UdpSocket, receive)
 	if (EXPECTED(!EG(exception))) {
 		if (op->code < 0) {
 			zend_throw_exception_ex(async_stream_exception_ce, 0, "UDP receive error: %s", uv_strerror(op->code));
-		} else if (USED_RET()) {
-			ZVAL_COPY(return_value, &op->base.result);
+		} else {
+			ZVAL_COPY(result, &op->base.result);
 		}
 	}
 	
 	ASYNC_FREE_OP(op);
+	
+	return EG(exception) ? FAILURE : SUCCESS;
+}
+
+#ifndef PHP_WIN32
+/* Reads datagrams that are already queued in the socket receive buffer without waiting for libuv to report them. */
+static void receive_queued_datagrams(async_udp_socket *socket, size_t size, zend_long max, HashTable *result)
+{
+	async_udp_datagram *datagram;
+	
+	uv_os_fd_t fd;
+	zval obj;
+	
+#ifdef HAVE_RECVMMSG
+	struct mmsghdr msgs[ASYNC_UDP_MMSG];
+	struct iovec iov[ASYNC_UDP_MMSG];
+	php_sockaddr_storage addr[ASYNC_UDP_MMSG];
+	
+	int count;
+	int i;
+	int n;
+#else
+	php_sockaddr_storage addr;
+	socklen_t len;
+	ssize_t count;
+	char *buf;
+#endif
+
+	if (UNEXPECTED(0 != uv_fileno((const uv_handle_t *) &socket->handle, &fd))) {
+		return;
+	}
+	
+#ifdef HAVE_RECVMMSG
+	while (zend_hash_num_elements(result) < max) {
+		n = (int) MIN(max - zend_hash_num_elements(result), ASYNC_UDP_MMSG);
+		
+		for (i = 0; i < n; i++) {
+			iov[i].iov_base = async_buffer_pool_acquire(&socket->scheduler->buffers, size);
+			iov[i].iov_len = size;
+			
+			memset(&msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+			
+			msgs[i].msg_hdr.msg_name = &addr[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(php_sockaddr_storage);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		
+		do {
+			count = recvmmsg(fd, msgs, (unsigned int) n, MSG_DONTWAIT, NULL);
+		} while (count == -1 && errno == EINTR);
+		
+		for (i = 0; i < count; i++) {
+			if (EXPECTED(msgs[i].msg_len > 0)) {
+				datagram = create_datagram(iov[i].iov_base, msgs[i].msg_len, (msgs[i].msg_hdr.msg_namelen > 0) ? (const struct sockaddr *) &addr[i] : NULL);
+				
+				ZVAL_OBJ(&obj, &datagram->std);
+				zend_hash_next_index_insert(result, &obj);
+			}
+		}
+		
+		for (i = 0; i < n; i++) {
+			async_buffer_pool_release(&socket->scheduler->buffers, iov[i].iov_base, size);
+		}
+		
+		if (count < n) {
+			break;
+		}
+	}
+#else
+	buf = async_buffer_pool_acquire(&socket->scheduler->buffers, size);
+	
+	while (zend_hash_num_elements(result) < max) {
+		len = sizeof(php_sockaddr_storage);
+		
+		do {
+			count = recvfrom(fd, buf, size, MSG_DONTWAIT, (struct sockaddr *) &addr, &len);
+		} while (count == -1 && errno == EINTR);
+		
+		if (count < 0) {
+			break;
+		}
+		
+		if (EXPECTED(count > 0)) {
+			datagram = create_datagram(buf, (size_t) count, (len > 0) ? (const struct sockaddr *) &addr : NULL);
+			
+			ZVAL_OBJ(&obj, &datagram->std);
+			zend_hash_next_index_insert(result, &obj);
+		}
+	}
+	
+	async_buffer_pool_release(&socket->scheduler->buffers, buf, size);
+#endif
+}
+#endif
+
+static PHP_METHOD(UdpSocket, receive)
+{
+	async_udp_socket *socket;
+	
+	zend_long size;
+	
+	size = 0;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 1)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_LONG(size)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(size < 0, "UDP receive buffer size must not be negative");
+
+	if (size == 0) {
+		size = ASYNC_UDP_RECEIVE_SIZE;
+	}
+
+	socket = (async_udp_socket *) Z_OBJ_P(getThis());
+	
+	await_datagram(socket, size, return_value, execute_data);
+}
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_udp_socket_receive_batch, 0, 0, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, max, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 1)
+ZEND_END_ARG_INFO();
+
+static PHP_METHOD(UdpSocket, receiveBatch)
+{
+	async_udp_socket *socket;
+	
+	zend_long max;
+	zend_long size;
+	zval datagram;
+	
+	max = ASYNC_UDP_BATCH;
+	size = 0;
+
+	ZEND_PARSE_PARAMETERS_START_EX(ZEND_PARSE_PARAMS_THROW, 0, 2)
+		Z_PARAM_OPTIONAL
+		Z_PARAM_LONG(max)
+		Z_PARAM_LONG(size)
+	ZEND_PARSE_PARAMETERS_END();
+	
+	ASYNC_CHECK_ERROR(max < 1, "Batch size must be at least 1");
+	ASYNC_CHECK_ERROR(size < 0, "UDP receive buffer size must not be negative");
+
+	if (size == 0) {
+		size = ASYNC_UDP_RECEIVE_SIZE;
+	}
+
+	socket = (async_udp_socket *) Z_OBJ_P(getThis());
+	
+	if (UNEXPECTED(FAILURE == await_datagram(socket, size, &datagram, execute_data))) {
+		return;
+	}
+	
+	array_init_size(return_value, (uint32_t) MIN(max, ASYNC_UDP_BATCH));
+	
+	zend_hash_next_index_insert(Z_ARRVAL_P(return_value), &datagram);
+	
+#ifndef PHP_WIN32
+	// Datagrams that are already queued are returned without suspending the calling task again.
+	if (max > 1) {
+		receive_queued_datagrams(socket, (size_t) size, max, Z_ARRVAL_P(return_value));
+	}
+#endif
 }
 
 ASYNC_CALLBACK socket_sent(uv_udp_send_t *req, int status)
@@ -712,19 +914,17 @@ static PHP_METHOD(UdpSocket, send)
 		return;
 	}
 	
-	val = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address));
-
 	if (socket->flags & ASYNC_UDP_FLAG_CONNECTED) {
-		ASYNC_CHECK_EXCEPTION(Z_TYPE_P(val) != IS_NULL, async_socket_exception_ce, "Connected UDP socket cannot send to a different address");
+		ASYNC_CHECK_EXCEPTION(datagram->peer.ss_family != AF_UNSPEC, async_socket_exception_ce, "Connected UDP socket cannot send to a different address");
 
 		dest = NULL;
 	} else {
-		ASYNC_CHECK_EXCEPTION(Z_TYPE_P(val) == IS_NULL, async_socket_exception_ce, "Unconnected UDP socket requires a target address");
+		ASYNC_CHECK_EXCEPTION(datagram->peer.ss_family == AF_UNSPEC, async_socket_exception_ce, "Unconnected UDP socket requires a target address");
 
 		dest = &datagram->peer;
 	}
 
-	data = Z_STR_P(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data)));
+	data = Z_STR_P(OBJ_PROP(&datagram->std, off_datagram_data));
 	buffers[0] = uv_buf_init(ZSTR_VAL(data), (unsigned int) ZSTR_LEN(data));
 	
 	if (socket->senders.first == NULL) {
@@ -793,6 +993,7 @@ static const zend_function_entry async_udp_socket_functions[] = {
 	PHP_ME(UdpSocket, getPort, arginfo_socket_get_port, ZEND_ACC_PUBLIC)
 	PHP_ME(UdpSocket, setOption, arginfo_socket_set_option, ZEND_ACC_PUBLIC)
 	PHP_ME(UdpSocket, receive, arginfo_udp_socket_receive, ZEND_ACC_PUBLIC)
+	PHP_ME(UdpSocket, receiveBatch, arginfo_udp_socket_receive_batch, ZEND_ACC_PUBLIC)
 	PHP_ME(UdpSocket, send, arginfo_udp_socket_send, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
@@ -821,6 +1022,35 @@ static void async_udp_datagram_object_destroy(zend_object *object)
 	zend_object_std_dtor(&datagram->std);
 }
 
+/* Property handlers do not pass cache slots, cached offsets would bypass peer address resolution. */
+static int datagram_has_prop(zval *object, zval *member, int has_set_exists, void **cache_slot)
+{
+	resolve_datagram_peer(async_udp_datagram_obj(Z_OBJ_P(object)));
+	
+	return std_object_handlers.has_property(object, member, has_set_exists, NULL);
+}
+
+static zval *datagram_read_prop(zval *object, zval *member, int type, void **cache_slot, zval *rv)
+{
+	resolve_datagram_peer(async_udp_datagram_obj(Z_OBJ_P(object)));
+	
+	return std_object_handlers.read_property(object, member, type, NULL, rv);
+}
+
+static zval *datagram_get_prop_ptr(zval *object, zval *member, int type, void **cache_slot)
+{
+	resolve_datagram_peer(async_udp_datagram_obj(Z_OBJ_P(object)));
+	
+	return std_object_handlers.get_property_ptr_ptr(object, member, type, NULL);
+}
+
+static HashTable *datagram_get_props(zval *object)
+{
+	resolve_datagram_peer(async_udp_datagram_obj(Z_OBJ_P(object)));
+	
+	return std_object_handlers.get_properties(object);
+}
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_udp_datagram_ctor, 0, 0, 1)
 	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
 	ZEND_ARG_TYPE_INFO(0, address, IS_STRING, 1)
@@ -851,8 +1081,8 @@ static PHP_METHOD(UdpDatagram, __construct)
 	datagram = async_udp_datagram_obj(Z_OBJ_P(getThis()));
 	
 	if (host == NULL || Z_TYPE_P(host) == IS_NULL) {
-		ZVAL_NULL(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address)));
-		ZVAL_NULL(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_port)));
+		ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_address));
+		ZVAL_NULL(OBJ_PROP(&datagram->std, off_datagram_port));
 	} else {
 		if (UNEXPECTED(0 != async_dns_lookup_ip(Z_STRVAL_P(host), &datagram->peer, IPPROTO_UDP))) {
 			zend_throw_error(NULL, "Failed to assemble peer IP address");
@@ -862,11 +1092,11 @@ static PHP_METHOD(UdpDatagram, __construct)
 		async_socket_set_port((struct sockaddr *) &datagram->peer, port);
 		async_socket_get_peer((const struct sockaddr *) &datagram->peer, &ip, &p);
 
-		ZVAL_STR(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address)), ip);
-		ZVAL_LONG(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_port)), p);
+		ZVAL_STR(OBJ_PROP(&datagram->std, off_datagram_address), ip);
+		ZVAL_LONG(OBJ_PROP(&datagram->std, off_datagram_port), p);
 	}
 	
-	ZVAL_STR_COPY(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data)), data);
+	ZVAL_STR_COPY(OBJ_PROP(&datagram->std, off_datagram_data), data);
 }
 
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_udp_datagram_with_data, 0, 1, Concurrent\\Network\\UdpDatagram, 0)
@@ -889,14 +1119,17 @@ static PHP_METHOD(UdpDatagram, withData)
 	result = async_udp_datagram_obj(async_udp_datagram_object_create(async_udp_datagram_ce));
 	
 	result->peer = datagram->peer;
+	result->flags = datagram->flags;
 	
-	ZVAL_STR_COPY(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_data)), data);
+	ZVAL_STR_COPY(OBJ_PROP(&result->std, off_datagram_data), data);
 
-	tmp = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address));
-	ZVAL_COPY(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_address)), tmp);
+	if (!(datagram->flags & ASYNC_UDP_DATAGRAM_FLAG_LAZY_PEER)) {
+		tmp = OBJ_PROP(&datagram->std, off_datagram_address);
+		ZVAL_COPY(OBJ_PROP(&result->std, off_datagram_address), tmp);
 
-	tmp = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_port));
-	ZVAL_COPY(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_port)), tmp);
+		tmp = OBJ_PROP(&datagram->std, off_datagram_port);
+		ZVAL_COPY(OBJ_PROP(&result->std, off_datagram_port), tmp);
+	}
 
 	RETURN_OBJ(&result->std);
 }
@@ -936,11 +1169,11 @@ static PHP_METHOD(UdpDatagram, withPeer)
 	async_socket_set_port((struct sockaddr *) &result->peer, port);
 	async_socket_get_peer((const struct sockaddr *) &result->peer, &ip, &p);
 
-	tmp = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data));
-	ZVAL_COPY(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_data)), tmp);
+	tmp = OBJ_PROP(&datagram->std, off_datagram_data);
+	ZVAL_COPY(OBJ_PROP(&result->std, off_datagram_data), tmp);
 
-	ZVAL_STR(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_address)), ip);
-	ZVAL_LONG(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_port)), p);
+	ZVAL_STR(OBJ_PROP(&result->std, off_datagram_address), ip);
+	ZVAL_LONG(OBJ_PROP(&result->std, off_datagram_port), p);
 	
 	RETURN_OBJ(&result->std);
 }
@@ -960,11 +1193,11 @@ static PHP_METHOD(UdpDatagram, withoutPeer)
 	datagram = async_udp_datagram_obj(Z_OBJ_P(getThis()));
 	result = async_udp_datagram_obj(async_udp_datagram_object_create(async_udp_datagram_ce));
 
-	tmp = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data));
-	ZVAL_COPY(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_data)), tmp);
+	tmp = OBJ_PROP(&datagram->std, off_datagram_data);
+	ZVAL_COPY(OBJ_PROP(&result->std, off_datagram_data), tmp);
 
-	ZVAL_NULL(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_address)));
-	ZVAL_NULL(OBJ_PROP(&result->std, async_udp_datagram_prop_offset(str_port)));
+	ZVAL_NULL(OBJ_PROP(&result->std, off_datagram_address));
+	ZVAL_NULL(OBJ_PROP(&result->std, off_datagram_port));
 
 	RETURN_OBJ(&result->std);
 }
@@ -1053,19 +1286,17 @@ static void intercept_send(async_context *context, zend_object *obj, INTERNAL_FU
 		return;
 	}
 
-	val = OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_address));
-
 	if (socket->flags & ASYNC_UDP_FLAG_CONNECTED) {
-		ASYNC_CHECK_EXCEPTION(Z_TYPE_P(val) != IS_NULL, async_socket_exception_ce, "Connected UDP socket cannot send to a different address");
+		ASYNC_CHECK_EXCEPTION(datagram->peer.ss_family != AF_UNSPEC, async_socket_exception_ce, "Connected UDP socket cannot send to a different address");
 
 		dest = NULL;
 	} else {
-		ASYNC_CHECK_EXCEPTION(Z_TYPE_P(val) == IS_NULL, async_socket_exception_ce, "Unconnected UDP socket requires a target address");
+		ASYNC_CHECK_EXCEPTION(datagram->peer.ss_family == AF_UNSPEC, async_socket_exception_ce, "Unconnected UDP socket requires a target address");
 
 		dest = &datagram->peer;
 	}
 
-	data = Z_STR_P(OBJ_PROP(&datagram->std, async_udp_datagram_prop_offset(str_data)));
+	data = Z_STR_P(OBJ_PROP(&datagram->std, off_datagram_data));
 	buffers[0] = uv_buf_init(ZSTR_VAL(data), (unsigned int) ZSTR_LEN(data));
 
 	if (socket->senders.first == NULL) {
@@ -1162,7 +1393,11 @@ void async_udp_socket_ce_register()
 	async_udp_datagram_handlers.offset = XtOffsetOf(async_udp_datagram, std);
 	async_udp_datagram_handlers.free_obj = async_udp_datagram_object_destroy;
 	async_udp_datagram_handlers.clone_obj = NULL;
+	async_udp_datagram_handlers.has_property = datagram_has_prop;
+	async_udp_datagram_handlers.read_property = datagram_read_prop;
 	async_udp_datagram_handlers.write_property = async_prop_write_handler_readonly;
+	async_udp_datagram_handlers.get_property_ptr_ptr = datagram_get_prop_ptr;
+	async_udp_datagram_handlers.get_properties = datagram_get_props;
 
 #if PHP_VERSION_ID < 70400
 	zend_declare_property_null(async_udp_datagram_ce, ZEND_STRL("data"), ZEND_ACC_PUBLIC);
@@ -1178,6 +1413,10 @@ void async_udp_socket_ce_register()
 	zend_declare_typed_property(async_udp_datagram_ce, str_port, &tmp, ZEND_ACC_PUBLIC, NULL, ZEND_TYPE_ENCODE(IS_LONG, 1));
 #endif
 
+	off_datagram_data = async_udp_datagram_prop_offset(str_data);
+	off_datagram_address = async_udp_datagram_prop_offset(str_address);
+	off_datagram_port = async_udp_datagram_prop_offset(str_port);
+
 	if (NULL != (func = (zend_function *) zend_hash_str_find_ptr(&async_udp_socket_ce->function_table, ZEND_STRL("send")))) {
 		async_register_interceptor(func, intercept_send);
 	}
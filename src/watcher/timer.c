@@ -18,6 +18,8 @@
 
 #include "php_async.h"
 
+#include "async/wheel.h"
+
 ASYNC_API zend_class_entry *async_timeout_ce;
 ASYNC_API zend_class_entry *async_timeout_exception_ce;
 ASYNC_API zend_class_entry *async_timer_ce;
@@ -30,6 +32,12 @@ static async_await_handler timeout_await_handler;
 static zend_function *orig_sleep;
 static zif_handler orig_sleep_handler;
 
+static zend_function *orig_usleep;
+static zif_handler orig_usleep_handler;
+
+static zend_function *orig_nanosleep;
+static zif_handler orig_nanosleep_handler;
+
 typedef struct _async_timer {
 	/* PHP object handle. */
 	zend_object std;
@@ -40,15 +48,12 @@ typedef struct _async_timer {
 	/* Timer interval in milliseconds. */
 	uint64_t delay;
 
-	/* UV timer handle. */
-	uv_timer_t handle;
+	/* Timer being linked into the timer wheel of the scheduler. */
+	async_wheel_timer entry;
 
 	/* Queued timeout continuations. */
 	async_op_list timeouts;
 
-	/* Number of pending referenced timeout subscriptions. */
-	zend_uchar ref_count;
-
 	async_task_scheduler *scheduler;
 
 	async_cancel_cb cancel;
@@ -57,8 +62,7 @@ typedef struct _async_timer {
 typedef struct _async_timeout {
 	zend_object std;
 
-	uv_timer_t handle;
-	zend_uchar ref_count;
+	async_wheel_timer timer;
 	zval error;
 
 	async_task_scheduler *scheduler;
@@ -68,17 +72,22 @@ typedef struct _async_timeout {
 	async_op_list operations;
 } async_timeout;
 
+typedef struct _async_sleep_op {
+	async_op base;
+	async_wheel_timer timer;
+} async_sleep_op;
+
 static async_timeout *async_timeout_object_create(uint64_t delay);
 
 
-ASYNC_CALLBACK trigger_timer(uv_timer_t *handle)
+ASYNC_CALLBACK trigger_timer(async_wheel_timer *entry)
 {
 	async_timer *timer;
 	async_op *op;
 	async_op *last;
 	zend_bool cont;
 
-	timer = (async_timer *) handle->data;
+	timer = (async_timer *) entry->data;
 
 	ZEND_ASSERT(timer != NULL);
 	
@@ -95,24 +104,12 @@ ASYNC_CALLBACK trigger_timer(uv_timer_t *handle)
 		}
 	}
 	
-	if (timer->timeouts.first == NULL) {
-		if (!uv_is_closing((uv_handle_t *) handle)) {
-			uv_timer_stop(handle);
-		}
+	// Tasks that started awaiting the timer while it was being triggered are continued by the next timeout.
+	if (timer->timeouts.first != NULL) {
+		async_timer_wheel_start(&timer->scheduler->timers, &timer->entry, timer->delay);
 	}
 }
 
-ASYNC_CALLBACK close_timer(uv_handle_t *handle)
-{
-	async_timer *timer;
-
-	timer = (async_timer *) handle->data;
-
-	ZEND_ASSERT(timer != NULL);
-
-	ASYNC_DELREF(&timer->std);
-}
-
 ASYNC_CALLBACK shutdown_timer(void *obj, zval *error)
 {
 	async_timer *timer;
@@ -128,7 +125,7 @@ ASYNC_CALLBACK shutdown_timer(void *obj, zval *error)
 		ZVAL_COPY(&timer->error, error);
 	}
 
-	ASYNC_UV_TRY_CLOSE_REF(&timer->std, &timer->handle, close_timer);
+	async_timer_wheel_stop(&timer->scheduler->timers, &timer->entry);
 	
 	if (error != NULL) {
 		while (timer->timeouts.first != NULL) {
@@ -152,10 +149,8 @@ static zend_object *async_timer_object_create(zend_class_entry *ce)
 	
 	timer->scheduler = async_task_scheduler_ref();
 
-	uv_timer_init(&timer->scheduler->loop, &timer->handle);
-	uv_unref((uv_handle_t *) &timer->handle);
-
-	timer->handle.data = timer;
+	timer->entry.func = trigger_timer;
+	timer->entry.data = timer;
 
 	timer->cancel.object = timer;
 	timer->cancel.func = shutdown_timer;
@@ -271,8 +266,8 @@ PHP_METHOD(Timer, awaitTimeout)
 		return;
 	}
 	
-	if (timer->timeouts.first == NULL && !uv_is_active((uv_handle_t *) &timer->handle)) {
-		uv_timer_start(&timer->handle, trigger_timer, timer->delay, timer->delay);
+	if (!async_wheel_timer_is_active(&timer->entry)) {
+		async_timer_wheel_start(&timer->scheduler->timers, &timer->entry, timer->delay);
 	}
 	
 	context = async_context_get();
@@ -280,13 +275,18 @@ PHP_METHOD(Timer, awaitTimeout)
 	ASYNC_ALLOC_OP(op);
 	ASYNC_APPEND_OP(&timer->timeouts, op);
 
-	ASYNC_UNREF_ENTER(context, timer);
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_ENTER(timer->scheduler);
+	}
 
 	if (UNEXPECTED(async_await_op(op) == FAILURE)) {
 		ASYNC_FORWARD_OP_ERROR(op);
 	}
 
-	ASYNC_UNREF_EXIT(context, timer);
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_EXIT(timer->scheduler);
+	}
+
 	ASYNC_FREE_OP(op);
 }
 
@@ -349,17 +349,6 @@ static void timeout_await_schedule(zend_object *obj, async_op *op, async_task *c
 	ASYNC_APPEND_OP(&timeout->operations, op);
 }
 
-ASYNC_CALLBACK close_timeout(uv_handle_t *handle)
-{
-	async_timeout *timeout;
-
-	timeout = (async_timeout *) handle->data;
-
-	ZEND_ASSERT(timeout != NULL);
-
-	ASYNC_DELREF(&timeout->std);
-}
-
 ASYNC_CALLBACK shutdown_timeout(void *obj, zval *error)
 {
 	async_timeout *timeout;
@@ -375,7 +364,7 @@ ASYNC_CALLBACK shutdown_timeout(void *obj, zval *error)
 		ZVAL_COPY(&timeout->error, error);
 	}
 
-	ASYNC_UV_TRY_CLOSE_REF(&timeout->std, &timeout->handle, close_timeout);
+	async_timer_wheel_stop(&timeout->scheduler->timers, &timeout->timer);
 
 	if (error != NULL) {
 		while (timeout->operations.first != NULL) {
@@ -385,12 +374,12 @@ ASYNC_CALLBACK shutdown_timeout(void *obj, zval *error)
 	}
 }
 
-ASYNC_CALLBACK timeout_expired(uv_timer_t *handle)
+ASYNC_CALLBACK timeout_expired(async_wheel_timer *timer)
 {
 	async_timeout *timeout;
 	zval error;
 
-	timeout = (async_timeout *) handle->data;
+	timeout = (async_timeout *) timer->data;
 
 	ZEND_ASSERT(timeout != NULL);
 
@@ -417,11 +406,10 @@ static async_timeout *async_timeout_object_create(uint64_t delay)
 
 	timeout->scheduler = async_task_scheduler_ref();
 
-	uv_timer_init(&timeout->scheduler->loop, &timeout->handle);
-	uv_unref((uv_handle_t *) &timeout->handle);
-	uv_timer_start(&timeout->handle, timeout_expired, delay, 0);
+	timeout->timer.func = timeout_expired;
+	timeout->timer.data = timeout;
 
-	timeout->handle.data = timeout;
+	async_timer_wheel_start(&timeout->scheduler->timers, &timeout->timer, delay);
 
 	timeout->cancel.object = timeout;
 	timeout->cancel.func = shutdown_timeout;
@@ -462,7 +450,7 @@ static const zend_function_entry async_timeout_functions[] = {
 };
 
 
-ASYNC_CALLBACK sleep_cb(uv_timer_t *timer)
+ASYNC_CALLBACK sleep_cb(async_wheel_timer *timer)
 {
 	async_op *op;
 
@@ -473,26 +461,51 @@ ASYNC_CALLBACK sleep_cb(uv_timer_t *timer)
 	ASYNC_FINISH_OP(op);
 }
 
-ASYNC_CALLBACK sleep_free_cb(uv_handle_t *handle)
+static int await_sleep(uint64_t delay)
 {
 	async_task_scheduler *scheduler;
+	async_context *context;
+	async_sleep_op *op;
 	
-	scheduler = (async_task_scheduler *) handle->data;
+	int code;
+
+	scheduler = async_task_scheduler_ref();
+	context = async_context_get();
+
+	ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_sleep_op));
+	ASYNC_APPEND_OP(&scheduler->operations, op);
+
+	op->timer.func = sleep_cb;
+	op->timer.data = op;
+
+	async_timer_wheel_start(&scheduler->timers, &op->timer, delay);
+
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_ENTER(scheduler);
+	}
 	
-	ZEND_ASSERT(scheduler != NULL);
+	code = async_await_op((async_op *) op);
+	
+	if (UNEXPECTED(code == FAILURE)) {
+		ASYNC_FORWARD_OP_ERROR(op);
+	}
+
+	if (!async_context_is_background(context)) {
+		ASYNC_BUSY_EXIT(scheduler);
+	}
+	
+	async_timer_wheel_stop(&scheduler->timers, &op->timer);
+
+	ASYNC_FREE_OP(op);
 	
 	async_task_scheduler_unref(scheduler);
 	
-	efree(handle);
+	return code;
 }
 
 static PHP_FUNCTION(asyncsleep)
 {
-	async_task_scheduler *scheduler;
-	async_op *op;
 	zend_long num;
-
-	uv_timer_t *timer;
 	
 #ifndef PHP_WIN32
 	time_t started;
@@ -509,30 +522,7 @@ static PHP_FUNCTION(asyncsleep)
 		RETURN_FALSE;
 	}
 
-	scheduler = async_task_scheduler_ref();
-
-	ASYNC_ALLOC_CUSTOM_OP(op, sizeof(async_op));
-	ASYNC_APPEND_OP(&scheduler->operations, op);
-
-	timer = emalloc(sizeof(uv_timer_t));
-	timer->data = op;
-
-	uv_timer_init(&scheduler->loop, timer);
-	uv_timer_start(timer, sleep_cb, num * 1000, 0);
-
-	if (async_context_is_background(async_context_get())) {
-		uv_unref((uv_handle_t *) timer);
-	}
-	
-	if (UNEXPECTED(async_await_op(op) == FAILURE)) {
-		ASYNC_FORWARD_OP_ERROR(op);
-	}
-
-	ASYNC_FREE_OP(op);
-	
-	timer->data = scheduler;
-
-	ASYNC_UV_CLOSE(timer, sleep_free_cb);
+	await_sleep((uint64_t) num * 1000);
 
 #ifdef PHP_SLEEP_NON_VOID
 	if (UNEXPECTED(EG(exception))) {
@@ -547,6 +537,72 @@ static PHP_FUNCTION(asyncsleep)
 #endif
 }
 
+static PHP_FUNCTION(asyncusleep)
+{
+	zend_long num;
+
+	ZEND_PARSE_PARAMETERS_START(1, 1)
+		Z_PARAM_LONG(num)
+	ZEND_PARSE_PARAMETERS_END();
+
+	if (UNEXPECTED(num < 0)) {
+		php_error_docref(NULL, E_WARNING, "Number of microseconds must be greater than or equal to 0");
+		RETURN_FALSE;
+	}
+
+	// Delays are rounded up to full milliseconds, an interrupted sleep returns early like usleep() interrupted by a signal.
+	if (UNEXPECTED(await_sleep(((uint64_t) num + 999) / 1000) == FAILURE)) {
+		zend_clear_exception();
+	}
+}
+
+static PHP_FUNCTION(asyncnanosleep)
+{
+	zend_long sec;
+	zend_long nsec;
+
+	uint64_t delay;
+	uint64_t started;
+	uint64_t elapsed;
+
+	ZEND_PARSE_PARAMETERS_START(2, 2)
+		Z_PARAM_LONG(sec)
+		Z_PARAM_LONG(nsec)
+	ZEND_PARSE_PARAMETERS_END_EX(RETURN_FALSE);
+
+	if (UNEXPECTED(sec < 0)) {
+		php_error_docref(NULL, E_WARNING, "The seconds value must be greater than 0");
+		RETURN_FALSE;
+	}
+
+	if (UNEXPECTED(nsec < 0)) {
+		php_error_docref(NULL, E_WARNING, "The nanoseconds value must be greater than 0");
+		RETURN_FALSE;
+	}
+
+	if (UNEXPECTED(nsec > 999999999)) {
+		php_error_docref(NULL, E_WARNING, "nanoseconds was not in the range 0 to 999 999 999 or seconds was negative");
+		RETURN_FALSE;
+	}
+
+	delay = (uint64_t) sec * 1000000000 + (uint64_t) nsec;
+	started = uv_hrtime();
+
+	if (EXPECTED(await_sleep((delay + 999999) / 1000000) == SUCCESS)) {
+		RETURN_TRUE;
+	}
+
+	// Report the remaining time like an interrupted nanosleep() call.
+	zend_clear_exception();
+
+	elapsed = uv_hrtime() - started;
+	delay = (elapsed < delay) ? (delay - elapsed) : 0;
+
+	array_init(return_value);
+	add_assoc_long_ex(return_value, ZEND_STRL("seconds"), (zend_long) (delay / 1000000000));
+	add_assoc_long_ex(return_value, ZEND_STRL("nanoseconds"), (zend_long) (delay % 1000000000));
+}
+
 
 static const zend_function_entry empty_funcs[] = {
 	PHP_FE_END
@@ -596,9 +652,31 @@ void async_timer_init()
 	orig_sleep_handler = orig_sleep->internal_function.handler;
 
 	orig_sleep->internal_function.handler = PHP_FN(asyncsleep);
+
+	orig_usleep = (zend_function *) zend_hash_str_find_ptr(EG(function_table), ZEND_STRL("usleep"));
+
+	if (orig_usleep != NULL) {
+		orig_usleep_handler = orig_usleep->internal_function.handler;
+		orig_usleep->internal_function.handler = PHP_FN(asyncusleep);
+	}
+
+	orig_nanosleep = (zend_function *) zend_hash_str_find_ptr(EG(function_table), ZEND_STRL("time_nanosleep"));
+
+	if (orig_nanosleep != NULL) {
+		orig_nanosleep_handler = orig_nanosleep->internal_function.handler;
+		orig_nanosleep->internal_function.handler = PHP_FN(asyncnanosleep);
+	}
 }
 
 void async_timer_shutdown()
 {
 	orig_sleep->internal_function.handler = orig_sleep_handler;
+
+	if (orig_usleep != NULL) {
+		orig_usleep->internal_function.handler = orig_usleep_handler;
+	}
+
+	if (orig_nanosleep != NULL) {
+		orig_nanosleep->internal_function.handler = orig_nanosleep_handler;
+	}
 }
@@ -0,0 +1,303 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) Martin Schröder 2019                                   |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  | Authors: Martin Schröder <m.schroeder2007@gmail.com>                 |
+  +----------------------------------------------------------------------+
+*/
+
+#include "php_async.h"
+
+#include "async/wheel.h"
+
+#define ASYNC_TIMER_WHEEL_MASK (ASYNC_TIMER_WHEEL_SLOTS - 1)
+#define ASYNC_TIMER_WHEEL_SHIFT(level) ((level) * ASYNC_TIMER_WHEEL_BITS)
+#define ASYNC_TIMER_WHEEL_SPAN ((uint64_t) 1 << ASYNC_TIMER_WHEEL_SHIFT(ASYNC_TIMER_WHEEL_LEVELS))
+
+static zend_always_inline uint64_t current_tick(async_timer_wheel *wheel)
+{
+	return uv_now(wheel->handle.loop) / wheel->granularity;
+}
+
+/* Links the timer into the slot covering its expiration tick, returns the tick when the slot will be processed. */
+static uint64_t link_timer(async_timer_wheel *wheel, async_wheel_timer *timer)
+{
+	uint64_t expires;
+	uint64_t delta;
+	int level;
+
+	expires = timer->expires;
+	delta = expires - wheel->now;
+
+	// Timers beyond the range of the wheel are parked in the top level and relinked when their slot is cascaded.
+	if (UNEXPECTED(delta >= ASYNC_TIMER_WHEEL_SPAN)) {
+		delta = ASYNC_TIMER_WHEEL_SPAN - 1;
+		expires = wheel->now + delta;
+	}
+
+	for (level = 0; level < ASYNC_TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < ((uint64_t) 1 << ASYNC_TIMER_WHEEL_SHIFT(level + 1))) {
+			break;
+		}
+	}
+
+	timer->level = (uint8_t) level;
+	timer->list = &wheel->slots[level][(expires >> ASYNC_TIMER_WHEEL_SHIFT(level)) & ASYNC_TIMER_WHEEL_MASK];
+
+	ASYNC_LIST_APPEND(timer->list, timer);
+
+	wheel->counts[level]++;
+
+	return (expires >> ASYNC_TIMER_WHEEL_SHIFT(level)) << ASYNC_TIMER_WHEEL_SHIFT(level);
+}
+
+/* Computes the next tick that has a slot to be expired (level 0) or cascaded (upper levels). */
+static uint64_t next_tick(async_timer_wheel *wheel)
+{
+	uint64_t tick;
+	uint64_t result;
+	uint32_t index;
+	uint32_t i;
+	int level;
+
+	result = UINT64_MAX;
+
+	for (level = 0; level < ASYNC_TIMER_WHEEL_LEVELS; level++) {
+		if (wheel->counts[level] == 0) {
+			continue;
+		}
+
+		index = (uint32_t) (wheel->now >> ASYNC_TIMER_WHEEL_SHIFT(level));
+
+		for (i = 1; i < ASYNC_TIMER_WHEEL_SLOTS; i++) {
+			if (wheel->slots[level][(index + i) & ASYNC_TIMER_WHEEL_MASK].first != NULL) {
+				break;
+			}
+		}
+
+		tick = ((wheel->now >> ASYNC_TIMER_WHEEL_SHIFT(level)) + i) << ASYNC_TIMER_WHEEL_SHIFT(level);
+
+		if (tick < result) {
+			result = tick;
+		}
+	}
+
+	return result;
+}
+
+static void cascade_slot(async_timer_wheel *wheel, int level)
+{
+	async_wheel_timer_list *slot;
+	async_wheel_timer *timer;
+
+	slot = &wheel->slots[level][(wheel->now >> ASYNC_TIMER_WHEEL_SHIFT(level)) & ASYNC_TIMER_WHEEL_MASK];
+
+	while (slot->first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(slot, timer);
+
+		wheel->counts[level]--;
+		wheel->cascaded++;
+
+		link_timer(wheel, timer);
+	}
+}
+
+/* Invokes the callbacks of all timers in the list, timers being (re)started by a callback are linked into a new slot. */
+static void expire_timers(async_timer_wheel *wheel, async_wheel_timer_list *list)
+{
+	async_wheel_timer_list expired;
+	async_wheel_timer *timer;
+
+	expired = *list;
+
+	list->first = NULL;
+	list->last = NULL;
+
+	for (timer = expired.first; timer != NULL; timer = timer->next) {
+		timer->list = &expired;
+	}
+
+	while (expired.first != NULL) {
+		ASYNC_LIST_EXTRACT_FIRST(&expired, timer);
+
+		timer->list = NULL;
+
+		wheel->expired++;
+
+		timer->func(timer);
+	}
+}
+
+/* Moves the wheel forward to the given tick, expires all timers and cascades upper level slots along the way. */
+static void advance_wheel(async_timer_wheel *wheel, uint64_t target)
+{
+	async_wheel_timer_list *slot;
+	async_wheel_timer *timer;
+	int level;
+
+	while (wheel->now < target) {
+		if (wheel->count == 0) {
+			wheel->now = target;
+			break;
+		}
+
+		// Nothing can expire before the next cascade if the lower levels are empty.
+		for (level = 0; level < ASYNC_TIMER_WHEEL_LEVELS - 1 && wheel->counts[level] == 0; level++);
+
+		if (level > 0) {
+			wheel->now = MIN(target - 1, wheel->now | (((uint64_t) 1 << ASYNC_TIMER_WHEEL_SHIFT(level)) - 1));
+		}
+
+		wheel->now++;
+
+		for (level = 1; level < ASYNC_TIMER_WHEEL_LEVELS; level++) {
+			if (wheel->now & (((uint64_t) 1 << ASYNC_TIMER_WHEEL_SHIFT(level)) - 1)) {
+				break;
+			}
+		}
+
+		while (--level > 0) {
+			cascade_slot(wheel, level);
+		}
+
+		slot = &wheel->slots[0][wheel->now & ASYNC_TIMER_WHEEL_MASK];
+
+		if (slot->first == NULL) {
+			continue;
+		}
+
+		for (timer = slot->first; timer != NULL; timer = timer->next) {
+			ZEND_ASSERT(timer->expires <= wheel->now);
+
+			timer->level = ASYNC_TIMER_WHEEL_LEVELS;
+
+			wheel->counts[0]--;
+			wheel->count--;
+		}
+
+		expire_timers(wheel, slot);
+	}
+}
+
+static void arm_wheel(async_timer_wheel *wheel, uint64_t tick);
+
+ASYNC_CALLBACK process_wheel(uv_timer_t *handle)
+{
+	async_timer_wheel *wheel;
+
+	wheel = (async_timer_wheel *) handle->data;
+
+	ZEND_ASSERT(wheel != NULL);
+
+	// Zero delay timers started by callbacks must not be run before the next loop iteration.
+	if (wheel->due.first != NULL) {
+		expire_timers(wheel, &wheel->due);
+	}
+
+	advance_wheel(wheel, current_tick(wheel));
+
+	if (wheel->due.first != NULL) {
+		arm_wheel(wheel, wheel->now);
+	} else if (wheel->count > 0) {
+		arm_wheel(wheel, next_tick(wheel));
+	}
+}
+
+static void arm_wheel(async_timer_wheel *wheel, uint64_t tick)
+{
+	uint64_t now;
+	uint64_t due;
+
+	now = uv_now(wheel->handle.loop);
+	due = tick * wheel->granularity;
+
+	wheel->wake = tick;
+
+	uv_timer_start(&wheel->handle, process_wheel, (due > now) ? (due - now) : 0, 0);
+}
+
+void async_timer_wheel_init(async_timer_wheel *wheel, uv_loop_t *loop, uint64_t granularity)
+{
+	uv_timer_init(loop, &wheel->handle);
+	uv_unref((uv_handle_t *) &wheel->handle);
+
+	wheel->handle.data = wheel;
+	wheel->granularity = MAX(1, granularity);
+	wheel->now = current_tick(wheel);
+}
+
+void async_timer_wheel_close(async_timer_wheel *wheel)
+{
+	ASYNC_UV_CLOSE(&wheel->handle, NULL);
+}
+
+void async_timer_wheel_start(async_timer_wheel *wheel, async_wheel_timer *timer, uint64_t delay)
+{
+	uint64_t tick;
+
+	if (timer->list != NULL) {
+		async_timer_wheel_stop(wheel, timer);
+	}
+
+	// An empty wheel can jump to the current tick without processing any slots.
+	if (wheel->count == 0) {
+		wheel->now = MAX(wheel->now, current_tick(wheel));
+	}
+
+	if (delay == 0) {
+		timer->level = ASYNC_TIMER_WHEEL_LEVELS;
+		timer->list = &wheel->due;
+
+		ASYNC_LIST_APPEND(&wheel->due, timer);
+
+		if (!uv_is_active((uv_handle_t *) &wheel->handle) || wheel->wake > wheel->now) {
+			arm_wheel(wheel, wheel->now);
+		}
+
+		return;
+	}
+
+	timer->expires = (uv_now(wheel->handle.loop) + delay + wheel->granularity - 1) / wheel->granularity;
+
+	if (timer->expires <= wheel->now) {
+		timer->expires = wheel->now + 1;
+	}
+
+	tick = link_timer(wheel, timer);
+
+	wheel->count++;
+
+	if (!uv_is_active((uv_handle_t *) &wheel->handle) || tick < wheel->wake) {
+		arm_wheel(wheel, tick);
+	}
+}
+
+void async_timer_wheel_stop(async_timer_wheel *wheel, async_wheel_timer *timer)
+{
+	if (timer->list == NULL) {
+		return;
+	}
+
+	ASYNC_LIST_REMOVE(timer->list, timer);
+
+	timer->list = NULL;
+
+	if (timer->level < ASYNC_TIMER_WHEEL_LEVELS) {
+		wheel->counts[timer->level]--;
+		wheel->count--;
+	}
+
+	if (wheel->count == 0 && wheel->due.first == NULL) {
+		uv_timer_stop(&wheel->handle);
+	}
+}
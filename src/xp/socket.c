@@ -506,21 +506,6 @@ static int async_xp_socket_xport_api(php_stream *stream, async_xp_socket_data *d
 
 #ifdef HAVE_ASYNC_SSL
 
-static int cert_passphrase_cb(char *buf, int size, int rwflag, void *obj)
-{
-	zend_string *key;
-	
-	key = (zend_string *) obj;
-	
-	if (key == NULL) {
-		return 0;
-	}
-	
-	strncpy(buf, ZSTR_VAL(key), ZSTR_LEN(key));
-	
-	return (int) ZSTR_LEN(key);
-}
-
 static char *cipher_get_version(const SSL_CIPHER *c, char *buffer, size_t max_len)
 {
 	const char *version;
@@ -542,6 +527,7 @@ static char *cipher_get_version(const SSL_CIPHER *c, char *buffer, size_t max_le
 static int setup_ssl(php_stream *stream, async_xp_socket_data *data, php_stream_xport_crypto_param *cparam)
 {	
 	zval *val;
+	zend_string *alpn;
 	
 	char *cafile;
 	char *capath;
@@ -562,10 +548,6 @@ static int setup_ssl(php_stream *stream, async_xp_socket_data *data, php_stream_
 	ASYNC_XP_SOCKET_SSL_OPT_STRING(stream, "cafile", cafile);
 	ASYNC_XP_SOCKET_SSL_OPT_STRING(stream, "capath", capath);
 	
-	data->astream->ssl.ctx = async_ssl_create_context(options, cafile, capath);
-	
-	SSL_CTX_set_default_passwd_cb(data->astream->ssl.ctx, cert_passphrase_cb);
-	
 	data->astream->ssl.settings.verify_depth = ASYNC_SSL_DEFAULT_VERIFY_DEPTH;
 	
 	if (ASYNC_XP_SOCKET_SSL_OPT(stream, "peer_name", val)) {
@@ -590,11 +572,19 @@ static int setup_ssl(php_stream *stream, async_xp_socket_data *data, php_stream_
 	
 	// TODO: Implement client cert authentication...
 	
+	alpn = NULL;
+	
 #ifdef ASYNC_TLS_ALPN
 	if (ASYNC_XP_SOCKET_SSL_OPT(stream, "alpn_protocols", val)) {
-		async_ssl_setup_client_alpn(data->astream->ssl.ctx, create_alpn_proto_list(Z_STR_P(val)), 1);
+		alpn = create_alpn_proto_list(Z_STR_P(val));
 	}
 #endif
+
+	data->astream->ssl.ctx = async_ssl_get_client_context(data->scheduler, options, cafile, capath, &data->astream->ssl.settings, alpn);
+	
+	if (alpn != NULL) {
+		zend_string_release(alpn);
+	}
 	
 	return SUCCESS;
 }
@@ -611,13 +601,11 @@ static int toggle_ssl(php_stream *stream, async_xp_socket_data *data, php_stream
 		data->astream->ssl.settings.mode = ASYNC_SSL_MODE_SERVER;
 	} else {
 		data->astream->ssl.settings.mode = ASYNC_SSL_MODE_CLIENT;
-		
-		async_ssl_setup_verify_callback(data->astream->ssl.ctx, &data->astream->ssl.settings);
 	}
 	
 	handshake.settings = &data->astream->ssl.settings;
 	
-	async_ssl_create_buffered_engine(&data->astream->ssl, data->astream->buffer.size);
+	async_ssl_create_buffered_engine(&data->astream->ssl, data->astream->buffer.size, &data->scheduler->buffers);
 	async_ssl_setup_encryption(data->astream->ssl.ssl, handshake.settings);
 	
 	code = async_stream_ssl_handshake(data->astream, &handshake);
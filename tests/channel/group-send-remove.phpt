@@ -0,0 +1,37 @@
+--TEST--
+Channel group send returns the key of a channel that has been removed while the send was pending.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$group = new ChannelGroup([
+    'A' => ($a = new Channel()),
+    'B' => ($b = new Channel())
+]);
+
+Task::async(function () use ($group, $a) {
+    foreach ($a as $v) {
+        var_dump($v);
+        break;
+    }
+    
+    $a->close();
+    
+    try {
+        $group->send('y', 0);
+    } catch (ChannelClosedException $e) {
+        var_dump($e->getMessage());
+    }
+});
+
+var_dump($group->send('x'));
+var_dump(count($group));
+
+--EXPECT--
+string(1) "x"
+string(23) "Channel has been closed"
+string(1) "A"
+int(1)
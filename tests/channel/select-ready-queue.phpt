@@ -0,0 +1,62 @@
+--TEST--
+Channel group select rotates between ready channels.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$a = new Channel(3);
+$b = new Channel(3);
+
+for ($i = 0; $i < 3; $i++) {
+    $a->send('A' . $i);
+    $b->send('B' . $i);
+}
+
+$group = new ChannelGroup(['A' => $a, 'B' => $b]);
+
+while (null !== ($val = $group->select(0))) {
+    var_dump($val->value);
+}
+
+$channels = [];
+
+for ($i = 0; $i < 1000; $i++) {
+    $channels[] = new Channel(1);
+}
+
+$group = new ChannelGroup($channels);
+
+var_dump($group->select(0));
+
+Task::async(function () use ($channels) {
+    for ($i = 0; $i < 1000; $i += 100) {
+        $channels[$i]->send($i);
+    }
+    
+    foreach ($channels as $channel) {
+        $channel->close();
+    }
+});
+
+$sum = 0;
+
+do {
+    if (null !== ($val = $group->select())) {
+        $sum += $val->value;
+    }
+} while (count($group));
+
+var_dump($sum);
+
+--EXPECT--
+string(2) "A0"
+string(2) "B0"
+string(2) "A1"
+string(2) "B1"
+string(2) "A2"
+string(2) "B2"
+NULL
+int(4500)
@@ -0,0 +1,74 @@
+--TEST--
+Channel can send and receive messages in batches.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$channel = new Channel();
+
+Task::async(function () use ($channel) {
+    $channel->sendMany([1, 2, 3, 4, 5]);
+    
+    var_dump('SENT');
+    
+    $channel->close();
+});
+
+do {
+    var_dump(implode(',', $messages = $channel->receiveMany(2)));
+} while ($messages);
+
+$channel = new Channel(3);
+
+Task::async(function () use ($channel) {
+    $channel->sendMany((function () {
+        yield from ['A', 'B', 'C', 'D', 'E'];
+    })());
+    
+    $channel->close();
+});
+
+foreach ($channel as $v) {
+    var_dump($v);
+}
+
+$channel = new Channel(1 << 20);
+$channel->sendMany(range(1, 1000));
+
+var_dump(count($channel->receiveMany(2000)));
+
+$channel->close();
+
+var_dump($channel->receiveMany(1));
+
+try {
+    $channel->sendMany([1]);
+} catch (ChannelClosedException $e) {
+    var_dump($e->getMessage());
+}
+
+try {
+    $channel->receiveMany(0);
+} catch (\Error $e) {
+    var_dump($e->getMessage());
+}
+
+--EXPECT--
+string(3) "1,2"
+string(3) "3,4"
+string(1) "5"
+string(4) "SENT"
+string(0) ""
+string(1) "A"
+string(1) "B"
+string(1) "C"
+string(1) "D"
+string(1) "E"
+int(1000)
+array(0) {
+}
+string(23) "Channel has been closed"
+string(29) "Batch size must be at least 1"
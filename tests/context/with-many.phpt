@@ -0,0 +1,62 @@
+--TEST--
+Context can bind multiple vars at once.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$a = new ContextVar();
+$b = new ContextVar();
+$c = new ContextVar();
+
+$context = Context::current()->with($a, 'A');
+$context = $context->withMany([
+    [$b, 'B'],
+    [$c, 'C'],
+    [$a, 'X']
+]);
+
+var_dump($a->get($context), $b->get($context), $c->get($context));
+
+$derived = $context->withPriority(Task::PRIORITY_HIGH)->shield()->withMany([]);
+
+var_dump($a->get($derived), $b->get($derived), $c->get($derived));
+
+$derived = $derived->with($b, 'Y');
+
+var_dump($b->get($derived), $b->get($context));
+
+$context->run(function () use ($a) {
+    var_dump($a->get());
+});
+
+try {
+    $context->withMany([$a, 'foo']);
+} catch (\Throwable $e) {
+    echo $e->getMessage(), "\n";
+}
+
+try {
+    $context->withMany([['foo', 'bar']]);
+} catch (\Throwable $e) {
+    echo $e->getMessage(), "\n";
+}
+
+var_dump($a->get());
+
+?>
+--EXPECT--
+string(1) "X"
+string(1) "B"
+string(1) "C"
+string(1) "X"
+string(1) "B"
+string(1) "C"
+string(1) "Y"
+string(1) "B"
+string(1) "X"
+Context vars must be bound using [ContextVar, value] pairs
+Context vars must be bound using [ContextVar, value] pairs
+NULL
@@ -0,0 +1,40 @@
+--TEST--
+Process STDIN pipe supports writing multiple chunks at once.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Process;
+
+$builder = new ProcessBuilder(PHP_BINARY);
+$builder = $builder->withStdinPipe();
+$builder = $builder->withStdoutInherited();
+
+$process = $builder->start(__DIR__ . '/assets/stdin-dump.php');
+
+$stdin = $process->getStdin();
+
+try {
+    // Child process does not print anything before it has received the first line.
+    try {
+        $stdin->writeAll(['foo', 123]);
+    } catch (\TypeError $e) {
+        var_dump($e->getMessage());
+    }
+    
+    $stdin->writeAll(['Hel', 'lo', "\n"]);
+    $stdin->writeAll([]);
+    $stdin->writeAll(['World', ' ', ':)']);
+} finally {
+    $stdin->close();
+}
+
+var_dump($process->join());
+
+--EXPECT--
+string(33) "Chunks must be strings, int given"
+string(5) "Hello"
+string(8) "World :)"
+string(12) "STDIN CLOSED"
+int(0)
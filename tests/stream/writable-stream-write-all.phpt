@@ -0,0 +1,30 @@
+--TEST--
+Writable memory stream can write multiple chunks at once.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Stream;
+
+$stream = new WritableMemoryStream();
+
+$stream->writeAll(['foo', '', 'bar']);
+var_dump($stream->getContents());
+
+$stream->writeAll([]);
+var_dump($stream->getContents());
+
+try {
+    $stream->writeAll(['baz', 123]);
+} catch (\TypeError $e) {
+    var_dump($e->getMessage());
+}
+
+var_dump($stream->getContents());
+
+--EXPECT--
+string(6) "foobar"
+string(6) "foobar"
+string(33) "Chunks must be strings, int given"
+string(6) "foobar"
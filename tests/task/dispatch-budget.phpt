@@ -0,0 +1,62 @@
+--TEST--
+Task scheduler limits the number of tasks dispatched per loop iteration.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.dispatch_budget=2
+async.dispatch_stats=1
+--FILE--
+<?php
+
+namespace Concurrent;
+
+TaskScheduler::run(function () {
+    for ($i = 0; $i < 5; $i++) {
+        Task::async(function () use ($i) {
+            var_dump($i);
+        });
+    }
+
+    Task::async(function () {
+        $stats = TaskScheduler::getStats()['dispatch'];
+
+        var_dump($stats['budget']);
+        var_dump($stats['tracked']);
+        var_dump($stats['ready']);
+        var_dump($stats['max_ready'] >= 6);
+        var_dump($stats['dispatched'] >= 6);
+        var_dump($stats['exhausted'] >= 2);
+        var_dump(array_keys($stats['wait_histogram']));
+        var_dump(array_sum($stats['wait_histogram']) >= 6);
+    });
+});
+
+--EXPECT--
+int(0)
+int(1)
+int(2)
+int(3)
+int(4)
+int(2)
+bool(true)
+int(0)
+bool(true)
+bool(true)
+bool(true)
+array(7) {
+  [0]=>
+  string(4) "10us"
+  [1]=>
+  string(5) "100us"
+  [2]=>
+  string(3) "1ms"
+  [3]=>
+  string(4) "10ms"
+  [4]=>
+  string(5) "100ms"
+  [5]=>
+  string(2) "1s"
+  [6]=>
+  string(3) "inf"
+}
+bool(true)
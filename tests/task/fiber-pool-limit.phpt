@@ -0,0 +1,35 @@
+--TEST--
+Fiber pool keeps fibers and VM stacks up to the configured limit.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.fiber_pool=1
+--FILE--
+<?php
+
+namespace Concurrent;
+
+TaskScheduler::run(function () {
+    $defer = new Deferred();
+
+    for ($i = 0; $i < 2; $i++) {
+        Task::async(function () use ($defer) {
+            Task::await($defer->awaitable());
+        });
+    }
+
+    Task::async(function () use ($defer) {
+        $defer->resolve();
+
+        $stats = TaskScheduler::getStats()['fiber_pool'];
+
+        var_dump($stats['size']);
+        var_dump($stats['vm_stacks']);
+        var_dump($stats['discarded']);
+    });
+});
+
+--EXPECT--
+int(1)
+int(1)
+int(1)
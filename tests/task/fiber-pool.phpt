@@ -0,0 +1,33 @@
+--TEST--
+Task scheduler reuses fibers of terminated tasks.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.fiber_pool=2
+--FILE--
+<?php
+
+namespace Concurrent;
+
+TaskScheduler::run(function () {
+    for ($i = 0; $i < 3; $i++) {
+        Task::async(function () {});
+    }
+
+    Task::async(function () {
+        $stats = TaskScheduler::getStats()['fiber_pool'];
+
+        var_dump($stats['shared']);
+        var_dump($stats['max_size']);
+        var_dump($stats['hits']);
+        var_dump($stats['misses']);
+        var_dump($stats['size']);
+    });
+});
+
+--EXPECT--
+bool(false)
+int(2)
+int(3)
+int(1)
+int(0)
@@ -0,0 +1,35 @@
+--TEST--
+Task scheduler ages lower priority tasks to prevent starvation.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.priority_aging=2
+--FILE--
+<?php
+
+namespace Concurrent;
+
+TaskScheduler::run(function () {
+    Task::asyncWithContext(Context::current()->withPriority(Task::PRIORITY_LOW), function () {
+        var_dump('L1');
+    });
+
+    $high = Context::current()->withPriority(Task::PRIORITY_HIGH);
+
+    for ($i = 1; $i <= 5; $i++) {
+        Task::asyncWithContext($high, function () use ($i) {
+            var_dump('H' . $i);
+        });
+    }
+});
+
+var_dump(TaskScheduler::getStats()['dispatch']['priority_aging']);
+
+--EXPECT--
+string(2) "H1"
+string(2) "H2"
+string(2) "L1"
+string(2) "H3"
+string(2) "H4"
+string(2) "H5"
+int(2)
@@ -0,0 +1,55 @@
+--TEST--
+Task scheduler dispatches ready tasks by priority.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+var_dump(Context::current()->getPriority() == Task::PRIORITY_NORMAL);
+
+try {
+    Context::current()->withPriority(7);
+} catch (\Error $e) {
+    var_dump($e->getMessage());
+}
+
+TaskScheduler::run(function () {
+    $low = Context::current()->withPriority(Task::PRIORITY_LOW);
+    $high = Context::current()->withPriority(Task::PRIORITY_HIGH);
+
+    Task::asyncWithContext($low, function () {
+        var_dump('L1');
+    });
+
+    Task::asyncWithContext($low, function () {
+        var_dump('L2');
+    });
+
+    Task::async(function () {
+        var_dump('N1');
+    });
+
+    Task::asyncWithContext($high, function () {
+        var_dump('H1');
+
+        Task::async(function () {
+            var_dump(Context::current()->getPriority() == Task::PRIORITY_HIGH);
+        });
+    });
+
+    Task::asyncWithContext($high->withIsolatedOutput(), function () {
+        var_dump('H2');
+    });
+});
+
+--EXPECT--
+bool(true)
+string(24) "Invalid task priority: 7"
+string(2) "H1"
+string(2) "H2"
+bool(true)
+string(2) "N1"
+string(2) "L1"
+string(2) "L2"
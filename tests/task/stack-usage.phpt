@@ -0,0 +1,42 @@
+--TEST--
+Task scheduler tracks C stack usage of terminated tasks.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (PHP_OS_FAMILY !== 'Linux') {
+    die('skip Stack usage tracking requires mincore()');
+}
+?>
+--INI--
+async.stack_usage=1
+--FILE--
+<?php
+
+namespace Concurrent;
+
+TaskScheduler::run(function () {
+    $t = Task::async(function () {
+        return 123;
+    });
+
+    Task::async(function () use ($t) {
+        var_dump(preg_match('/\[stack_usage\] => ([0-9]+)/', print_r($t, true), $m));
+        var_dump($m[1] > 0);
+
+        $stats = TaskScheduler::getStats()['stack'];
+
+        var_dump($stats['tracked']);
+        var_dump($stats['samples']);
+        var_dump($stats['max_usage'] > 0);
+        var_dump($stats['max_usage'] <= $stats['size']);
+    });
+});
+
+--EXPECT--
+int(1)
+bool(true)
+bool(true)
+int(1)
+bool(true)
+bool(true)
@@ -0,0 +1,57 @@
+--TEST--
+TCP socket read buffers grow with buffered data and are released when drained.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.direct_read=0
+async.read_buffer=4096
+async.read_buffer_max=65536
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+list ($a, $b) = TcpSocket::pair();
+
+$data = '';
+
+for ($i = 0; $i < 20000; $i++) {
+    $data .= sprintf('%08X', $i * 7919);
+}
+
+Task::async(function (TcpSocket $socket) use ($data) {
+    try {
+        $socket->write($data);
+    } finally {
+        $socket->close();
+    }
+}, $a);
+
+$received = '';
+
+try {
+    while (null !== ($chunk = $b->read(100))) {
+        $received .= $chunk;
+    }
+
+    $stats = TaskScheduler::getStats()['buffers'];
+} finally {
+    $b->close();
+}
+
+var_dump($received === $data);
+var_dump($stats['min_size'], $stats['max_size']);
+var_dump($stats['grown'] > 0);
+var_dump($stats['peak_memory'] > 4096 && $stats['peak_memory'] <= 65536);
+var_dump($stats['memory']);
+
+--EXPECT--
+bool(true)
+int(4096)
+int(65536)
+bool(true)
+bool(true)
+int(0)
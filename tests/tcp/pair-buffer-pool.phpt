@@ -0,0 +1,51 @@
+--TEST--
+TCP sockets share pooled read buffers of the task scheduler.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.buffer_pool=65536
+async.read_buffer=8192
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\TaskScheduler;
+
+$pairs = [];
+
+for ($i = 0; $i < 10; $i++) {
+    $pairs[] = TcpSocket::pair();
+}
+
+$received = 0;
+
+for ($j = 0; $j < 3; $j++) {
+    foreach ($pairs as $i => list ($a, $b)) {
+        $a->write("ping $i.$j");
+
+        if ($b->read() === "ping $i.$j") {
+            $received++;
+        }
+    }
+}
+
+$stats = TaskScheduler::getStats()['buffers'];
+
+foreach ($pairs as list ($a, $b)) {
+    $a->close();
+    $b->close();
+}
+
+var_dump($received);
+var_dump($stats['count'], $stats['memory']);
+var_dump($stats['pooled'], $stats['max_pooled']);
+var_dump($stats['hits'] > $stats['misses']);
+
+--EXPECT--
+int(30)
+int(0)
+int(0)
+int(8192)
+int(65536)
+bool(true)
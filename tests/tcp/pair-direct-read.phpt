@@ -0,0 +1,48 @@
+--TEST--
+TCP socket pair reads large chunks directly into returned strings.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.direct_read=1024
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+list ($a, $b) = TcpSocket::pair();
+
+$data = '';
+
+for ($i = 0; $i < 20000; $i++) {
+    $data .= sprintf('%08X', $i * 7919);
+}
+
+Task::async(function (TcpSocket $socket) use ($data) {
+    try {
+        foreach (str_split($data, 3000) as $chunk) {
+            $socket->write($chunk);
+        }
+    } finally {
+        $socket->close();
+    }
+}, $a);
+
+$received = '';
+$i = 0;
+
+try {
+    while (null !== ($chunk = $b->read((++$i % 2) ? 100 : 65536))) {
+        $received .= $chunk;
+    }
+} finally {
+    $b->close();
+}
+
+var_dump(strlen($received));
+var_dump($received === $data);
+
+--EXPECT--
+int(160000)
+bool(true)
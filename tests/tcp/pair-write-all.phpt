@@ -0,0 +1,67 @@
+--TEST--
+TCP socket pair supports vectored and gathered writes.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+list ($a, $b) = TcpSocket::pair();
+
+$expected = '';
+
+Task::async(function (TcpSocket $socket) use (&$expected) {
+    try {
+        $chunks = [];
+
+        for ($i = 0; $i < 2000; $i++) {
+            $chunks[] = sprintf('[%d]', $i);
+        }
+
+        $socket->writeAll($chunks);
+        $expected .= implode('', $chunks);
+
+        // Queue writes from multiple tasks while the socket is busy to have them combined.
+        $big = str_repeat('X', 1024 * 1024);
+        $tasks = [];
+
+        for ($i = 0; $i < 10; $i++) {
+            $tasks[] = Task::async(function () use ($socket, $i) {
+                $socket->write("<$i>");
+            });
+        }
+
+        $socket->getWritableStream()->writeAll([$big, 'A']);
+        $expected .= $big . 'A';
+
+        for ($i = 0; $i < 10; $i++) {
+            $expected .= "<$i>";
+        }
+
+        foreach ($tasks as $task) {
+            Task::await($task);
+        }
+    } finally {
+        $socket->close();
+    }
+}, $a);
+
+$received = '';
+
+try {
+    while (null !== ($chunk = $b->read())) {
+        $received .= $chunk;
+    }
+} finally {
+    $b->close();
+}
+
+var_dump(strlen($received) == strlen($expected));
+var_dump($received === $expected);
+
+--EXPECT--
+bool(true)
+bool(true)
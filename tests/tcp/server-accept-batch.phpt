@@ -0,0 +1,91 @@
+--TEST--
+TCP server accepts all queued connections in a batch.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (PHP_OS_FAMILY === 'Windows') {
+    die('skip Windows reports queued connections one at a time');
+}
+?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+$server = TcpServer::listen('127.0.0.1', 0);
+
+try {
+    $port = $server->getPort();
+    
+    try {
+        $server->acceptBatch(0);
+    } catch (\Throwable $e) {
+        var_dump($e->getMessage());
+    }
+    
+    $clients = Task::await(Task::async(function () use ($port) {
+        $clients = [];
+        
+        for ($i = 0; $i < 5; $i++) {
+            $clients[] = TcpSocket::connect('127.0.0.1', $port);
+        }
+        
+        return $clients;
+    }));
+    
+    $sockets = $server->acceptBatch(2);
+    var_dump(count($sockets));
+    
+    $sockets = array_merge($sockets, $server->acceptBatch());
+    var_dump(count($sockets));
+    
+    $ports = array_map(function (TcpSocket $socket) {
+        return $socket->getPort();
+    }, $clients);
+    
+    foreach ($sockets as $socket) {
+        var_dump($socket->getRemoteAddress());
+        var_dump(in_array($socket->getRemotePort(), $ports, true));
+        var_dump($socket->getPort() == $port);
+    }
+    
+    Task::async(function () use ($clients) {
+        $clients[4]->write('Hello');
+    });
+    
+    foreach ($sockets as $socket) {
+        if ($socket->getRemotePort() == $clients[4]->getPort()) {
+            var_dump($socket->read());
+        }
+    }
+    
+    foreach (array_merge($clients, $sockets) as $socket) {
+        $socket->close();
+    }
+} finally {
+    $server->close();
+}
+
+--EXPECT--
+string(29) "Batch size must be at least 1"
+int(2)
+int(5)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(5) "Hello"
@@ -0,0 +1,63 @@
+--TEST--
+TCP servers can share a port using SO_REUSEPORT and a custom backlog.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (PHP_OS_FAMILY === 'Windows') {
+    die('skip SO_REUSEPORT is not supported on Windows');
+}
+?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+try {
+    TcpServer::listen('127.0.0.1', 0, null, true, 0);
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+$a = TcpServer::listen('127.0.0.1', 0, null, true, 16);
+$port = $a->getPort();
+
+$b = TcpServer::listen('127.0.0.1', $port, null, true, 16);
+
+var_dump($b->getPort() == $port);
+
+foreach ([$a, $b] as $server) {
+    Task::async(function () use ($server) {
+        try {
+            $socket = $server->accept();
+        } catch (SocketException $e) {
+            return;
+        }
+        
+        try {
+            $socket->write($socket->read());
+        } finally {
+            $socket->close();
+        }
+    });
+}
+
+$socket = TcpSocket::connect('127.0.0.1', $port);
+
+try {
+    $socket->write('Hello');
+    
+    var_dump($socket->read());
+} finally {
+    $socket->close();
+}
+
+$a->close();
+$b->close();
+
+--EXPECT--
+string(40) "Backlog must be between 1 and 2147483647"
+bool(true)
+string(5) "Hello"
@@ -0,0 +1,52 @@
+--TEST--
+TCP TLS streams pack queued small writes into records without reordering data.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+require __DIR__ . '/assets/sslpair.php';
+
+list ($a, $b) = sslpair();
+
+$count = 500;
+$expected = '';
+
+for ($i = 0; $i < $count; $i++) {
+    $expected .= "[$i]" . str_repeat(chr(65 + $i % 26), $i % 97);
+}
+
+Task::async(function (TcpSocket $socket) use ($count) {
+    try {
+        $socket->write(str_repeat('-', 100000));
+        
+        for ($i = 0; $i < $count; $i++) {
+            Task::async([$socket, 'write'], "[$i]" . str_repeat(chr(65 + $i % 26), $i % 97));
+        }
+        
+        $socket->flush();
+    } finally {
+        $socket->close();
+    }
+}, $a);
+
+$received = '';
+
+try {
+    while (null !== ($chunk = $b->read())) {
+        $received .= $chunk;
+    }
+} finally {
+    $b->close();
+}
+
+var_dump(strlen($received));
+var_dump(substr($received, 100000) === $expected);
+
+--EXPECT--
+int(125775)
+bool(true)
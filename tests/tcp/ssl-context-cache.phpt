@@ -0,0 +1,71 @@
+--TEST--
+TCP socket SSL clients share contexts with matching settings.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    Task::async(function () use ($host, $port) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName('localhost');
+        $tls = $tls->withAllowSelfSigned(true);
+        
+        foreach ([$tls, $tls, $tls->withVerifyDepth(3), $tls->withAllowSelfSigned(true)] as $encryption) {
+            $socket = TcpSocket::connect($host, $port, $encryption);
+            
+            try {
+                $socket->encrypt();
+                
+                var_dump($socket->read());
+            } finally {
+                $socket->close();
+            }
+        }
+    });
+    
+    for ($i = 0; $i < 4; $i++) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            $socket->write('Hello');
+            
+            while (null !== $socket->read());
+        } finally {
+            $socket->close();
+        }
+    }
+} finally {
+    $server->close();
+}
+
+$stats = TaskScheduler::getStats()['tls'];
+
+var_dump($stats['contexts']);
+var_dump($stats['context_hits']);
+var_dump($stats['context_misses']);
+
+--EXPECT--
+string(5) "Hello"
+string(5) "Hello"
+string(5) "Hello"
+string(5) "Hello"
+int(2)
+int(2)
+int(2)
@@ -0,0 +1,79 @@
+--TEST--
+TCP socket SSL connections fall back to userspace encryption if kernel TLS cannot be used.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (!ASYNC_SSL_KTLS_SUPPORTED) {
+    die('skip Async extension was compiled without kernel TLS support');
+}
+?>
+--INI--
+async.ktls=1
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+try {
+    (new TlsServerEncryption())->withMaxVersion('SSLv3');
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    $client = Task::async(function () use ($host, $port) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName('localhost');
+        $tls = $tls->withAllowSelfSigned(true);
+        $tls = $tls->withMaxVersion('TLSv1.3');
+        
+        $socket = TcpSocket::connect($host, $port, $tls);
+        
+        try {
+            var_dump($socket->encrypt()->protocol);
+            
+            $socket->write('Hello');
+            
+            return $socket->read();
+        } finally {
+            $socket->close();
+        }
+    });
+    
+    Task::await(Task::async(function () use ($server) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            $socket->write(strrev($socket->read()));
+        } finally {
+            $socket->close();
+        }
+    }));
+    
+    var_dump(Task::await($client));
+} finally {
+    $server->close();
+}
+
+var_dump(TaskScheduler::getStats()['tls']['ktls']);
+
+--EXPECT--
+string(39) "Unsupported TLS protocol version: SSLv3"
+string(7) "TLSv1.3"
+string(5) "olleH"
+int(0)
@@ -0,0 +1,99 @@
+--TEST--
+TCP socket SSL connections hand TLS 1.2 record encryption over to the kernel.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (!ASYNC_SSL_KTLS_SUPPORTED) {
+    die('skip Async extension was compiled without kernel TLS support');
+}
+
+if (version_compare(preg_replace('/[^0-9.].*$/', '', php_uname('r')), '5.1', '<')) {
+    die('skip Kernel TLS with AES-256-GCM requires Linux 5.1');
+}
+
+if (!preg_match('/\btls\b/', (string) @file_get_contents('/proc/sys/net/ipv4/tcp_available_ulp'))) {
+    die('skip TLS upper layer protocol is not available');
+}
+?>
+--INI--
+async.ktls=1
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+$tls = $tls->withMaxVersion('TLSv1.2');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+$payload = str_repeat('A', 100000);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    $client = Task::async(function () use ($host, $port, $payload) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName('localhost');
+        $tls = $tls->withAllowSelfSigned(true);
+        
+        $socket = TcpSocket::connect($host, $port, $tls);
+        
+        try {
+            var_dump($socket->encrypt()->protocol);
+            
+            $socket->write($payload);
+            
+            $received = '';
+            
+            while (null !== ($chunk = $socket->read())) {
+                $received .= $chunk;
+            }
+            
+            return $received;
+        } finally {
+            $socket->close();
+        }
+    });
+    
+    Task::await(Task::async(function () use ($server, $payload) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            
+            $received = '';
+            
+            while (strlen($received) < strlen($payload) && null !== ($chunk = $socket->read())) {
+                $received .= $chunk;
+            }
+            
+            $socket->write(strrev($received . 'B'));
+        } finally {
+            $socket->close();
+        }
+    }));
+    
+    $received = Task::await($client);
+    
+    var_dump(strlen($received));
+    var_dump($received === strrev($payload . 'B'));
+} finally {
+    $server->close();
+}
+
+var_dump(TaskScheduler::getStats()['tls']['ktls']);
+
+--EXPECT--
+string(7) "TLSv1.2"
+int(100001)
+bool(true)
+int(2)
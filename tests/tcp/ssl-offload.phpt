@@ -0,0 +1,74 @@
+--TEST--
+TCP socket SSL handshakes can be offloaded to the thread pool.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (!ASYNC_SSL_OFFLOAD_SUPPORTED) {
+    die('skip Async extension was compiled against an OpenSSL version that does not support offloading');
+}
+?>
+--INI--
+async.tls_offload=1
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    $client = Task::async(function () use ($host, $port) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName('localhost');
+        $tls = $tls->withAllowSelfSigned(true);
+        
+        $socket = TcpSocket::connect($host, $port, $tls);
+        
+        try {
+            $socket->encrypt();
+            
+            return $socket->read();
+        } finally {
+            $socket->close();
+        }
+    });
+    
+    Task::await(Task::async(function () use ($server) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            $socket->write('Hello');
+            
+            while (null !== $socket->read());
+        } finally {
+            $socket->close();
+        }
+    }));
+    
+    var_dump(Task::await($client));
+} finally {
+    $server->close();
+}
+
+$stats = TaskScheduler::getStats()['tls'];
+
+var_dump($stats['offloaded'] > 0);
+var_dump($stats['sessions']);
+
+--EXPECT--
+string(5) "Hello"
+bool(true)
+int(1)
@@ -0,0 +1,80 @@
+--TEST--
+TCP socket SSL connections resume previous sessions.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+use Concurrent\TaskScheduler;
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+$tls = $tls->withSessionCache(100, 60);
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    Task::async(function () use ($host, $port) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName('localhost');
+        $tls = $tls->withAllowSelfSigned(true);
+        
+        for ($i = 0; $i < 3; $i++) {
+            $socket = TcpSocket::connect($host, $port, $tls);
+            
+            try {
+                $info = $socket->encrypt();
+                
+                var_dump($socket->read());
+                var_dump($info->session_reused);
+            } finally {
+                $socket->close();
+            }
+        }
+    });
+    
+    for ($i = 0; $i < 3; $i++) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            $socket->write('Hello');
+            
+            while (null !== $socket->read());
+        } finally {
+            $socket->close();
+        }
+    }
+} finally {
+    $server->close();
+}
+
+print_r(TaskScheduler::getStats()['tls']);
+
+--EXPECT--
+string(5) "Hello"
+bool(false)
+string(5) "Hello"
+bool(true)
+string(5) "Hello"
+bool(true)
+Array
+(
+    [sessions] => 1
+    [contexts] => 1
+    [client_hits] => 2
+    [client_misses] => 1
+    [server_hits] => 2
+    [server_misses] => 1
+    [context_hits] => 2
+    [context_misses] => 1
+    [offloaded] => 0
+)
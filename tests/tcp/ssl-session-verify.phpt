@@ -0,0 +1,69 @@
+--TEST--
+TCP socket SSL sessions are not resumed by connections using stricter verification settings.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+$file = dirname(__DIR__, 2) . '/examples/cert/localhost.';
+
+$tls = new TlsServerEncryption();
+$tls = $tls->withDefaultCertificate($file . 'pem', null, 'localhost');
+$tls = $tls->withSessionCache(100, 60);
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    Task::async(function () use ($host, $port) {
+        $strict = new TlsClientEncryption();
+        $strict = $strict->withPeerName('localhost');
+        
+        $lax = $strict->withAllowSelfSigned(true);
+        
+        foreach ([$lax, $strict, $lax] as $tls) {
+            $socket = TcpSocket::connect($host, $port, $tls);
+            
+            try {
+                $info = $socket->encrypt();
+                
+                var_dump($socket->read());
+                var_dump($info->session_reused);
+            } catch (SocketException $e) {
+                var_dump($e->getMessage());
+            } finally {
+                $socket->close();
+            }
+        }
+    });
+    
+    for ($i = 0; $i < 3; $i++) {
+        $socket = $server->accept();
+        
+        try {
+            $socket->encrypt();
+            $socket->write('Hello');
+            
+            while (null !== $socket->read());
+        } catch (SocketException $e) {
+            // Handshake is aborted by the client.
+        } finally {
+            $socket->close();
+        }
+    }
+} finally {
+    $server->close();
+}
+
+--EXPECTF--
+string(5) "Hello"
+bool(false)
+string(%d) "SSL handshake failed %s"
+string(5) "Hello"
+bool(true)
@@ -0,0 +1,86 @@
+--TEST--
+TCP server selects SNI certificates by host name including wildcards and supports replacing them.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+use Concurrent\Task;
+
+function handshake(TcpServer $server, string $peer): string
+{
+    $host = $server->getAddress();
+    $port = $server->getPort();
+    
+    $client = Task::async(function () use ($host, $port, $peer) {
+        $tls = new TlsClientEncryption();
+        $tls = $tls->withPeerName($peer);
+        $tls = $tls->withAllowSelfSigned(true);
+        
+        $socket = TcpSocket::connect($host, $port, $tls);
+        
+        try {
+            $socket->encrypt();
+            
+            return $socket->read();
+        } finally {
+            $socket->close();
+        }
+    });
+    
+    $socket = $server->accept();
+    
+    try {
+        $socket->encrypt();
+        $socket->write($peer);
+    } finally {
+        $socket->close();
+    }
+    
+    return Task::await($client);
+}
+
+$tls = new TlsServerEncryption();
+
+foreach (['foo.*.com', '*example.com', 'www.*', '*.'] as $host) {
+    try {
+        $tls->withCertificate($host, __DIR__ . '/assets/wildcard.pem');
+    } catch (\Error $e) {
+        var_dump($e->getMessage());
+    }
+}
+
+$tls = $tls->withDefaultCertificate(dirname(__DIR__, 2) . '/examples/cert/localhost.pem', null, 'localhost');
+
+$server = TcpServer::listen('127.0.0.1', 0, $tls);
+
+try {
+    var_dump(handshake($server, 'localhost'));
+    
+    $server->setEncryption($tls->withCertificate('*.Example.com', __DIR__ . '/assets/wildcard.pem'));
+    
+    var_dump(handshake($server, 'foo.example.com'));
+    var_dump(handshake($server, 'BAR.example.com'));
+    var_dump(handshake($server, 'localhost'));
+} finally {
+    $server->close();
+}
+
+try {
+    TcpServer::listen('127.0.0.1', 0, $tls->withCertificate('*.example.com', __FILE__));
+} catch (SocketException $e) {
+    var_dump($e->getMessage());
+}
+
+--EXPECT--
+string(40) "Invalid certificate host name: foo.*.com"
+string(43) "Invalid certificate host name: *example.com"
+string(36) "Invalid certificate host name: www.*"
+string(33) "Invalid certificate host name: *."
+string(9) "localhost"
+string(15) "foo.example.com"
+string(15) "BAR.example.com"
+string(9) "localhost"
+string(48) "Failed to load certificate of host *.example.com"
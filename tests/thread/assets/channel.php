@@ -0,0 +1,16 @@
+<?php
+
+namespace Concurrent;
+
+$jobs = new ThreadChannel('test-jobs');
+$results = new ThreadChannel('test-results');
+
+try {
+    while (true) {
+        $job = $jobs->receive();
+        
+        $results->send([$job[0], $job[1] * 2]);
+    }
+} catch (ChannelClosedException $e) {
+    $results->send('DONE');
+}
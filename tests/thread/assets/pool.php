@@ -0,0 +1,13 @@
+<?php
+
+namespace Concurrent;
+
+function fib(int $n): int
+{
+    return ($n < 2) ? $n : fib($n - 1) + fib($n - 2);
+}
+
+function fail(string $message)
+{
+    throw new \RuntimeException($message);
+}
@@ -0,0 +1,74 @@
+--TEST--
+Thread channel transfers messages between threads.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$jobs = new ThreadChannel('test-jobs', 2);
+$results = new ThreadChannel('test-results', 2);
+
+var_dump($jobs->getName());
+var_dump($jobs->isClosed());
+
+$threads = [
+    new Thread(__DIR__ . '/assets/channel.php'),
+    new Thread(__DIR__ . '/assets/channel.php')
+];
+
+Task::async(function () use ($jobs) {
+    for ($i = 0; $i < 10; $i++) {
+        $jobs->send(['job', $i]);
+    }
+    
+    $jobs->close();
+});
+
+$sum = 0;
+$done = 0;
+
+while ($done < count($threads)) {
+    $result = $results->receive();
+    
+    if ($result === 'DONE') {
+        $done++;
+    } else {
+        $sum += $result[1];
+    }
+}
+
+var_dump($sum);
+var_dump($jobs->isClosed());
+
+foreach ($threads as $thread) {
+    $thread->join();
+}
+
+try {
+    $jobs->send('X');
+} catch (ChannelClosedException $e) {
+    var_dump($e->getMessage());
+}
+
+try {
+    $results->send(function () {});
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+try {
+    new ThreadChannel('test', 0);
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+--EXPECT--
+string(9) "test-jobs"
+bool(false)
+int(90)
+bool(true)
+string(23) "Channel has been closed"
+string(41) "Serialization of 'Closure' is not allowed"
+string(44) "Channel capacity must be between 1 and 65536"
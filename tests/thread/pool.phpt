@@ -0,0 +1,61 @@
+--TEST--
+Thread pool executes jobs in worker threads.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$pool = new ThreadPool(__DIR__ . '/assets/pool.php', 2);
+
+var_dump($pool->getSize());
+var_dump($pool->submit('Concurrent\fib', 10));
+
+$tasks = [];
+
+for ($i = 0; $i < 4; $i++) {
+    $tasks[] = Task::async([$pool, 'submit'], 'Concurrent\fib', 20);
+}
+
+foreach ($tasks as $task) {
+    var_dump(Task::await($task));
+}
+
+try {
+    $pool->submit('Concurrent\fail', 'Boom');
+} catch (JobFailedException $e) {
+    var_dump($e->getMessage());
+}
+
+try {
+    $pool->submit('Concurrent\missing');
+} catch (JobFailedException $e) {
+    var_dump($e->getMessage());
+}
+
+try {
+    $pool->submit('Concurrent\fib', function () {});
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+$pool->close();
+
+try {
+    $pool->submit('Concurrent\fib', 1);
+} catch (\Throwable $e) {
+    var_dump($e->getMessage());
+}
+
+--EXPECTF--
+int(2)
+int(55)
+int(6765)
+int(6765)
+int(6765)
+int(6765)
+string(53) "Job Concurrent\fail failed with RuntimeException: Boom"
+string(%d) "Job Concurrent\missing is not callable: %s"
+string(%d) "Serialization of 'Closure' is not allowed"
+string(27) "Thread pool has been closed"
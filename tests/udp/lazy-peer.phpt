@@ -0,0 +1,58 @@
+--TEST--
+UDP datagram peer address is resolved when it is accessed.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+$a = UdpSocket::bind('127.0.0.1', 0);
+$b = UdpSocket::bind('127.0.0.1', 0);
+$c = UdpSocket::bind('127.0.0.1', 0);
+
+try {
+    $b->send(new UdpDatagram('B', '127.0.0.1', $a->getPort()));
+    $c->send(new UdpDatagram('C', '127.0.0.1', $a->getPort()));
+    
+    $received = [$a->receive(), $a->receive()];
+    $ports = ['B' => $b->getPort(), 'C' => $c->getPort()];
+    
+    // Same opline for both datagrams, a cached property offset must not skip resolution.
+    foreach ($received as $datagram) {
+        var_dump($datagram->address);
+        var_dump($datagram->port == $ports[$datagram->data]);
+    }
+    
+    $b->send(new UdpDatagram('B', '127.0.0.1', $a->getPort()));
+    
+    $datagram = $a->receive();
+    
+    var_dump(isset($datagram->address));
+    
+    $b->send(new UdpDatagram('B', '127.0.0.1', $a->getPort()));
+    
+    // Reply without accessing the peer address of the received datagram.
+    $a->send($a->receive()->withData('REPLY'));
+    
+    $reply = $b->receive();
+    
+    var_dump($reply->data);
+    var_dump($reply->port == $a->getPort());
+    
+    var_dump($datagram->withData('COPY')->port == $b->getPort());
+} finally {
+    $a->close();
+    $b->close();
+    $c->close();
+}
+
+--EXPECT--
+string(9) "127.0.0.1"
+bool(true)
+string(9) "127.0.0.1"
+bool(true)
+bool(true)
+string(5) "REPLY"
+bool(true)
+bool(true)
@@ -0,0 +1,57 @@
+--TEST--
+UDP socket receives all queued datagrams in a batch.
+--SKIPIF--
+<?php
+require __DIR__ . '/skipif.inc';
+
+if (PHP_OS_FAMILY === 'Windows') {
+    die('skip Windows reports queued datagrams one at a time');
+}
+?>
+--FILE--
+<?php
+
+namespace Concurrent\Network;
+
+$a = UdpSocket::bind('127.0.0.1', 0);
+$b = UdpSocket::bind('127.0.0.1', 0);
+
+try {
+    try {
+        $a->receiveBatch(0);
+    } catch (\Throwable $e) {
+        var_dump($e->getMessage());
+    }
+    
+    for ($i = 0; $i < 5; $i++) {
+        $b->send(new UdpDatagram((string) $i, '127.0.0.1', $a->getPort()));
+    }
+    
+    $received = $a->receiveBatch(2);
+    var_dump(count($received));
+    
+    $received = array_merge($received, $a->receiveBatch());
+    var_dump(count($received));
+    
+    foreach ($received as $datagram) {
+        var_dump($datagram->data, $datagram->port == $b->getPort());
+    }
+} finally {
+    $a->close();
+    $b->close();
+}
+
+--EXPECT--
+string(29) "Batch size must be at least 1"
+int(2)
+int(5)
+string(1) "0"
+bool(true)
+string(1) "1"
+bool(true)
+string(1) "2"
+bool(true)
+string(1) "3"
+bool(true)
+string(1) "4"
+bool(true)
@@ -0,0 +1,52 @@
+--TEST--
+Timers, timeouts and context deadlines share the timer wheel of the task scheduler.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.timer_granularity=10
+--FILE--
+<?php
+
+namespace Concurrent;
+
+$time = microtime(true);
+$timeout = Timer::timeout(5000);
+
+Task::async(function () {
+    (new Timer(5))->awaitTimeout();
+    var_dump('B');
+});
+
+Task::asyncWithContext(Context::current()->withTimeout(15), function () {
+    try {
+        (new Timer(1000))->awaitTimeout();
+    } catch (CancellationException $e) {
+        var_dump('C');
+    }
+});
+
+$stats = TaskScheduler::getStats()['timers'];
+
+var_dump($stats['granularity']);
+var_dump($stats['active']);
+
+(new Timer(40))->awaitTimeout();
+
+var_dump('A');
+var_dump((microtime(true) - $time) >= 0.04);
+
+$timeout = null;
+$stats = TaskScheduler::getStats()['timers'];
+
+var_dump($stats['active']);
+var_dump($stats['expired']);
+
+--EXPECT--
+int(10)
+int(2)
+string(1) "B"
+string(1) "C"
+string(1) "A"
+bool(true)
+int(0)
+int(3)
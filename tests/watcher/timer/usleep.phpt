@@ -0,0 +1,37 @@
+--TEST--
+Usleep and time_nanosleep functions are replaced with async versions.
+--SKIPIF--
+<?php require __DIR__ . '/skipif.inc'; ?>
+--INI--
+async.timer=1
+--FILE--
+<?php
+
+namespace Concurrent;
+
+Task::async(function () {
+    var_dump(usleep(20000));
+    var_dump('A');
+    var_dump(time_nanosleep(0, 40000000));
+    var_dump('C');
+});
+
+Task::async(function () {
+    usleep(40000);
+    var_dump('B');
+});
+
+var_dump(usleep(-1));
+var_dump(time_nanosleep(0, -1));
+
+--EXPECTF--
+Warning: usleep(): Number of microseconds must be greater than or equal to 0 in %s on line %d
+bool(false)
+
+Warning: time_nanosleep(): The nanoseconds value must be greater than 0 in %s on line %d
+bool(false)
+NULL
+string(1) "A"
+string(1) "B"
+bool(true)
+string(1) "C"